@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+* Minimal stand-in for the parts of Geode and cocos2d that the data/ layer, the interpolator and the packet capture depend on, so they can be built without Geode.
+* Logging is a no-op and only the cocos2d value types are provided. Don't include anything that touches the game from here.
+*/
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace fmt {
+    template <typename... Args>
+    using format_string = std::string_view;
+
+    // only enough to format the failure messages of GLOBED_REQUIRE, every {} is replaced with the next argument
+    template <typename... Args>
+    std::string format(std::string_view fmtstr, Args&&... args) {
+        std::ostringstream out;
+        size_t pos = 0;
+
+        auto next = [&](const auto& arg) {
+            auto found = fmtstr.find("{}", pos);
+            if (found == std::string_view::npos) return;
+
+            out << fmtstr.substr(pos, found - pos) << arg;
+            pos = found + 2;
+        };
+
+        (next(args), ...);
+        out << fmtstr.substr(pos);
+
+        return out.str();
+    }
+}
+
+namespace geode {
+    namespace log {
+        template <typename... Args> void debug(Args&&...) {}
+        template <typename... Args> void info(Args&&...) {}
+        template <typename... Args> void warn(Args&&...) {}
+        template <typename... Args> void error(Args&&...) {}
+    }
+
+    template <typename T>
+    struct OkValue { T value; };
+
+    template <>
+    struct OkValue<void> {};
+
+    struct ErrValue { std::string message; };
+
+    template <typename T = void, typename E = std::string>
+    class Result {
+    public:
+        template <typename U>
+        Result(OkValue<U> ok) : value(std::move(ok.value)) {}
+        Result(OkValue<void>) requires std::is_void_v<T> {}
+        Result(ErrValue err) : error(std::move(err.message)) {}
+
+        bool isOk() const { return !error.has_value(); }
+        bool isErr() const { return error.has_value(); }
+        E unwrapErr() const { return error.value(); }
+
+        template <typename U = T> requires (!std::is_void_v<U>)
+        U unwrap() const { return value.value(); }
+
+    private:
+        std::optional<std::conditional_t<std::is_void_v<T>, char, T>> value;
+        std::optional<E> error;
+    };
+
+    inline OkValue<void> Ok() { return {}; }
+
+    template <typename T>
+    OkValue<std::decay_t<T>> Ok(T&& value) { return { std::forward<T>(value) }; }
+
+    template <typename T>
+    ErrValue Err(T&& message) { return { std::string(std::forward<T>(message)) }; }
+
+    template <typename T>
+    class Ref {};
+
+    class Loader {};
+    class Mod {};
+
+    namespace utils::thread {
+        inline void setName(std::string_view) {}
+    }
+
+    namespace cocos {
+        template <typename T>
+        class CCArrayExt {};
+    }
+
+    namespace cast {
+        template <typename T, typename U>
+        T typeinfo_cast(U) { return nullptr; }
+    }
+}
+
+namespace cocos2d {
+    struct CCPoint {
+        float x = 0.f, y = 0.f;
+
+        CCPoint() = default;
+        CCPoint(float x, float y) : x(x), y(y) {}
+
+        bool operator==(const CCPoint&) const = default;
+
+        CCPoint lerp(const CCPoint& other, float alpha) const {
+            return CCPoint(x + (other.x - x) * alpha, y + (other.y - y) * alpha);
+        }
+    };
+
+    struct ccColor3B {
+        uint8_t r, g, b;
+        bool operator==(const ccColor3B&) const = default;
+    };
+
+    struct ccColor4B {
+        uint8_t r, g, b, a;
+        bool operator==(const ccColor4B&) const = default;
+    };
+
+    inline ccColor3B ccc3(uint8_t r, uint8_t g, uint8_t b) { return { r, g, b }; }
+    inline ccColor4B ccc4(uint8_t r, uint8_t g, uint8_t b, uint8_t a) { return { r, g, b, a }; }
+}
+
+namespace geode::prelude {
+    using namespace ::geode;
+    using namespace ::cocos2d;
+}
+
+#define ccp(x, y) cocos2d::CCPoint(x, y)
@@ -0,0 +1,2 @@
+#pragma once
+// UIBuilder is not needed by anything in data/, this file only exists so that defs.hpp can be included.
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+* Only the constants and declarations that crypto/box.hpp needs, so that packet definitions can be included.
+* Nothing is encrypted outside of the game, and anything that actually calls these fails to link.
+* The sizes are the same as in libsodium.
+*/
+
+#define crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES 32U
+#define crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES 32U
+#define crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES 32U
+#define crypto_box_curve25519xchacha20poly1305_NONCEBYTES 24U
+#define crypto_box_curve25519xchacha20poly1305_MACBYTES 16U
+
+extern "C" {
+    int crypto_box_curve25519xchacha20poly1305_keypair(unsigned char* pk, unsigned char* sk);
+    int crypto_box_curve25519xchacha20poly1305_beforenm(unsigned char* k, const unsigned char* pk, const unsigned char* sk);
+    int crypto_box_curve25519xchacha20poly1305_easy_afternm(
+        unsigned char* c, const unsigned char* m, unsigned long long mlen, const unsigned char* n, const unsigned char* k
+    );
+    int crypto_box_curve25519xchacha20poly1305_open_easy_afternm(
+        unsigned char* m, const unsigned char* c, unsigned long long clen, const unsigned char* n, const unsigned char* k
+    );
+}
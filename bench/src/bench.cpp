@@ -0,0 +1,232 @@
+/*
+* Micro-benchmarks for the serialization layer. Run with an optional filter, only benchmarks containing it in the name are ran:
+*   ./globed-bench LevelData
+*/
+
+#include "samples.hpp"
+#include <data/packets/pool.hpp>
+#include <game/snapshot_history.hpp>
+#include <util/compression.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string_view>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    // keeps the compiler from optimizing away the work being measured
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    std::string_view filter;
+
+    // Runs `f` in growing batches until a batch takes at least 200ms, then prints and returns the time per call in nanoseconds.
+    // `bytes` is the amount of data processed per call, used for the throughput column.
+    template <typename F>
+    double bench(std::string_view name, size_t bytes, F&& f) {
+        if (!filter.empty() && name.find(filter) == std::string_view::npos) return 0.0;
+
+        // warm up caches and any buffers that get reused
+        for (size_t i = 0; i < 1000; i++) f();
+
+        size_t iterations = 1000;
+        while (true) {
+            auto start = clock::now();
+            for (size_t i = 0; i < iterations; i++) f();
+            auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+            if (elapsed >= 200'000'000.0) {
+                double perCall = elapsed / iterations;
+                double mbps = bytes / perCall * 1000.0; // bytes per ns -> MB/s
+
+                std::printf("%-52s %12.1f ns/op %10.1f MB/s %8zu B\n", std::string(name).c_str(), perCall, mbps, bytes);
+                return perCall;
+            }
+
+            iterations *= 2;
+        }
+    }
+
+    void benchPlayerData() {
+        auto data = samples::playerData(6);
+        ByteBuffer buf;
+
+        bench("PlayerData encode", data.encodedSize(), [&] {
+            buf.clear();
+            buf.writeValue(data);
+            doNotOptimize(buf.getDataRef().data());
+        });
+
+        buf.clear();
+        buf.writeValue(data);
+        auto encoded = buf.getDataRef();
+
+        bench("PlayerData decode", encoded.size(), [&] {
+            ByteReader reader(encoded);
+            auto out = reader.readValue<PlayerData>();
+            doNotOptimize(out);
+        });
+
+        PlayerDataPacket packet(1, data);
+        bench("PlayerDataPacket encode", packet.encodedSize(), [&] {
+            buf.clear();
+            packet.encode(buf);
+            doNotOptimize(buf.getDataRef().data());
+        });
+
+        bench("PlayerDataPacket create + encode", packet.encodedSize(), [&] {
+            auto created = PlayerDataPacket::create(1, data);
+            buf.clear();
+            created->encode(buf);
+            doNotOptimize(buf.getDataRef().data());
+        });
+    }
+
+    void benchLevelData(size_t players) {
+        auto encoded = samples::levelData(players);
+        auto suffix = " (" + std::to_string(players) + " players)";
+
+        LevelDataPacket packet;
+        bench("LevelDataPacket decode" + suffix, encoded.size(), [&] {
+            ByteReader reader(encoded);
+            packet.decode(reader);
+            doNotOptimize(packet.entries.data());
+        });
+
+        bench("LevelDataPacket pooled decode" + suffix, encoded.size(), [&] {
+            auto matched = PacketPool<LevelDataPacket>::get().acquireForDecode();
+            ByteReader reader(encoded);
+            matched->decode(reader);
+            doNotOptimize(matched.get());
+        });
+
+        // what every received packet used to cost before the pools
+        bench("LevelDataPacket make_shared decode" + suffix, encoded.size(), [&] {
+            auto matched = std::make_shared<LevelDataPacket>();
+            ByteReader reader(encoded);
+            matched->decode(reader);
+            doNotOptimize(matched.get());
+        });
+
+        LevelSnapshotHistory history;
+        std::vector<AssociatedPlayerData> out;
+        uint32_t sequence = 0;
+
+        bench("LevelDataPacket decode + apply" + suffix, encoded.size(), [&] {
+            ByteReader reader(encoded);
+            packet.decode(reader);
+            packet.sequence = ++sequence;
+            history.apply(packet, out);
+            doNotOptimize(out.data());
+        });
+    }
+
+    void benchPlayerProfiles(size_t players) {
+        auto encoded = samples::playerProfiles(players);
+        auto suffix = " (" + std::to_string(players) + " players)";
+
+        PlayerProfilesPacket packet;
+        bench("PlayerProfilesPacket decode" + suffix, encoded.size(), [&] {
+            ByteReader reader(encoded);
+            packet.decode(reader);
+            doNotOptimize(packet.players.data());
+        });
+    }
+
+    void benchVoiceBroadcast(size_t frames) {
+        auto encoded = samples::voiceBroadcast(frames);
+        auto suffix = " (" + std::to_string(frames) + " frames)";
+
+        VoiceBroadcastPacket packet;
+        bench("VoiceBroadcastPacket decode" + suffix, encoded.size(), [&] {
+            ByteReader reader(encoded);
+            packet.decode(reader);
+            doNotOptimize(packet.frame[0].data());
+        });
+
+        bench("VoiceBroadcastPacket pooled decode" + suffix, encoded.size(), [&] {
+            auto matched = PacketPool<VoiceBroadcastPacket>::get().acquireForDecode();
+            ByteReader reader(encoded);
+            matched->decode(reader);
+            doNotOptimize(matched.get());
+        });
+
+        bench("VoiceBroadcastPacket make_shared decode" + suffix, encoded.size(), [&] {
+            auto matched = std::make_shared<VoiceBroadcastPacket>();
+            ByteReader reader(encoded);
+            matched->decode(reader);
+            doNotOptimize(matched.get());
+        });
+    }
+
+    // `raw` is the uncompressed packet body, as the server would compress it
+    void benchCompression(const std::string& name, const util::data::bytevector& raw) {
+        using namespace util::compression;
+
+        util::data::bytevector compressed(maxCompressedSize(raw.size()));
+        compressed.resize(compress(raw.data(), raw.size(), compressed.data()));
+
+        util::data::bytevector scratch(maxCompressedSize(raw.size()));
+        double compressTime = bench("compress " + name, raw.size(), [&] {
+            size_t size = compress(raw.data(), raw.size(), scratch.data());
+            doNotOptimize(size);
+        });
+
+        util::data::bytevector out(raw.size());
+        double decompressTime = bench("decompress " + name, raw.size(), [&] {
+            decompress(compressed.data(), compressed.size(), out.data(), out.size());
+            doNotOptimize(out.data());
+        });
+
+        if (compressTime == 0.0 || decompressTime == 0.0) return;
+
+        std::printf(
+            "%-52s %8.2fx ratio %7.2f ns/B compress %7.2f ns/B decompress (%zu -> %zu B)\n",
+            ("ratio " + name).c_str(),
+            static_cast<double>(raw.size()) / compressed.size(),
+            compressTime / raw.size(),
+            decompressTime / raw.size(),
+            raw.size(),
+            compressed.size()
+        );
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        filter = argv[1];
+    }
+
+    benchPlayerData();
+
+    for (size_t players : {1, 10, 100}) {
+        benchLevelData(players);
+    }
+
+    for (size_t players : {10, 100}) {
+        benchPlayerProfiles(players);
+    }
+
+    for (size_t frames : {5, 10}) {
+        benchVoiceBroadcast(frames);
+    }
+
+    for (size_t players : {10, 100}) {
+        auto suffix = " (" + std::to_string(players) + ")";
+        benchCompression("PlayerProfilesPacket" + suffix, samples::playerProfiles(players));
+        benchCompression("RoomPlayerListPacket" + suffix, samples::roomPlayerList(players));
+    }
+
+    for (size_t levels : {10, 200}) {
+        benchCompression("LevelListPacket (" + std::to_string(levels) + ")", samples::levelList(levels));
+    }
+}
@@ -0,0 +1,178 @@
+/*
+* Builds the static compression dictionary (see util/compression.hpp) from packet captures recorded with GLOBED_CAPTURE=<file>.
+*   ./globed-dict <captures...>               - a dictionary of up to 128 bytes
+*   ./globed-dict <captures...> --size 256    - a different size
+*
+* Only the packets the server compresses are used, and only when they are big enough to get compressed.
+* The result is printed as the arrays for both src/util/compression.cpp and server/game/src/util/compression.rs,
+* which have to be replaced together since the two sides must use the same dictionary.
+*
+* Works like a much simpler zstd --train: every 8 byte sequence is counted once per packet it shows up in,
+* and the ones seen in the most packets are added until the dictionary is full. Sequences that are already in it are skipped,
+* and one that starts with the end of the dictionary only adds the bytes that aren't there yet.
+*/
+
+#include <data/packets/all.hpp>
+#include <net/packet_capture.hpp>
+#include <util/compression.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    using util::data::byte;
+    using util::data::bytevector;
+
+    constexpr size_t SEGMENT_SIZE = 8;
+    constexpr size_t DEFAULT_SIZE = 128;
+
+    // keep in sync with `is_compressible` in the server
+    bool isCompressible(packetid_t id) {
+        switch (id) {
+            case GlobalPlayerListPacket::PACKET_ID:
+            case RoomPlayerListPacket::PACKET_ID:
+            case LevelListPacket::PACKET_ID:
+            case PlayerProfilesPacket::PACKET_ID:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool loadSamples(const std::string& path, std::vector<bytevector>& out) {
+        auto result = CaptureReader::open(path);
+        if (result.isErr()) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), result.unwrapErr().c_str());
+            return false;
+        }
+
+        auto reader = result.unwrap();
+
+        try {
+            while (auto record = reader.next()) {
+                if (record->outgoing || !isCompressible(record->id) || record->payload.size() < CompressedPacket::THRESHOLD) continue;
+
+                out.emplace_back(record->payload.begin(), record->payload.end());
+            }
+        } catch (const std::exception& e) {
+            // a capture cut short by the game closing, the records before that are still good
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+        }
+
+        return true;
+    }
+
+    std::string train(const std::vector<bytevector>& samples, size_t size) {
+        // in how many samples every sequence appears
+        std::unordered_map<std::string_view, size_t> counts;
+        std::unordered_set<std::string_view> seen;
+
+        for (const auto& sample : samples) {
+            seen.clear();
+
+            for (size_t i = 0; i + SEGMENT_SIZE <= sample.size(); i++) {
+                std::string_view segment(reinterpret_cast<const char*>(sample.data() + i), SEGMENT_SIZE);
+                if (seen.insert(segment).second) {
+                    counts[segment]++;
+                }
+            }
+        }
+
+        std::vector<std::pair<std::string_view, size_t>> ranked(counts.begin(), counts.end());
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+
+        std::string dictionary;
+
+        for (const auto& [segment, count] : ranked) {
+            // only in one packet, nothing else would reference it
+            if (count < 2) break;
+            if (dictionary.find(segment) != std::string::npos) continue;
+
+            size_t overlap = SEGMENT_SIZE - 1;
+            while (overlap > 0 && !dictionary.ends_with(segment.substr(0, overlap))) overlap--;
+
+            if (dictionary.size() + SEGMENT_SIZE - overlap > size) continue;
+
+            dictionary.append(segment.substr(overlap));
+        }
+
+        return dictionary;
+    }
+
+    // 16 bytes per line like in the sources, `lineEnd` goes after every full line (rustfmt needs a comment to keep them)
+    void printArray(const std::string& dictionary, const char* indent, const char* lineEnd) {
+        for (size_t i = 0; i < dictionary.size(); i++) {
+            std::printf("%s0x%02x,", i % 16 == 0 ? indent : " ", static_cast<byte>(dictionary[i]));
+
+            if (i + 1 == dictionary.size()) {
+                std::printf("\n");
+            } else if (i % 16 == 15) {
+                std::printf("%s\n", lineEnd);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    size_t size = DEFAULT_SIZE;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            paths.emplace_back(argv[i]);
+        }
+    }
+
+    if (paths.empty() || size < SEGMENT_SIZE) {
+        std::fprintf(stderr, "usage: %s <captures...> [--size <bytes>]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<bytevector> samples;
+    for (const auto& path : paths) {
+        if (!loadSamples(path, samples)) return 1;
+    }
+
+    if (samples.empty()) {
+        std::fprintf(stderr, "no compressible packets in the captures\n");
+        return 1;
+    }
+
+    // how the dictionary that's built in does on the same packets, to compare against after replacing it
+    size_t rawTotal = 0, compressedTotal = 0;
+    bytevector out;
+
+    for (const auto& sample : samples) {
+        out.resize(util::compression::maxCompressedSize(sample.size()));
+        rawTotal += sample.size();
+        compressedTotal += util::compression::compress(sample.data(), sample.size(), out.data());
+    }
+
+    std::fprintf(
+        stderr, "%zu packets, %zu bytes, %zu bytes compressed with the current dictionary (%.2fx)\n",
+        samples.size(), rawTotal, compressedTotal, static_cast<double>(rawTotal) / compressedTotal
+    );
+
+    auto dictionary = train(samples, size);
+
+    std::printf("// src/util/compression.cpp\n");
+    std::printf("        constexpr byte DICTIONARY[] = {\n");
+    printArray(dictionary, "            ", "");
+    std::printf("        };\n\n");
+
+    std::printf("// server/game/src/util/compression.rs\n");
+    std::printf("const DICTIONARY: [u8; %zu] = [\n", dictionary.size());
+    printArray(dictionary, "    ", " //");
+    std::printf("];\n");
+}
@@ -0,0 +1,154 @@
+/*
+* Decode fuzzer for everything the client decodes from data sent by the server. The first byte of the input selects the target.
+* Failing to decode is fine (that's what GLOBED_REQUIRE is for), crashes, hangs and sanitizer reports are not.
+*
+* Built as a libFuzzer target with -DGLOBED_LIBFUZZER=ON (clang only), otherwise linked with fuzz_main.cpp.
+*/
+
+#include "samples.hpp"
+#include <data/bitstream.hpp>
+#include <game/snapshot_history.hpp>
+#include <util/compression.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+    enum class Target : uint8_t {
+        PlayerData,
+        LevelData,
+        PlayerProfiles,
+        RoomPlayerList,
+        Primitives,
+        Compressed,
+        VoiceBroadcast,
+
+        Count
+    };
+
+    void fuzzPrimitives(ByteReader& buf) {
+        buf.readVarUint();
+        buf.readVarInt();
+        buf.readStringView(LengthPrefix::Varint);
+
+        std::vector<uint32_t> values(buf.readListLength(sizeof(uint32_t), LengthPrefix::Varint));
+        buf.readArrayInto(std::span(values));
+
+        BitReader bits(buf);
+        bits.readUnsigned(bits.readUnsigned(6));
+        bits.readSigned(1 + bits.readUnsigned(6));
+    }
+
+    void fuzzOne(Target target, ByteReader& buf) {
+        switch (target) {
+            case Target::PlayerData: {
+                buf.readValue<PlayerData>();
+            } break;
+            case Target::LevelData: {
+                // decode twice into the same history, so the second packet can be applied as a delta against the first
+                LevelSnapshotHistory history;
+                std::vector<AssociatedPlayerData> out;
+
+                LevelDataPacket packet;
+                packet.decode(buf);
+                history.apply(packet, out);
+
+                packet.decode(buf);
+                history.apply(packet, out);
+            } break;
+            case Target::PlayerProfiles: {
+                PlayerProfilesPacket packet;
+                packet.decode(buf);
+            } break;
+            case Target::RoomPlayerList: {
+                RoomPlayerListPacket packet;
+                packet.decode(buf);
+            } break;
+            case Target::Primitives: {
+                fuzzPrimitives(buf);
+            } break;
+            case Target::Compressed: {
+                // the uncompressed size, then the compressed data
+                std::vector<uint8_t> out(buf.readU16());
+                auto compressed = buf.readBytes(buf.remaining());
+                util::compression::decompress(compressed.data(), compressed.size(), out.data(), out.size());
+            } break;
+            case Target::VoiceBroadcast: {
+                // twice into the same packet, like a recycled one
+                VoiceBroadcastPacket packet;
+                packet.decode(buf);
+                packet.decode(buf);
+            } break;
+            default: break;
+        }
+    }
+}
+
+// Valid inputs for every target, used as the starting point for mutations
+std::vector<util::data::bytevector> fuzzSeeds() {
+    std::vector<util::data::bytevector> seeds;
+
+    auto addSeed = [&](Target target, const util::data::bytevector& data) {
+        auto& seed = seeds.emplace_back();
+        seed.push_back(static_cast<uint8_t>(target));
+        seed.insert(seed.end(), data.begin(), data.end());
+    };
+
+    for (int i = 0; i < 8; i++) {
+        ByteBuffer buf;
+        buf.writeValue(samples::playerData(i));
+        addSeed(Target::PlayerData, buf.getDataRef());
+    }
+
+    for (size_t players : {0, 1, 5}) {
+        auto first = samples::levelData(players, 1);
+        auto second = samples::levelData(players, 2);
+        first.insert(first.end(), second.begin(), second.end());
+        addSeed(Target::LevelData, first);
+
+        addSeed(Target::PlayerProfiles, samples::playerProfiles(players));
+    }
+
+    for (size_t frames : {1, 10}) {
+        auto first = samples::voiceBroadcast(frames);
+        auto second = samples::voiceBroadcast(frames / 2, 60);
+        first.insert(first.end(), second.begin(), second.end());
+        addSeed(Target::VoiceBroadcast, first);
+    }
+
+    for (const auto& raw : {samples::playerProfiles(5), samples::roomPlayerList(5), samples::levelList(20)}) {
+        util::data::bytevector compressed(util::compression::maxCompressedSize(raw.size()));
+        compressed.resize(util::compression::compress(raw.data(), raw.size(), compressed.data()));
+
+        ByteBuffer buf;
+        buf.writeU16(raw.size());
+        buf.writeBytes(compressed);
+        addSeed(Target::Compressed, buf.getDataRef());
+    }
+
+    ByteBuffer primitives;
+    primitives.writeVarUint(300);
+    primitives.writeVarInt(-5);
+    primitives.writeString("hello", LengthPrefix::Varint);
+    std::array<uint32_t, 3> values = {1, 2, 3};
+    primitives.writeLength(values.size(), LengthPrefix::Varint);
+    primitives.writeArray(std::span<const uint32_t>(values));
+    primitives.writeU32(0xdeadbeef);
+    addSeed(Target::Primitives, primitives.getDataRef());
+
+    return seeds;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) return 0;
+
+    auto target = static_cast<Target>(data[0] % static_cast<uint8_t>(Target::Count));
+    ByteReader buf(data + 1, size - 1);
+
+    try {
+        fuzzOne(target, buf);
+    } catch (const std::exception&) {}
+
+    return 0;
+}
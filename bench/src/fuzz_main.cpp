@@ -0,0 +1,88 @@
+/*
+* Standalone driver for fuzz.cpp, for when libFuzzer isn't available.
+*   ./globed-fuzz                - mutate the built-in seeds for 1 million iterations
+*   ./globed-fuzz <iterations>   - same, with a custom iteration count
+*   ./globed-fuzz <files...>     - run each file once, for reproducing crashes found by libFuzzer
+*/
+
+#include <util/data.hpp>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+std::vector<util::data::bytevector> fuzzSeeds();
+
+namespace {
+    using util::data::bytevector;
+
+    // a few cheap mutations, similar to what libFuzzer does by default
+    void mutate(bytevector& data, std::mt19937& rng) {
+        auto pick = [&](size_t max) { return std::uniform_int_distribution<size_t>(0, max)(rng); };
+
+        size_t count = 1 + pick(3);
+        for (size_t i = 0; i < count; i++) {
+            switch (pick(4)) {
+                case 0: // flip a bit
+                    if (!data.empty()) data[pick(data.size() - 1)] ^= static_cast<uint8_t>(1 << pick(7));
+                    break;
+                case 1: // random byte
+                    if (!data.empty()) data[pick(data.size() - 1)] = static_cast<uint8_t>(pick(255));
+                    break;
+                case 2: // interesting byte, lengths and counts love these
+                    if (!data.empty()) data[pick(data.size() - 1)] = std::array<uint8_t, 5>{0x00, 0x01, 0x7f, 0x80, 0xff}[pick(4)];
+                    break;
+                case 3: // truncate
+                    if (data.size() > 1) data.resize(1 + pick(data.size() - 2));
+                    break;
+                case 4: // insert a random byte
+                    data.insert(data.begin() + pick(data.size()), static_cast<uint8_t>(pick(255)));
+                    break;
+            }
+        }
+    }
+
+    bool isNumber(const char* str) {
+        char* end;
+        std::strtoull(str, &end, 10);
+        return *str != '\0' && *end == '\0';
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && !isNumber(argv[1])) {
+        for (int i = 1; i < argc; i++) {
+            std::ifstream file(argv[i], std::ios::binary);
+            bytevector data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            std::printf("running %s (%zu bytes)\n", argv[i], data.size());
+            LLVMFuzzerTestOneInput(data.data(), data.size());
+        }
+
+        return 0;
+    }
+
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    auto seeds = fuzzSeeds();
+    std::mt19937 rng(1337);
+
+    for (auto& seed : seeds) {
+        LLVMFuzzerTestOneInput(seed.data(), seed.size());
+    }
+
+    for (size_t i = 0; i < iterations; i++) {
+        auto input = seeds[i % seeds.size()];
+        mutate(input, rng);
+
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    std::printf("ran %zu iterations over %zu seeds, no crashes\n", iterations, seeds.size());
+}
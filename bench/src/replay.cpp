@@ -0,0 +1,330 @@
+/*
+* Replays a packet capture (see net/packet_capture.hpp, recorded by running the game with GLOBED_CAPTURE=<file>) through
+* the same path incoming packets take in the game: `matchPacket` and decoding, a listener per packet type, and for level data
+* the snapshot history and the player interpolator, which is ticked every frame like in the play layer.
+*   ./globed-replay <capture>              - at the original speed
+*   ./globed-replay <capture> --speed 4    - 4 times faster
+*   ./globed-replay <capture> --fast       - as fast as possible, for benchmarking
+*   ./globed-replay <capture> --fps 240    - tick the interpolator at a different frame rate (60 by default)
+*
+* Outgoing packets in the capture are only counted. So are voice packets, since there is no audio outside of the game.
+*/
+
+#include <data/packets/all.hpp>
+#include <game/interpolator.hpp>
+#include <game/snapshot_history.hpp>
+#include <net/packet_capture.hpp>
+#include <net/packet_listener.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+    using util::time::micros;
+
+    // keep in sync with NetworkManager::PROTOCOL_VERSION, which can't be included without Geode
+    constexpr uint16_t PROTOCOL_VERSION = 2;
+
+    // same as in the play layer, players are kicked if no level data arrives for this long
+    constexpr float NO_UPDATE_TIMEOUT = 1.0f;
+
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    double nanosSince(clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    struct Options {
+        std::string path;
+        double speed = 1.0; // 0 means as fast as possible
+        uint32_t fps = 60;
+    };
+
+    struct PacketStats {
+        packetid_t id = 0;
+        size_t count = 0;
+        size_t bytes = 0;
+        double decodeNs = 0.0;
+        double handleNs = 0.0;
+    };
+
+    class Replayer {
+    public:
+        Replayer() {
+            this->addListener<LoggedInPacket>([this](LoggedInPacket* packet) {
+                tps = packet->tps;
+            });
+
+            this->addListener<LevelDataPacket>([this](LevelDataPacket* packet) {
+                this->handleLevelData(packet);
+            });
+
+            this->addListener<PlayerProfilesPacket>([this](PlayerProfilesPacket* packet) {
+                profiles += packet->players.size();
+            });
+        }
+
+        void run(CaptureReader& reader, const Options& options) {
+            micros frameDuration(1'000'000 / options.fps);
+            micros nextFrame{0};
+
+            auto wallStart = clock::now();
+
+            // sleeps until the moment something happened in the capture, scaled by the speed
+            auto waitUntil = [&](micros when) {
+                if (options.speed <= 0.0) return;
+
+                auto target = wallStart + std::chrono::duration_cast<clock::duration>(when / options.speed);
+                std::this_thread::sleep_until(target);
+            };
+
+            // a capture from a game that crashed can end in the middle of a record, everything before it is still replayed
+            try {
+                while (auto record = reader.next()) {
+                    // every frame that would have happened before this packet arrived
+                    while (nextFrame <= record->timestamp) {
+                        waitUntil(nextFrame);
+                        this->frame(util::time::as<std::chrono::duration<float>>(frameDuration).count());
+                        nextFrame += frameDuration;
+                    }
+
+                    waitUntil(record->timestamp);
+                    this->handleRecord(*record);
+
+                    captureLength = record->timestamp;
+                }
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "replay stopped early: %s\n", e.what());
+            }
+
+            wallTime = nanosSince(wallStart);
+        }
+
+        void printSummary() const {
+            std::printf("%-8s %10s %12s %14s %14s\n", "id", "count", "bytes", "decode ns/op", "handle ns/op");
+
+            size_t totalCount = 0;
+            double totalNs = 0.0;
+
+            for (size_t i = 0; i < ServerPackets::COUNT; i++) {
+                const auto& st = stats[i];
+                if (st.count == 0) continue;
+
+                std::printf(
+                    "%-8u %10zu %12zu %14.1f %14.1f\n",
+                    st.id, st.count, st.bytes, st.decodeNs / st.count, st.handleNs / st.count
+                );
+
+                totalCount += st.count;
+                totalNs += st.decodeNs + st.handleNs;
+            }
+
+            std::printf("\n");
+            std::printf("incoming packets: %zu, %.1f ns/op on average\n", totalCount, totalCount ? totalNs / totalCount : 0.0);
+            std::printf("outgoing packets: %zu (not replayed)\n", outgoing);
+            if (unknown || failed) {
+                std::printf("unknown packets: %zu, failed to decode: %zu\n", unknown, failed);
+            }
+
+            std::printf("frames: %zu, %.1f ns/frame on average, %zu players at most\n", frames, frames ? tickNs / frames : 0.0, maxPlayers);
+            std::printf("profiles received: %zu\n", profiles);
+            std::printf(
+                "capture length: %.3f s, replayed in %.3f s\n",
+                util::time::as<std::chrono::duration<double>>(captureLength).count(), wallTime / 1e9
+            );
+        }
+
+    private:
+        std::array<PacketListener, ServerPackets::COUNT> listeners;
+        std::array<PacketStats, ServerPackets::COUNT> stats;
+
+        LevelSnapshotHistory history;
+        std::vector<AssociatedPlayerData> receivedPlayers;
+        std::unique_ptr<PlayerInterpolator> interpolator;
+        std::vector<int> players;
+        std::vector<int> toRemove;
+
+        uint32_t tps = 30;
+        float timeCounter = 0.f;
+        float lastServerUpdate = 0.f;
+
+        size_t frames = 0;
+        double tickNs = 0.0;
+        size_t maxPlayers = 0;
+        size_t profiles = 0;
+        size_t outgoing = 0;
+        size_t unknown = 0;
+        size_t failed = 0;
+        micros captureLength{0};
+        double wallTime = 0.0;
+
+        template <HasPacketID P, typename F>
+        void addListener(F&& callback) {
+            listeners[ServerPackets::indexOf<P>()] = PacketListener::create<P>(std::forward<F>(callback));
+        }
+
+        void handleRecord(const CaptureRecord& record) {
+            if (record.outgoing) {
+                outgoing++;
+                return;
+            }
+
+            auto start = clock::now();
+
+            auto packet = matchPacket(record.id);
+            if (!packet) {
+                unknown++;
+                return;
+            }
+
+            ByteReader buf(record.payload.data(), record.payload.size());
+
+            try {
+                packet->decode(buf);
+            } catch (const std::exception& e) {
+                if (failed++ < 10) {
+                    std::fprintf(stderr, "decoding packet ID %u failed: %s\n", record.id, e.what());
+                }
+
+                return;
+            }
+
+            auto decoded = clock::now();
+
+            size_t index = ServerPackets::indexOf(record.id);
+            if (const auto& listener = listeners[index]) {
+                listener(packet.get());
+            }
+
+            auto& st = stats[index];
+            st.id = record.id;
+            st.count++;
+            st.bytes += record.payload.size();
+            st.decodeNs += std::chrono::duration<double, std::nano>(decoded - start).count();
+            st.handleNs += nanosSince(decoded);
+        }
+
+        // like the LevelDataPacket listener in the play layer
+        void handleLevelData(LevelDataPacket* packet) {
+            if (!interpolator) {
+                interpolator = std::make_unique<PlayerInterpolator>(InterpolatorSettings {
+                    .realtime = false,
+                    .isPlatformer = false,
+                    .expectedDelta = 1.0f / tps,
+                });
+            }
+
+            lastServerUpdate = timeCounter;
+
+            history.apply(*packet, receivedPlayers);
+
+            for (const auto& player : receivedPlayers) {
+                if (!interpolator->hasPlayer(player.accountId)) {
+                    interpolator->addPlayer(player.accountId);
+                    players.push_back(player.accountId);
+                }
+
+                interpolator->updatePlayer(player.accountId, player.data, lastServerUpdate);
+            }
+
+            maxPlayers = std::max(maxPlayers, players.size());
+        }
+
+        // like the play layer's update, minus everything that draws
+        void frame(float dt) {
+            timeCounter += dt;
+            frames++;
+
+            if (!interpolator) return;
+
+            auto start = clock::now();
+
+            interpolator->tick(dt);
+
+            bool timedOut = timeCounter - lastServerUpdate > NO_UPDATE_TIMEOUT;
+
+            toRemove.clear();
+
+            for (int playerId : players) {
+                if (timedOut || interpolator->isPlayerStale(playerId, lastServerUpdate)) {
+                    toRemove.push_back(playerId);
+                    continue;
+                }
+
+                doNotOptimize(interpolator->getPlayerState(playerId));
+                doNotOptimize(interpolator->swapDeathStatus(playerId));
+                doNotOptimize(interpolator->swapP1Teleport(playerId));
+                doNotOptimize(interpolator->swapP2Teleport(playerId));
+            }
+
+            for (int playerId : toRemove) {
+                interpolator->removePlayer(playerId);
+                players.erase(std::find(players.begin(), players.end(), playerId));
+            }
+
+            tickNs += nanosSince(start);
+        }
+    };
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--fast") {
+                options.speed = 0.0;
+            } else if (arg == "--speed" && hasValue) {
+                options.speed = std::strtod(argv[++i], nullptr);
+                if (options.speed <= 0.0) return false;
+            } else if (arg == "--fps" && hasValue) {
+                options.fps = std::strtoul(argv[++i], nullptr, 10);
+                if (options.fps == 0 || options.fps > 1000) return false;
+            } else if (options.path.empty() && !arg.starts_with("--")) {
+                options.path = arg;
+            } else {
+                return false;
+            }
+        }
+
+        return !options.path.empty();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+
+    if (!parseArgs(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s <capture> [--speed <multiplier> | --fast] [--fps <frames per second>]\n", argv[0]);
+        return 1;
+    }
+
+    auto result = CaptureReader::open(options.path);
+    if (result.isErr()) {
+        std::fprintf(stderr, "%s: %s\n", options.path.c_str(), result.unwrapErr().c_str());
+        return 1;
+    }
+
+    auto reader = result.unwrap();
+
+    if (reader.getProtocol() != PROTOCOL_VERSION) {
+        std::fprintf(stderr, "warning: the capture is from protocol %u, this build uses %u\n", reader.getProtocol(), PROTOCOL_VERSION);
+    }
+
+    Replayer replayer;
+    replayer.run(reader, options);
+    replayer.printSummary();
+}
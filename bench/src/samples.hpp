@@ -0,0 +1,141 @@
+#pragma once
+
+/*
+* Sample data shared by the benchmarks and the fuzzer seeds. Everything is deterministic,
+* so benchmark numbers are comparable between runs.
+*/
+
+#include <data/packets/client/game.hpp>
+#include <data/packets/server/game.hpp>
+#include <data/packets/server/general.hpp>
+
+namespace samples {
+    inline SpecificIconData iconData(int seed, bool visible) {
+        SpecificIconData data{};
+        data.position = ccp(1500.f + seed * 37.25f, 105.f + (seed % 7) * 30.f);
+        data.rotation = static_cast<float>((seed * 45) % 360);
+        data.iconType = static_cast<PlayerIconType>(1 + seed % 8);
+        data.isVisible = visible;
+        data.isLookingLeft = seed % 2 == 0;
+        data.isUpsideDown = seed % 3 == 0;
+        data.isGrounded = seed % 4 != 0;
+        data.isFalling = seed % 5 == 0;
+
+        if (seed % 10 == 0) {
+            data.spiderTeleportData = SpiderTeleportData { .from = data.position, .to = ccp(data.position.x, 600.f) };
+        }
+
+        return data;
+    }
+
+    inline PlayerData playerData(int seed) {
+        PlayerData data{};
+        data.timestamp = 12.5f + seed / 30.f;
+        data.localBest = 40 + seed % 60;
+        data.attempts = 3 + seed * 11;
+        data.isDualMode = seed % 6 == 0;
+        data.player1 = iconData(seed, true);
+        data.player2 = iconData(seed + 1, data.isDualMode);
+
+        if (!data.isDualMode) {
+            data.player2 = data.player1;
+            data.player2.isVisible = false;
+            data.player2.spiderTeleportData.reset();
+        }
+
+        if (seed % 8 == 0) {
+            data.lastDeathTimestamp = 10.f;
+        }
+
+        data.currentPercentage = 0.5f;
+        data.isDead = seed % 8 == 0;
+
+        return data;
+    }
+
+    inline PlayerAccountData accountData(int seed) {
+        PlayerAccountData data = PlayerAccountData::DEFAULT_DATA;
+        data.id = 100000 + seed;
+        data.name = "Player" + std::to_string(seed);
+
+        if (seed % 5 == 0) {
+            data.specialUserData = SpecialUserData(cocos2d::ccc3(255, 0, seed % 256));
+        }
+
+        return data;
+    }
+
+    // LevelDataPacket body as sent by the server, with every entry being a full snapshot
+    inline util::data::bytevector levelData(size_t players, uint32_t sequence = 1) {
+        ByteBuffer buf;
+        buf.writeU32(sequence);
+        buf.writeU32(0);
+        buf.writeU32(players);
+
+        for (size_t i = 0; i < players; i++) {
+            buf.writeI32(100000 + i);
+            buf.writeValue(playerData(i));
+        }
+
+        return std::move(buf.getDataRef());
+    }
+
+    // VoiceBroadcastPacket body, opus frames of a typical voice bitrate
+    inline util::data::bytevector voiceBroadcast(size_t frames, size_t frameSize = 120) {
+        ByteBuffer buf;
+        buf.writeI32(100000);
+
+        for (size_t i = 0; i < ReceivedAudioFrame::MAX_FRAMES; i++) {
+            buf.writeBool(i < frames);
+            if (i >= frames) continue;
+
+            buf.writeU32(frameSize);
+            for (size_t j = 0; j < frameSize; j++) {
+                buf.writeU8(static_cast<uint8_t>(i * 31 + j * 7));
+            }
+        }
+
+        return std::move(buf.getDataRef());
+    }
+
+    // PlayerProfilesPacket body
+    inline util::data::bytevector playerProfiles(size_t players) {
+        std::vector<PlayerAccountData> profiles;
+        for (size_t i = 0; i < players; i++) {
+            profiles.push_back(accountData(i));
+        }
+
+        ByteBuffer buf;
+        buf.writeValueVector(profiles, LengthPrefix::Varint);
+        return std::move(buf.getDataRef());
+    }
+
+    // RoomPlayerListPacket body
+    inline util::data::bytevector roomPlayerList(size_t players) {
+        std::vector<PlayerRoomPreviewAccountData> previews;
+        for (size_t i = 0; i < players; i++) {
+            auto data = accountData(i);
+            previews.emplace_back(data.id, data.name, data.icons.cube, data.icons.color1, data.icons.color2, data.icons.glowColor, 1000 + i % 7);
+        }
+
+        ByteBuffer buf;
+        buf.writeU32(123456);
+        buf.writeValueVector(previews, LengthPrefix::Varint);
+        return std::move(buf.getDataRef());
+    }
+
+    // LevelListPacket body, most levels only have a player or two
+    inline util::data::bytevector levelList(size_t levels) {
+        std::vector<GlobedLevel> list;
+        for (size_t i = 0; i < levels; i++) {
+            list.push_back(GlobedLevel {
+                .levelId = static_cast<int>(80000000 + i * 7919 % 20000000),
+                .playerCount = static_cast<unsigned short>(1 + (i % 5 == 0 ? i % 13 : 0)),
+            });
+        }
+
+        ByteBuffer buf;
+        buf.writeValueVector(list, LengthPrefix::Varint);
+        return std::move(buf.getDataRef());
+    }
+}
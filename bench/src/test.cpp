@@ -0,0 +1,87 @@
+/*
+* Tests for the parts of the network code that don't need a socket, ran by ctest:
+*   ./globed-test
+*/
+
+#include <net/reliable_channel.hpp>
+
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using util::data::byte;
+
+    int failures = 0;
+
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            failures++;
+        }
+    }
+
+    // the id of every packet handled, in order
+    struct Delivered {
+        std::vector<packetid_t> ids;
+
+        void operator()(packetid_t id, const byte*, size_t, bool) {
+            ids.push_back(id);
+        }
+    };
+
+    void testDeliversInOrder() {
+        ReliableChannel channel;
+        Delivered delivered;
+        byte payload[1] = {0};
+
+        channel.deliver(1, 11, payload, 1, false, std::ref(delivered));
+        check(delivered.ids.empty(), "an early packet is held back");
+
+        channel.deliver(0, 10, payload, 1, false, std::ref(delivered));
+        check((delivered.ids == std::vector<packetid_t>{10, 11}), "the early packet follows the one it was waiting for");
+
+        channel.deliver(1, 11, payload, 1, false, std::ref(delivered));
+        check(delivered.ids.size() == 2, "a duplicate is not handled again");
+    }
+
+    void testFailedPacketDoesNotStrandEarlyOnes() {
+        ReliableChannel channel;
+        Delivered delivered;
+        byte payload[1] = {0};
+
+        auto handle = [&](packetid_t id, const byte* data, size_t length, bool encrypted) {
+            if (id == 10) throw std::runtime_error("decoding failed");
+            delivered(id, data, length, encrypted);
+        };
+
+        channel.deliver(1, 11, payload, 1, false, handle);
+        channel.deliver(2, 12, payload, 1, false, handle);
+
+        bool threw = false;
+        try {
+            channel.deliver(0, 10, payload, 1, false, handle);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+
+        check(threw, "the decoding error is rethrown");
+        check((delivered.ids == std::vector<packetid_t>{11, 12}), "the early packets are delivered after a failed one");
+
+        channel.deliver(3, 13, payload, 1, false, handle);
+        check((delivered.ids == std::vector<packetid_t>{11, 12, 13}), "the channel keeps going after a failed packet");
+    }
+}
+
+int main() {
+    testDeliversInOrder();
+    testFailedPacketDoesNotStrandEarlyOnes();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    std::printf("all checks passed\n");
+}
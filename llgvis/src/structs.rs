@@ -1,7 +1,7 @@
 use esp::*;
 use globed_derive::*;
 
-#[derive(Decodable, Clone)]
+#[derive(Decodable, Clone, Default)]
 pub struct PlayerLogData {
     pub local_timestamp: f32,
     pub timestamp: f32,
@@ -9,10 +9,60 @@ pub struct PlayerLogData {
     pub rotation: f32,
 }
 
-#[derive(Decodable, Clone)]
+#[derive(Clone)]
 pub struct PlayerLog {
     pub real: Vec<PlayerLogData>,
     pub real_extrapolated: Vec<(PlayerLogData, PlayerLogData)>,
     pub lerped: Vec<PlayerLogData>,
     pub lerp_skipped: Vec<PlayerLogData>,
 }
+
+// five f32 values per frame
+const ENCODED_FRAME_SIZE: usize = 5 * 4;
+
+// frame lists are encoded column by column (`FieldSchema::writeColumnar` in the client),
+// first all local timestamps, then all timestamps, then all positions, then all rotations.
+macro_rules! read_columnar_frames {
+    ($buf:ident) => {{
+        let count = $buf.read_u32()? as usize;
+
+        // don't allocate for more frames than the rest of the file could possibly hold
+        if count > $buf.len().saturating_sub($buf.get_rpos()) / ENCODED_FRAME_SIZE {
+            return Err(DecodeError::NotEnoughData);
+        }
+
+        let mut frames = vec![PlayerLogData::default(); count];
+
+        for frame in &mut frames {
+            frame.local_timestamp = $buf.read_f32()?;
+        }
+
+        for frame in &mut frames {
+            frame.timestamp = $buf.read_f32()?;
+        }
+
+        for frame in &mut frames {
+            frame.position = ($buf.read_f32()?, $buf.read_f32()?);
+        }
+
+        for frame in &mut frames {
+            frame.rotation = $buf.read_f32()?;
+        }
+
+        frames
+    }};
+}
+
+decode_impl!(PlayerLog, buf, {
+    let real = read_columnar_frames!(buf);
+    let real_extrapolated = buf.read_value_vec()?;
+    let lerped = read_columnar_frames!(buf);
+    let lerp_skipped = read_columnar_frames!(buf);
+
+    Ok(Self {
+        real,
+        real_extrapolated,
+        lerped,
+        lerp_skipped,
+    })
+});
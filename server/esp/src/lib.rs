@@ -31,6 +31,7 @@ pub enum DecodeError {
     NotEnoughCapacityString,
     InvalidEnumValue,
     InvalidStringValue,
+    DataTooLong,
 }
 
 impl Display for DecodeError {
@@ -40,6 +41,7 @@ impl Display for DecodeError {
             Self::NotEnoughCapacityString => f.write_str("not enough capacity to fit the given string into a FastString"),
             Self::InvalidEnumValue => f.write_str("invalid enum value was passed"),
             Self::InvalidStringValue => f.write_str("invalid string was passed, likely not properly UTF-8 encoded"),
+            Self::DataTooLong => f.write_str("length of the data exceeds the maximum permitted size"),
         }
     }
 }
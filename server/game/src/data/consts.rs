@@ -7,5 +7,5 @@ pub const MAX_MESSAGE_SIZE: usize = 156;
 /// amount of chars in a room id string (6)
 pub const ROOM_ID_LENGTH: usize = 6;
 
-// this should be the PlayerData size plus some headroom
-pub const SMALL_PACKET_LIMIT: usize = 80;
+// this should be the maximum PlayerDataPacket size (header + 4 + 1 + MAX_PLAYER_DATA_SIZE) plus some headroom
+pub const SMALL_PACKET_LIMIT: usize = 88;
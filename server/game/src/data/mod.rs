@@ -20,6 +20,44 @@ pub trait ByteBufferExtWrite2 {
     fn write_list_with<FLoop>(&mut self, upper_bound: usize, fs: FLoop) -> usize
     where
         FLoop: FnOnce(&mut Self) -> usize;
+    /// like `write_list_with`, but the length is a LEB128 varint (`LengthPrefix::Varint` on the client).
+    /// `size_of_varuint(upper_bound)` bytes are reserved for it, if fewer elements get written the varint is padded to that size.
+    fn write_varint_list_with<FLoop>(&mut self, upper_bound: usize, fs: FLoop) -> usize
+    where
+        FLoop: FnOnce(&mut Self) -> usize;
+}
+
+/// encoded size of `value` as a LEB128 varint
+pub const fn size_of_varuint(value: usize) -> usize {
+    let mut size = 1;
+    let mut value = value >> 7;
+
+    while value != 0 {
+        size += 1;
+        value >>= 7;
+    }
+
+    size
+}
+
+/// encodes `value` as a LEB128 varint of exactly `width` bytes, padding it with continuation bytes if it's shorter.
+/// decoders accept the padded form, it just isn't the shortest one.
+fn encode_varuint_padded(value: usize, width: usize) -> ([u8; 10], usize) {
+    debug_assert!(width >= size_of_varuint(value) && width <= 10);
+
+    let mut out = [0u8; 10];
+    let mut value = value;
+
+    for (i, byte) in out.iter_mut().enumerate().take(width) {
+        *byte = (value & 0x7f) as u8;
+        value >>= 7;
+
+        if i + 1 < width {
+            *byte |= 0x80;
+        }
+    }
+
+    (out, width)
 }
 
 impl ByteBufferExtRead2 for ByteBuffer {
@@ -61,6 +99,30 @@ impl ByteBufferExtWrite2 for ByteBuffer {
 
         written
     }
+
+    #[inline]
+    fn write_varint_list_with<FLoop>(&mut self, upper_bound: usize, fs: FLoop) -> usize
+    where
+        FLoop: FnOnce(&mut Self) -> usize,
+    {
+        let width = size_of_varuint(upper_bound);
+
+        let lenpos = self.get_wpos();
+        let (bytes, len) = encode_varuint_padded(upper_bound, width);
+        self.write_bytes(&bytes[..len]);
+
+        let written = fs(self);
+
+        if written != upper_bound {
+            let endpos = self.get_wpos();
+            self.set_wpos(lenpos);
+            let (bytes, len) = encode_varuint_padded(written, width);
+            self.write_bytes(&bytes[..len]);
+            self.set_wpos(endpos);
+        }
+
+        written
+    }
 }
 
 impl<'a> ByteBufferExtWrite2 for FastByteBuffer<'a> {
@@ -88,4 +150,28 @@ impl<'a> ByteBufferExtWrite2 for FastByteBuffer<'a> {
 
         written
     }
+
+    #[inline]
+    fn write_varint_list_with<FLoop>(&mut self, upper_bound: usize, fs: FLoop) -> usize
+    where
+        FLoop: FnOnce(&mut Self) -> usize,
+    {
+        let width = size_of_varuint(upper_bound);
+
+        let lenpos = self.get_pos();
+        let (bytes, len) = encode_varuint_padded(upper_bound, width);
+        self.write_bytes(&bytes[..len]);
+
+        let written = fs(self);
+
+        if written != upper_bound {
+            let endpos = self.get_pos();
+            self.set_pos(lenpos);
+            let (bytes, len) = encode_varuint_padded(written, width);
+            self.write_bytes(&bytes[..len]);
+            self.set_pos(endpos);
+        }
+
+        written
+    }
 }
@@ -30,3 +30,39 @@ pub struct LoginPacket {
 #[derive(Packet, Decodable)]
 #[packet(id = 10004)]
 pub struct DisconnectPacket;
+
+/// several packets in one datagram, see `GameServerThread::handle_bundle`
+#[derive(Packet, Decodable)]
+#[packet(id = 10005)]
+pub struct BundlePacket;
+
+impl BundlePacket {
+    /// every entry starts with the packet ID (u16) and the length of the packet data (u16)
+    pub const ENTRY_HEADER_SIZE: usize = 4;
+}
+
+/// a packet on the reliable ordered channel, see `GameServerThread::handle_reliable`
+#[derive(Packet, Decodable)]
+#[packet(id = 10006)]
+pub struct ReliablePacket;
+
+impl ReliablePacket {
+    /// sequence number (u32), cumulative ack (u32), selective ack bits (u32) and the ID of the wrapped packet (u16)
+    pub const HEADER_SIZE: usize = 14;
+}
+
+#[derive(Packet, Decodable)]
+#[packet(id = 10007)]
+pub struct ReliableAckPacket {
+    pub ack: u32,
+    pub ack_bits: u32,
+}
+
+/// asks for the missing fragments of a fragmented datagram to be sent again, see `FragmentHistory`
+#[derive(Packet, Decodable)]
+#[packet(id = 10008)]
+pub struct FragmentRequestPacket {
+    pub message_id: u32,
+    /// bit `n` set means fragment `n` is missing
+    pub missing: u64,
+}
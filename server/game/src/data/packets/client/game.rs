@@ -19,6 +19,7 @@ pub struct LevelLeavePacket;
 #[derive(Packet, Decodable)]
 #[packet(id = 12003)]
 pub struct PlayerDataPacket {
+    pub acknowledged: u32, // sequence number of the latest `LevelDataPacket` the client has received
     pub data: PlayerData,
 }
 
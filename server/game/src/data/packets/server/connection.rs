@@ -49,3 +49,42 @@ pub struct ServerNoticePacket<'a> {
 pub struct ProtocolMismatchPacket {
     pub protocol: u16,
 }
+
+/// same format as the client's `ReliablePacket`, encrypted if the wrapped packet is
+#[derive(Packet, Encodable, StaticSize)]
+#[packet(id = 20009)]
+pub struct ServerReliablePacket;
+
+#[derive(Packet, Encodable, StaticSize)]
+#[packet(id = 20010)]
+pub struct ServerReliableAckPacket {
+    pub ack: u32,
+    pub ack_bits: u32,
+}
+
+/// a piece of a datagram that is too big to be sent at once, see `GameServerThread::send_fragmented`
+#[derive(Packet, Encodable, StaticSize)]
+#[packet(id = 20011)]
+pub struct ServerFragmentPacket;
+
+impl ServerFragmentPacket {
+    /// message ID (u32), fragment index (u16) and fragment count (u16)
+    pub const HEADER_SIZE: usize = 8;
+    /// every fragment except the last one carries exactly this many bytes of the datagram.
+    /// small enough for the whole packet to fit in the minimum ipv6 mtu.
+    pub const MAX_DATA_SIZE: usize = 1200;
+    /// fits in the bitmask of a `FragmentRequestPacket`
+    pub const MAX_FRAGMENTS: usize = 64;
+}
+
+/// a big packet compressed with `util::compression`, see `GameServerThread::send_packet_compressed`
+#[derive(Packet, Encodable, StaticSize)]
+#[packet(id = 20012)]
+pub struct ServerCompressedPacket;
+
+impl ServerCompressedPacket {
+    /// packet ID (u16) of the compressed packet and its uncompressed size (u32)
+    pub const HEADER_SIZE: usize = 6;
+    /// anything smaller is sent as-is, small packets barely compress and it's not worth the time
+    pub const THRESHOLD: usize = 256;
+}
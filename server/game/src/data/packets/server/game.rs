@@ -2,6 +2,11 @@ use crate::data::*;
 
 /*
 * For optimization reasons, these 2 are encoded inline in the packet handlers in server_thread/handlers/game.rs.
+*
+* `PlayerProfilesPacket` is a list of `PlayerAccountData` with a varint length prefix.
+*
+* `LevelDataPacket` is a sequence number, the sequence number of the baseline (0 if none) and a list of players,
+* where the data of each player is either full or delta encoded against the baseline (see `PlayerData::encode_relative`).
 */
 
 #[derive(Packet, Encodable)]
@@ -1,8 +1,8 @@
 use crate::data::*;
 
 /*
-* For optimization reasons, `PlayerListPacket` and `RoomPlayerListPacket` are encoded inline,
-* their structure is not present here.
+* For optimization reasons, `PlayerListPacket`, `RoomPlayerListPacket` and `LevelListPacket` are encoded inline,
+* their structure is not present here. The lists of the last two have varint length prefixes (see `write_varint_list_with`).
 */
 
 #[derive(Packet, Encodable)]
@@ -1,58 +1,99 @@
 use crate::data::*;
 
-/* PlayerIconType */
-
-#[derive(Default, Debug, Copy, Clone, Encodable, Decodable, StaticSize, DynamicSize)]
-#[dynamic_size(as_static = true)]
-#[repr(u8)]
-pub enum PlayerIconType {
-    #[default]
-    Unknown = 0,
-    Cube = 1,
-    Ship = 2,
-    Ball = 3,
-    Ufo = 4,
-    Wave = 5,
-    Robot = 6,
-    Spider = 7,
-    Swing = 8,
-}
+/// maximum size of the encoded `PlayerData`, excluding the length prefix (72)
+pub const MAX_PLAYER_DATA_SIZE: usize = 72;
+/// set in the length prefix of a `PlayerData` that is delta encoded, see `PlayerData::encode_relative`
+pub const PLAYER_DATA_DELTA_FLAG: u8 = 0x80;
+
+/* PlayerData (data in a level) */
 
-/* SpiderTeleportData (spider teleport data) */
-#[derive(Clone, Default, Encodable, Decodable, StaticSize, DynamicSize)]
-#[dynamic_size(as_static = true)]
-pub struct SpiderTeleportData {
-    pub from: Point,
-    pub to: Point,
+/// The server never looks inside of player data, it just stores the latest one for every player and forwards it to others as-is.
+/// See the client-side structure for the actual format. A length of 0 means the player has not sent any data yet.
+#[derive(Clone)]
+pub struct PlayerData {
+    data: [u8; MAX_PLAYER_DATA_SIZE],
+    len: usize,
 }
 
-/* SpecificIconData (specific player data) */
+impl PlayerData {
+    #[inline]
+    pub fn as_bytes(&self) -> &[u8] {
+        &self.data[..self.len]
+    }
 
-#[derive(Clone, Default, Encodable, Decodable, StaticSize, DynamicSize)]
-#[dynamic_size(as_static = true)]
-pub struct SpecificIconData {
-    pub position: Point,
-    pub rotation: f32,
-    pub icon_type: PlayerIconType,
-    pub flags: u16, // bit-field with various flags, see the client-side structure for more info
-    pub spider_teleport_data: Option<SpiderTeleportData>,
-}
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
 
-/* PlayerData (data in a level) */
+    /// Encode the data as a delta against `baseline`, if that would be smaller than the full data.
+    /// The delta is the length prefix with `PLAYER_DATA_DELTA_FLAG` set, a bitmask of bytes that changed (MSB first),
+    /// and then the changed bytes XOR'd with the baseline. If nothing changed, only `PLAYER_DATA_DELTA_FLAG` is written.
+    /// This never writes more than the regular encoding would.
+    pub fn encode_relative(&self, buf: &mut FastByteBuffer, baseline: &PlayerData) {
+        if self.is_empty() {
+            buf.write_u8(0);
+            return;
+        }
 
-#[derive(Clone, Default, Encodable, Decodable, StaticSize, DynamicSize)]
-#[dynamic_size(as_static = true)]
-pub struct PlayerData {
-    pub timestamp: f32,
-    pub local_best: u32, // percentage or milliseconds in platformer
-    pub attempts: i32,
+        let mut mask = [0u8; MAX_PLAYER_DATA_SIZE.div_ceil(8)];
+        let mut changed = [0u8; MAX_PLAYER_DATA_SIZE];
+        let mut changed_count = 0usize;
 
-    pub player1: SpecificIconData,
-    pub player2: SpecificIconData,
+        // bytes past `len` are always zero, so there's no need to care about the baseline being shorter
+        for i in 0..self.len {
+            let xored = self.data[i] ^ baseline.data[i];
+            if xored != 0 {
+                mask[i / 8] |= 0x80 >> (i % 8);
+                changed[changed_count] = xored;
+                changed_count += 1;
+            }
+        }
 
-    pub last_death_timestamp: f32,
+        if changed_count == 0 && self.len == baseline.len {
+            buf.write_u8(PLAYER_DATA_DELTA_FLAG);
+            return;
+        }
 
-    pub current_percentage: f32,
+        let mask_len = self.len.div_ceil(8);
+        if mask_len + changed_count >= self.len {
+            buf.write_value(self);
+            return;
+        }
 
-    pub flags: u8, // also a bit-field
+        buf.write_u8(PLAYER_DATA_DELTA_FLAG | self.len as u8);
+        buf.write_bytes(&mask[..mask_len]);
+        buf.write_bytes(&changed[..changed_count]);
+    }
 }
+
+impl Default for PlayerData {
+    fn default() -> Self {
+        Self {
+            data: [0u8; MAX_PLAYER_DATA_SIZE],
+            len: 0,
+        }
+    }
+}
+
+encode_impl!(PlayerData, buf, self, {
+    buf.write_u8(self.len as u8);
+    buf.write_bytes(self.as_bytes());
+});
+
+decode_impl!(PlayerData, buf, {
+    let len = buf.read_u8()? as usize;
+    if len > MAX_PLAYER_DATA_SIZE {
+        return Err(DecodeError::DataTooLong);
+    }
+
+    let mut data = [0u8; MAX_PLAYER_DATA_SIZE];
+    for byte in &mut data[..len] {
+        *byte = buf.read_u8()?;
+    }
+
+    Ok(Self { data, len })
+});
+
+static_size_calc_impl!(PlayerData, size_of_types!(u8) + MAX_PLAYER_DATA_SIZE);
+dynamic_size_calc_impl!(PlayerData, self, size_of_types!(u8) + self.len);
@@ -18,7 +18,7 @@
 
 use std::{
     error::Error,
-    net::{IpAddr, Ipv4Addr, SocketAddr},
+    net::{IpAddr, SocketAddr},
     time::Duration,
 };
 
@@ -79,12 +79,12 @@ fn parse_configuration() -> StartupConfiguration {
         Ok(x) => x,
         Err(_) => {
             // try to parse it as an ip addr and use a default port
-            match bind_address.parse::<Ipv4Addr>() {
-                Ok(x) => SocketAddr::new(IpAddr::V4(x), 41001),
+            match bind_address.parse::<IpAddr>() {
+                Ok(x) => SocketAddr::new(x, 41001),
                 Err(e) => {
                     error!("failed to parse the given IP address ({bind_address}): {e}");
-                    warn!("hint: you have to provide a valid IPv4 address with an optional port number");
-                    warn!("hint: for example \"0.0.0.0\" or \"0.0.0.0:41001\"");
+                    warn!("hint: you have to provide a valid IPv4 or IPv6 address with an optional port number");
+                    warn!("hint: for example \"0.0.0.0\" or \"0.0.0.0:41001\", or \"[::]:41001\" for IPv6");
                     abort_misconfig();
                 }
             }
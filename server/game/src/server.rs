@@ -1,5 +1,5 @@
 use std::{
-    net::{SocketAddr, SocketAddrV4},
+    net::SocketAddr,
     sync::{atomic::Ordering, Arc},
     time::Duration,
 };
@@ -36,8 +36,8 @@ pub struct GameServerConfiguration {
 pub struct GameServer {
     pub state: ServerState,
     pub socket: UdpSocket,
-    pub threads: SyncMutex<FxHashMap<SocketAddrV4, Arc<GameServerThread>>>,
-    rate_limiters: SyncMutex<FxHashMap<SocketAddrV4, SimpleRateLimiter>>,
+    pub threads: SyncMutex<FxHashMap<SocketAddr, Arc<GameServerThread>>>,
+    rate_limiters: SyncMutex<FxHashMap<SocketAddr, SimpleRateLimiter>>,
     pub secret_key: SecretKey,
     pub public_key: PublicKey,
     pub central_conf: SyncMutex<GameServerBootData>,
@@ -273,13 +273,9 @@ impl GameServer {
     }
 
     async fn recv_and_handle(&'static self, buf: &mut [u8]) -> anyhow::Result<()> {
+        // ipv6 peers only show up when bound to an ipv6 address, ipv4 ones then arrive as ipv4-mapped addresses
         let (len, peer) = self.socket.recv_from(buf).await?;
 
-        let peer = match peer {
-            SocketAddr::V4(x) => x,
-            SocketAddr::V6(_) => bail!("rejecting request from ipv6 host"),
-        };
-
         // block packets if the client is sending too many of them
         if self.is_rate_limited(peer) {
             if cfg!(debug_assertions) {
@@ -341,7 +337,7 @@ impl GameServer {
 
     /// Try to fast handle a packet if the packet does not require spawning a new "thread".
     /// Returns true if packet was successfully handled, in which case the data should be discarded.
-    async fn try_fast_handle(&'static self, data: &[u8], peer: SocketAddrV4) -> anyhow::Result<bool> {
+    async fn try_fast_handle(&'static self, data: &[u8], peer: SocketAddr) -> anyhow::Result<bool> {
         let mut byte_reader = ByteReader::from_bytes(data);
         let header = byte_reader.read_packet_header().map_err(|e| anyhow!("{e}"))?;
 
@@ -360,7 +356,7 @@ impl GameServer {
 
                 let send_bytes = buf.as_bytes();
 
-                match self.socket.try_send_to(send_bytes, peer.into()) {
+                match self.socket.try_send_to(send_bytes, peer) {
                     Ok(_) => Ok(true),
                     Err(ref e) if e.kind() == std::io::ErrorKind::WouldBlock => {
                         self.socket.send_to(send_bytes, peer).await?;
@@ -374,7 +370,7 @@ impl GameServer {
         }
     }
 
-    fn is_rate_limited(&'static self, addr: SocketAddrV4) -> bool {
+    fn is_rate_limited(&'static self, addr: SocketAddr) -> bool {
         let mut limiters = self.rate_limiters.lock();
         if let Some(limiter) = limiters.get_mut(&addr) {
             !limiter.try_tick()
@@ -386,7 +382,7 @@ impl GameServer {
         }
     }
 
-    fn post_disconnect_cleanup(&'static self, thread: &GameServerThread, peer: SocketAddrV4) {
+    fn post_disconnect_cleanup(&'static self, thread: &GameServerThread, peer: SocketAddr) {
         self.threads.lock().remove(&peer);
 
         let account_id = thread.account_id.load(Ordering::Relaxed);
@@ -10,6 +10,7 @@ pub enum PacketHandlingError {
     IOError(std::io::Error),               // generic IO error
     MalformedMessage,                      // packet is missing a header
     MalformedLoginAttempt,                 // LoginPacket with cleartext credentials
+    UnreliablePacket(u16),                 // ReliablePacket wrapping a packet that isn't sent through the reliable channel
     MalformedCiphertext,                   // missing nonce/mac in the encrypted ciphertext
     MalformedPacketStructure(DecodeError), // failed to decode the packet
     NoHandler(u16),                        // no handler found for this packet ID
@@ -73,6 +74,9 @@ impl Display for PacketHandlingError {
             Self::MalformedCiphertext => f.write_str("malformed ciphertext in an encrypted packet"),
             Self::MalformedMessage => f.write_str("malformed message structure"),
             Self::MalformedLoginAttempt => f.write_str("malformed login attempt"),
+            Self::UnreliablePacket(id) => {
+                f.write_fmt(format_args!("packet ID {id} can't be sent through the reliable channel"))
+            }
             Self::MalformedPacketStructure(err) => f.write_fmt(format_args!("could not decode a packet: {err}")),
             Self::NoHandler(id) => f.write_fmt(format_args!("no packet handler for packet ID {id}")),
             Self::WebRequestError(msg) => f.write_fmt(format_args!("web request error: {msg}")),
@@ -0,0 +1,68 @@
+use std::{
+    collections::VecDeque,
+    sync::Arc,
+    time::{Duration, Instant},
+};
+
+/// how many recently fragmented datagrams are kept around for fragment requests
+const HISTORY_SIZE: usize = 8;
+/// after this long the client has either reassembled the datagram or given up on it
+const KEEP_FOR: Duration = Duration::from_secs(2);
+/// how many times the fragments of one datagram can be requested again. the client doesn't need more than this,
+/// and it limits how much a single small request can make us send.
+const MAX_RESENDS: u32 = 3;
+
+struct SentDatagram {
+    message_id: u32,
+    data: Arc<[u8]>,
+    sent_at: Instant,
+    resends: u32,
+}
+
+/// `FragmentHistory` remembers the last few datagrams that were too big to be sent at once and were split into fragments,
+/// so that the fragments the client reports as missing can be sent again without resending the whole datagram.
+#[derive(Default)]
+pub struct FragmentHistory {
+    next_message_id: u32,
+    sent: VecDeque<SentDatagram>,
+}
+
+impl FragmentHistory {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// remember a datagram that is about to be fragmented, returns its message ID
+    pub fn store(&mut self, data: &[u8], now: Instant) -> u32 {
+        let message_id = self.next_message_id;
+        self.next_message_id = self.next_message_id.wrapping_add(1);
+
+        while self.sent.len() >= HISTORY_SIZE || self.sent.front().is_some_and(|d| now - d.sent_at > KEEP_FOR) {
+            self.sent.pop_front();
+        }
+
+        self.sent.push_back(SentDatagram {
+            message_id,
+            data: Arc::from(data),
+            sent_at: now,
+            resends: 0,
+        });
+
+        message_id
+    }
+
+    /// the datagram to resend fragments of, `None` if it's no longer kept or was resent too many times already
+    pub fn resend(&mut self, message_id: u32, now: Instant) -> Option<Arc<[u8]>> {
+        let datagram = self
+            .sent
+            .iter_mut()
+            .find(|d| d.message_id == message_id && now - d.sent_at <= KEEP_FOR)?;
+
+        if datagram.resends >= MAX_RESENDS {
+            return None;
+        }
+
+        datagram.resends += 1;
+        Some(datagram.data.clone())
+    }
+}
@@ -1,4 +1,4 @@
-use std::sync::atomic::Ordering;
+use std::{sync::atomic::Ordering, time::Instant};
 
 use globed_shared::{crypto_box::ChaChaBox, logger::*, PROTOCOL_VERSION};
 
@@ -27,7 +27,7 @@ impl GameServerThread {
         }
 
         {
-            // as ServerThread is now tied to the SocketAddrV4 and not account id like in globed v0
+            // as ServerThread is now tied to the SocketAddr and not account id like in globed v0
             // erroring here is not a concern, even if the user's game crashes without a disconnect packet,
             // they would have a new randomized port when they restart and this would never fail.
             if self.crypto_box.get().is_some() {
@@ -145,4 +145,23 @@ impl GameServerThread {
         self.terminate();
         Ok(())
     });
+
+    gs_handler_sync!(self, handle_reliable_ack, ReliableAckPacket, packet, {
+        self.reliable.lock().acknowledge(packet.ack, packet.ack_bits, Instant::now());
+        Ok(())
+    });
+
+    gs_handler!(self, handle_fragment_request, FragmentRequestPacket, packet, {
+        let Some(datagram) = self.fragments.lock().resend(packet.message_id, Instant::now()) else {
+            return Ok(());
+        };
+
+        let count = datagram.len().div_ceil(ServerFragmentPacket::MAX_DATA_SIZE);
+
+        for index in (0..count).filter(|&index| packet.missing & (1 << index) != 0) {
+            self.send_fragment(packet.message_id, index, &datagram).await?;
+        }
+
+        Ok(())
+    });
 }
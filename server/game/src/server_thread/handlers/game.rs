@@ -26,6 +26,8 @@ impl GameServerThread {
             pm.add_to_level(packet.level_id, account_id);
         });
 
+        self.snapshot_history.lock().reset();
+
         Ok(())
     });
 
@@ -41,6 +43,8 @@ impl GameServerThread {
             });
         }
 
+        self.snapshot_history.lock().reset();
+
         Ok(())
     });
 
@@ -65,25 +69,36 @@ impl GameServerThread {
             return Ok(());
         }
 
-        let calc_size = size_of_types!(u32) + size_of_types!(AssociatedPlayerData) * written_players;
+        // delta encoded data is never bigger than the full data
+        let calc_size = size_of_types!(u32, u32, u32) + size_of_types!(AssociatedPlayerData) * written_players;
 
         self.send_packet_alloca_with::<LevelDataPacket, _>(calc_size, |buf| {
+            let mut history = self.snapshot_history.lock();
+            history.acknowledge(packet.acknowledged);
+
+            let (sequence, baseline) = history.begin();
+            buf.write_u32(sequence);
+            buf.write_u32(baseline);
+
             self.game_server.state.room_manager.with_any(room_id, |pm| {
                 buf.write_list_with(written_players, |buf| {
                     pm.for_each_player_on_level(
                         level_id,
-                        |player, count, buf| {
+                        |player, count, (buf, history)| {
                             if count < written_players && player.account_id != account_id {
-                                buf.write_value(player);
+                                buf.write_i32(player.account_id);
+                                history.encode_player(buf, baseline, player.account_id, &player.data);
                                 true
                             } else {
                                 false
                             }
                         },
-                        buf,
+                        &mut (buf, &mut *history),
                     )
                 });
             });
+
+            history.finish();
         })
         .await
     });
@@ -110,10 +125,10 @@ impl GameServerThread {
 
         let written_players = if packet.requested != 0 { 1 } else { total_players };
 
-        let calc_size = size_of_types!(u32) + size_of_types!(PlayerAccountData) * written_players;
+        let calc_size = size_of_varuint(written_players) + size_of_types!(PlayerAccountData) * written_players;
 
         self.send_packet_alloca_with::<PlayerProfilesPacket, _>(calc_size, |buf| {
-            buf.write_list_with(written_players, |buf| {
+            buf.write_varint_list_with(written_players, |buf| {
                 // if we requested a specific player, encode them (if we find them)
                 if packet.requested != 0 {
                     let account_data = self.game_server.get_player_account_data(packet.requested);
@@ -120,11 +120,11 @@ impl GameServerThread {
             .room_manager
             .with_any(room_id, |room| room.get_level_count());
 
-        let encoded_size = size_of_types!(u32) + size_of_types!(GlobedLevel) * level_count;
+        let encoded_size = size_of_varuint(level_count) + size_of_types!(GlobedLevel) * level_count;
 
         self.send_packet_alloca_with::<LevelListPacket, _>(encoded_size, |buf| {
             self.game_server.state.room_manager.with_any(room_id, |pm| {
-                buf.write_list_with(level_count, |buf| {
+                buf.write_varint_list_with(level_count, |buf| {
                     pm.for_each_level(
                         |(level_id, players), count, buf| {
                             if count < level_count {
@@ -153,11 +153,13 @@ impl GameServerThread {
             .room_manager
             .with_any(room_id, |room| room.get_total_player_count());
 
-        let encoded_size = size_of_types!(u32, u32) + size_of_types!(PlayerRoomPreviewAccountData) * player_count;
+        let encoded_size = size_of_types!(u32)
+            + size_of_varuint(player_count)
+            + size_of_types!(PlayerRoomPreviewAccountData) * player_count;
 
         self.send_packet_alloca_with::<RoomPlayerListPacket, _>(encoded_size, |buf| {
             buf.write_u32(room_id);
-            buf.write_list_with(player_count, |buf| {
+            buf.write_varint_list_with(player_count, |buf| {
                 self.game_server.for_every_room_player_preview(
                     room_id,
                     move |preview, count, buf| {
@@ -1,10 +1,10 @@
 use std::{
-    net::SocketAddrV4,
+    net::SocketAddr,
     sync::{
         atomic::{AtomicBool, AtomicI32, AtomicU32, AtomicU64, Ordering},
         Arc, OnceLock,
     },
-    time::{Duration, SystemTime, UNIX_EPOCH},
+    time::{Duration, Instant, SystemTime, UNIX_EPOCH},
 };
 
 use esp::ByteReader;
@@ -19,21 +19,73 @@ use globed_shared::{
 };
 use tokio::sync::{Mutex, Notify};
 
-use crate::{data::*, make_uninit, server::GameServer, server_thread::handlers::*, util::TokioChannel};
+use crate::{
+    data::*,
+    make_uninit,
+    server::GameServer,
+    server_thread::handlers::*,
+    util::{compression, TokioChannel},
+};
 
 mod error;
+mod fragment_history;
 mod handlers;
+mod reliable_channel;
+mod snapshot_history;
 
 pub use error::{PacketHandlingError, Result};
+use fragment_history::FragmentHistory;
+use reliable_channel::ReliableChannel;
+use snapshot_history::SnapshotHistory;
 
 use self::handlers::MAX_VOICE_PACKET_SIZE;
 
 const CHANNEL_BUFFER_SIZE: usize = 8;
+/// the thread stops if the client sends nothing for this long
+const IDLE_TIMEOUT: Duration = Duration::from_secs(90);
 
 // do not touch those, encryption related
 const NONCE_SIZE: usize = 24;
 const MAC_SIZE: usize = 16;
 
+/// the size a packet with a body of `len` bytes has when it's sent as a datagram of its own.
+/// the voice size limit is checked against this, so that bundling a voice packet doesn't change how big it can be.
+const fn standalone_packet_size(len: usize, encrypted: bool) -> usize {
+    PacketHeader::SIZE + if encrypted { NONCE_SIZE + MAC_SIZE } else { 0 } + len
+}
+
+/// packets the client sends through the reliable channel (`ReliableChannel::isReliable` on the client).
+/// anything else in a `ReliablePacket` is rejected, so that it can't skip the checks done in `handle_packet`.
+const fn is_reliable_packet(packet_id: u16) -> bool {
+    matches!(
+        packet_id,
+        LoginPacket::PACKET_ID
+            | SyncIconsPacket::PACKET_ID
+            | CreateRoomPacket::PACKET_ID
+            | JoinRoomPacket::PACKET_ID
+            | LeaveRoomPacket::PACKET_ID
+            | RequestRoomPlayerListPacket::PACKET_ID
+            | RequestLevelListPacket::PACKET_ID
+            | RequestPlayerProfilesPacket::PACKET_ID
+            | LevelJoinPacket::PACKET_ID
+            | LevelLeavePacket::PACKET_ID
+            | AdminAuthPacket::PACKET_ID
+            | AdminSendNoticePacket::PACKET_ID
+    )
+}
+
+/// big lists that are worth compressing. realtime packets like `LevelDataPacket` are left alone,
+/// they are sent every tick and compressing them would cost more than it saves.
+const fn is_compressible(packet_id: u16) -> bool {
+    matches!(
+        packet_id,
+        GlobalPlayerListPacket::PACKET_ID
+            | RoomPlayerListPacket::PACKET_ID
+            | LevelListPacket::PACKET_ID
+            | PlayerProfilesPacket::PACKET_ID
+    )
+}
+
 #[derive(Clone)]
 pub enum ServerThreadMessage {
     Packet(Vec<u8>),
@@ -50,12 +102,17 @@ pub struct GameServerThread {
     awaiting_termination: AtomicBool,
     crypto_box: OnceLock<ChaChaBox>,
 
-    peer: SocketAddrV4,
+    peer: SocketAddr,
     pub is_admin: AtomicBool,
     pub account_id: AtomicI32,
     pub level_id: AtomicI32,
     pub room_id: AtomicU32,
     pub account_data: SyncMutex<PlayerAccountData>,
+    snapshot_history: SyncMutex<SnapshotHistory>,
+    reliable: SyncMutex<ReliableChannel>,
+    /// set while handling a packet from the reliable channel, everything sent in response goes through the channel too
+    replying_reliably: AtomicBool,
+    fragments: SyncMutex<FragmentHistory>,
 
     last_voice_packet: AtomicU64,
     pub cleanup_notify: Notify,
@@ -65,7 +122,7 @@ pub struct GameServerThread {
 impl GameServerThread {
     /* public api for the main server */
 
-    pub fn new(peer: SocketAddrV4, game_server: &'static GameServer) -> Self {
+    pub fn new(peer: SocketAddr, game_server: &'static GameServer) -> Self {
         Self {
             channel: TokioChannel::new(CHANNEL_BUFFER_SIZE),
             peer,
@@ -77,6 +134,10 @@ impl GameServerThread {
             game_server,
             awaiting_termination: AtomicBool::new(false),
             account_data: SyncMutex::new(PlayerAccountData::default()),
+            snapshot_history: SyncMutex::new(SnapshotHistory::new()),
+            reliable: SyncMutex::new(ReliableChannel::new()),
+            replying_reliably: AtomicBool::new(false),
+            fragments: SyncMutex::new(FragmentHistory::new()),
             last_voice_packet: AtomicU64::new(0),
             cleanup_notify: Notify::new(),
             cleanup_mutex: Mutex::new(()),
@@ -89,12 +150,21 @@ impl GameServerThread {
                 break;
             }
 
+            // wake up early if a reliable packet has to be sent again
+            let retransmit_in = self.reliable.lock().next_retransmit(Instant::now());
+            let timeout = retransmit_in.map_or(IDLE_TIMEOUT, |until| until.min(IDLE_TIMEOUT));
+
             // safety: we are the only receiver for this channel.
-            match tokio::time::timeout(Duration::from_secs(90), unsafe { self.channel.recv() }).await {
+            match tokio::time::timeout(timeout, unsafe { self.channel.recv() }).await {
                 Ok(Ok(message)) => match self.handle_message(message).await {
                     Ok(()) => {}
                     Err(err) => self.print_error(&err),
                 },
+                Err(_) if retransmit_in.is_some() => {
+                    if let Err(err) = self.retransmit_reliable().await {
+                        self.print_error(&err);
+                    }
+                }
                 Ok(Err(_)) | Err(_) => break, // sender closed | timeout
             };
         }
@@ -145,6 +215,7 @@ impl GameServerThread {
                 PacketHandlingError::MalformedMessage
                 | PacketHandlingError::MalformedCiphertext
                 | PacketHandlingError::MalformedLoginAttempt
+                | PacketHandlingError::UnreliablePacket(_)
                 | PacketHandlingError::MalformedPacketStructure(_)
                 | PacketHandlingError::SocketWouldBlock
                 | PacketHandlingError::Ratelimited
@@ -181,8 +252,12 @@ impl GameServerThread {
         self.send_packet_dynamic(&ServerDisconnectPacket { message }).await
     }
 
-    /// sends a buffer to our peer via the socket
+    /// sends a buffer to our peer via the socket, split into fragments if it's too big
     async fn send_buffer(&self, buffer: &[u8]) -> Result<()> {
+        if buffer.len() > ServerFragmentPacket::MAX_DATA_SIZE {
+            return self.send_fragmented(buffer).await;
+        }
+
         self.game_server
             .socket
             .send_to(buffer, self.peer)
@@ -193,9 +268,14 @@ impl GameServerThread {
 
     /// attempt to send a buffer immediately to the socket, but if it requires blocking then returns an error
     fn send_buffer_immediate(&self, buffer: &[u8]) -> Result<()> {
+        // fragmenting takes multiple sends, so let the caller fall back to `send_buffer`
+        if buffer.len() > ServerFragmentPacket::MAX_DATA_SIZE {
+            return Err(PacketHandlingError::SocketWouldBlock);
+        }
+
         self.game_server
             .socket
-            .try_send_to(buffer, std::net::SocketAddr::V4(self.peer))
+            .try_send_to(buffer, self.peer)
             .map(|_| ())
             .map_err(|e| {
                 if e.kind() == std::io::ErrorKind::WouldBlock {
@@ -206,6 +286,49 @@ impl GameServerThread {
             })
     }
 
+    /// split a datagram into `ServerFragmentPacket`s and send them. the client reassembles it and asks
+    /// for any fragments that didn't arrive with a `FragmentRequestPacket`, see `handle_fragment_request`.
+    async fn send_fragmented(&self, datagram: &[u8]) -> Result<()> {
+        let count = datagram.len().div_ceil(ServerFragmentPacket::MAX_DATA_SIZE);
+        if count > ServerFragmentPacket::MAX_FRAGMENTS {
+            return Err(PacketHandlingError::Other(format!(
+                "datagram is too big to be fragmented ({} bytes)",
+                datagram.len()
+            )));
+        }
+
+        let message_id = self.fragments.lock().store(datagram, Instant::now());
+
+        for index in 0..count {
+            self.send_fragment(message_id, index, datagram).await?;
+        }
+
+        Ok(())
+    }
+
+    async fn send_fragment(&self, message_id: u32, index: usize, datagram: &[u8]) -> Result<()> {
+        let count = datagram.len().div_ceil(ServerFragmentPacket::MAX_DATA_SIZE);
+        let start = index * ServerFragmentPacket::MAX_DATA_SIZE;
+        let end = (start + ServerFragmentPacket::MAX_DATA_SIZE).min(datagram.len());
+
+        let mut data = [0u8; PacketHeader::SIZE + ServerFragmentPacket::HEADER_SIZE + ServerFragmentPacket::MAX_DATA_SIZE];
+        let mut buf = FastByteBuffer::new(&mut data);
+        buf.write_packet_header::<ServerFragmentPacket>();
+        buf.write_u32(message_id);
+        buf.write_u16(index as u16);
+        buf.write_u16(count as u16);
+        buf.write_bytes(&datagram[start..end]);
+
+        let len = buf.len();
+
+        self.game_server
+            .socket
+            .send_to(&data[..len], self.peer)
+            .await
+            .map(|_size| ())
+            .map_err(PacketHandlingError::SocketSendFailed)
+    }
+
     fn is_chat_packet_allowed(&self, voice: bool, len: usize) -> bool {
         let accid = self.account_id.load(Ordering::Relaxed);
         if accid == 0 {
@@ -321,35 +444,183 @@ impl GameServerThread {
             data = ByteReader::from_bytes(&message[ciphertext_start..]);
         }
 
-        match header.packet_id {
+        if header.packet_id == BundlePacket::PACKET_ID || header.packet_id == ReliablePacket::PACKET_ID {
+            let body_start = if header.encrypted {
+                PacketHeader::SIZE + NONCE_SIZE + MAC_SIZE
+            } else {
+                PacketHeader::SIZE
+            };
+
+            return if header.packet_id == BundlePacket::PACKET_ID {
+                self.handle_bundle(&message[body_start..], header.encrypted).await
+            } else {
+                self.handle_reliable(&message[body_start..], header.encrypted).await
+            };
+        }
+
+        self.handle_single_packet(header.packet_id, &mut data).await
+    }
+
+    /// handle every packet in a bundle. the entries are already decrypted, if the bundle was encrypted.
+    /// a packet that fails to be handled doesn't stop the rest of the bundle from being handled.
+    async fn handle_bundle(&self, mut bundle: &[u8], encrypted: bool) -> Result<()> {
+        while !bundle.is_empty() {
+            if bundle.len() < BundlePacket::ENTRY_HEADER_SIZE {
+                return Err(PacketHandlingError::MalformedMessage);
+            }
+
+            let packet_id = u16::from_be_bytes([bundle[0], bundle[1]]);
+            let len = u16::from_be_bytes([bundle[2], bundle[3]]) as usize;
+            bundle = &bundle[BundlePacket::ENTRY_HEADER_SIZE..];
+
+            if len > bundle.len() || packet_id == BundlePacket::PACKET_ID {
+                return Err(PacketHandlingError::MalformedMessage);
+            }
+
+            let (entry, rest) = bundle.split_at(len);
+            bundle = rest;
+
+            if packet_id == ReliablePacket::PACKET_ID {
+                if let Err(err) = self.handle_reliable(entry, encrypted).await {
+                    self.print_error(&err);
+                }
+
+                continue;
+            }
+
+            // same checks as in `handle_packet`
+            if (packet_id == VoicePacket::PACKET_ID || packet_id == ChatMessagePacket::PACKET_ID)
+                && !self.is_chat_packet_allowed(packet_id == VoicePacket::PACKET_ID, standalone_packet_size(len, encrypted))
+            {
+                continue;
+            }
+
+            if packet_id == LoginPacket::PACKET_ID && !encrypted {
+                return Err(PacketHandlingError::MalformedLoginAttempt);
+            }
+
+            let mut data = ByteReader::from_bytes(entry);
+            if let Err(err) = self.handle_single_packet(packet_id, &mut data).await {
+                self.print_error(&err);
+            }
+        }
+
+        Ok(())
+    }
+
+    /// handle a packet from the reliable channel. it is handled right away if it's the next one in order,
+    /// otherwise it waits in the channel until the packets before it arrive. duplicates are only acknowledged.
+    async fn handle_reliable(&self, message: &[u8], encrypted: bool) -> Result<()> {
+        if message.len() < ReliablePacket::HEADER_SIZE {
+            return Err(PacketHandlingError::MalformedMessage);
+        }
+
+        let sequence = u32::from_be_bytes([message[0], message[1], message[2], message[3]]);
+        let ack = u32::from_be_bytes([message[4], message[5], message[6], message[7]]);
+        let ack_bits = u32::from_be_bytes([message[8], message[9], message[10], message[11]]);
+        let packet_id = u16::from_be_bytes([message[12], message[13]]);
+        let entry = &message[ReliablePacket::HEADER_SIZE..];
+
+        // this also keeps out voice and chat packets, which would skip the checks in `handle_packet`
+        if !is_reliable_packet(packet_id) {
+            return Err(PacketHandlingError::UnreliablePacket(packet_id));
+        }
+
+        // same check as in `handle_packet`
+        if packet_id == LoginPacket::PACKET_ID && !encrypted {
+            return Err(PacketHandlingError::MalformedLoginAttempt);
+        }
+
+        let handle_now = {
+            let mut reliable = self.reliable.lock();
+            reliable.acknowledge(ack, ack_bits, Instant::now());
+            reliable.receive(sequence, packet_id, entry)
+        };
+
+        if handle_now {
+            self.handle_reliable_entry(packet_id, entry).await;
+
+            loop {
+                // the lock must not be held while handling the packet
+                let early = self.reliable.lock().pop_early();
+                let Some((packet_id, entry)) = early else {
+                    break;
+                };
+
+                self.handle_reliable_entry(packet_id, &entry).await;
+            }
+        }
+
+        // if nothing was sent back through the channel, the ack hasn't been sent yet
+        let ack = {
+            let mut reliable = self.reliable.lock();
+            reliable.ack_pending().then(|| reliable.take_ack())
+        };
+
+        if let Some((ack, ack_bits)) = ack {
+            self.send_packet_static(&ServerReliableAckPacket { ack, ack_bits }).await?;
+        }
+
+        Ok(())
+    }
+
+    async fn handle_reliable_entry(&self, packet_id: u16, entry: &[u8]) {
+        self.replying_reliably.store(true, Ordering::Relaxed);
+
+        let mut data = ByteReader::from_bytes(entry);
+        let result = self.handle_single_packet(packet_id, &mut data).await;
+
+        self.replying_reliably.store(false, Ordering::Relaxed);
+
+        if let Err(err) = result {
+            self.print_error(&err);
+        }
+    }
+
+    /// send the reliable packets that haven't been acknowledged in time again
+    async fn retransmit_reliable(&self) -> Result<()> {
+        let datagrams = self.reliable.lock().poll_retransmits(Instant::now());
+
+        for datagram in datagrams {
+            self.send_buffer(&datagram).await?;
+        }
+
+        Ok(())
+    }
+
+    /// handle a single decrypted packet
+    async fn handle_single_packet(&self, packet_id: u16, data: &mut ByteReader<'_>) -> Result<()> {
+        match packet_id {
             /* connection related */
-            PingPacket::PACKET_ID => self.handle_ping(&mut data).await,
-            CryptoHandshakeStartPacket::PACKET_ID => self.handle_crypto_handshake(&mut data).await,
-            KeepalivePacket::PACKET_ID => self.handle_keepalive(&mut data).await,
-            LoginPacket::PACKET_ID => self.handle_login(&mut data).await,
-            DisconnectPacket::PACKET_ID => self.handle_disconnect(&mut data),
+            PingPacket::PACKET_ID => self.handle_ping(data).await,
+            CryptoHandshakeStartPacket::PACKET_ID => self.handle_crypto_handshake(data).await,
+            KeepalivePacket::PACKET_ID => self.handle_keepalive(data).await,
+            LoginPacket::PACKET_ID => self.handle_login(data).await,
+            DisconnectPacket::PACKET_ID => self.handle_disconnect(data),
+            ReliableAckPacket::PACKET_ID => self.handle_reliable_ack(data),
+            FragmentRequestPacket::PACKET_ID => self.handle_fragment_request(data).await,
 
             /* general */
-            SyncIconsPacket::PACKET_ID => self.handle_sync_icons(&mut data).await,
-            RequestGlobalPlayerListPacket::PACKET_ID => self.handle_request_global_list(&mut data).await,
-            CreateRoomPacket::PACKET_ID => self.handle_create_room(&mut data).await,
-            JoinRoomPacket::PACKET_ID => self.handle_join_room(&mut data).await,
-            LeaveRoomPacket::PACKET_ID => self.handle_leave_room(&mut data).await,
-            RequestRoomPlayerListPacket::PACKET_ID => self.handle_request_room_list(&mut data).await,
-            RequestLevelListPacket::PACKET_ID => self.handle_request_level_list(&mut data).await,
+            SyncIconsPacket::PACKET_ID => self.handle_sync_icons(data).await,
+            RequestGlobalPlayerListPacket::PACKET_ID => self.handle_request_global_list(data).await,
+            CreateRoomPacket::PACKET_ID => self.handle_create_room(data).await,
+            JoinRoomPacket::PACKET_ID => self.handle_join_room(data).await,
+            LeaveRoomPacket::PACKET_ID => self.handle_leave_room(data).await,
+            RequestRoomPlayerListPacket::PACKET_ID => self.handle_request_room_list(data).await,
+            RequestLevelListPacket::PACKET_ID => self.handle_request_level_list(data).await,
 
             /* game related */
-            RequestPlayerProfilesPacket::PACKET_ID => self.handle_request_profiles(&mut data).await,
-            LevelJoinPacket::PACKET_ID => self.handle_level_join(&mut data).await,
-            LevelLeavePacket::PACKET_ID => self.handle_level_leave(&mut data).await,
-            PlayerDataPacket::PACKET_ID => self.handle_player_data(&mut data).await,
+            RequestPlayerProfilesPacket::PACKET_ID => self.handle_request_profiles(data).await,
+            LevelJoinPacket::PACKET_ID => self.handle_level_join(data).await,
+            LevelLeavePacket::PACKET_ID => self.handle_level_leave(data).await,
+            PlayerDataPacket::PACKET_ID => self.handle_player_data(data).await,
 
-            VoicePacket::PACKET_ID => self.handle_voice(&mut data).await,
-            ChatMessagePacket::PACKET_ID => self.handle_chat_message(&mut data).await,
+            VoicePacket::PACKET_ID => self.handle_voice(data).await,
+            ChatMessagePacket::PACKET_ID => self.handle_chat_message(data).await,
 
             /* admin related */
-            AdminAuthPacket::PACKET_ID => self.handle_admin_auth(&mut data).await,
-            AdminSendNoticePacket::PACKET_ID => self.handle_admin_send_notice(&mut data).await,
+            AdminAuthPacket::PACKET_ID => self.handle_admin_auth(data).await,
+            AdminSendNoticePacket::PACKET_ID => self.handle_admin_send_notice(data).await,
             x => Err(PacketHandlingError::NoHandler(x)),
         }
     }
@@ -390,6 +661,24 @@ impl GameServerThread {
     where
         F: FnOnce(&mut FastByteBuffer),
     {
+        if !P::ENCRYPTED && packet_size >= ServerCompressedPacket::THRESHOLD && is_compressible(P::PACKET_ID) {
+            return self.send_packet_compressed::<P, F>(packet_size, encode_fn).await;
+        }
+
+        self.send_packet_uncompressed::<P, F>(packet_size, encode_fn).await
+    }
+
+    /// `send_packet_alloca_with` without the compression step. it's separate so that sending the compressed packet
+    /// doesn't make the future recursive.
+    #[inline]
+    async fn send_packet_uncompressed<P: Packet, F>(&self, packet_size: usize, encode_fn: F) -> Result<()>
+    where
+        F: FnOnce(&mut FastByteBuffer),
+    {
+        if self.replying_reliably.load(Ordering::Relaxed) && P::PACKET_ID != ServerReliableAckPacket::PACKET_ID {
+            return self.send_packet_reliable::<P, F>(packet_size, encode_fn).await;
+        }
+
         if cfg!(debug_assertions) && P::PACKET_ID != KeepaliveResponsePacket::PACKET_ID {
             self.print_packet::<P>(true, Some(if P::ENCRYPTED { "fast + encrypted" } else { "fast" }));
         }
@@ -451,4 +740,94 @@ impl GameServerThread {
 
         Ok(())
     }
+
+    /// encode the packet and send it compressed in a `ServerCompressedPacket`, or as-is if it didn't get any smaller.
+    /// this allocates, but it's only used for big lists that are sent rarely.
+    async fn send_packet_compressed<P: Packet, F>(&self, packet_size: usize, encode_fn: F) -> Result<()>
+    where
+        F: FnOnce(&mut FastByteBuffer),
+    {
+        let mut raw = vec![0u8; packet_size];
+        let mut buf = FastByteBuffer::new(&mut raw);
+        encode_fn(&mut buf);
+        let raw_len = buf.len();
+        let raw = &raw[..raw_len];
+
+        let mut compressed =
+            Vec::with_capacity(ServerCompressedPacket::HEADER_SIZE + compression::max_compressed_size(raw_len));
+        compressed.extend_from_slice(&P::PACKET_ID.to_be_bytes());
+        compressed.extend_from_slice(&(raw_len as u32).to_be_bytes());
+        compression::compress(raw, &mut compressed);
+
+        if compressed.len() >= raw_len {
+            return self
+                .send_packet_uncompressed::<P, _>(raw_len, |buf| buf.write_bytes(raw))
+                .await;
+        }
+
+        if cfg!(debug_assertions) {
+            self.print_packet::<P>(true, Some(&format!("compressed, {raw_len} -> {} bytes", compressed.len())));
+        }
+
+        self.send_packet_uncompressed::<ServerCompressedPacket, _>(compressed.len(), |buf| buf.write_bytes(&compressed))
+            .await
+    }
+
+    /// send the packet wrapped in a `ServerReliablePacket`, and keep it until the client acknowledges it.
+    /// the ack for the client's packets is piggybacked on it. unlike the other functions this allocates,
+    /// since the datagram has to be stored for retransmission anyway.
+    async fn send_packet_reliable<P: Packet, F>(&self, packet_size: usize, encode_fn: F) -> Result<()>
+    where
+        F: FnOnce(&mut FastByteBuffer),
+    {
+        if cfg!(debug_assertions) {
+            self.print_packet::<P>(true, Some(if P::ENCRYPTED { "reliable + encrypted" } else { "reliable" }));
+        }
+
+        let body_start = if P::ENCRYPTED {
+            PacketHeader::SIZE + NONCE_SIZE + MAC_SIZE
+        } else {
+            PacketHeader::SIZE
+        };
+
+        let mut datagram = vec![0u8; body_start + ReliablePacket::HEADER_SIZE + packet_size];
+
+        let mut buf = FastByteBuffer::new(&mut datagram);
+        buf.write_value(&PacketHeader {
+            packet_id: ServerReliablePacket::PACKET_ID,
+            encrypted: P::ENCRYPTED,
+        });
+
+        let (sequence, ack, ack_bits) = {
+            let mut reliable = self.reliable.lock();
+            let (ack, ack_bits) = reliable.take_ack();
+            (reliable.next_sequence(), ack, ack_bits)
+        };
+
+        let mut buf = FastByteBuffer::new(&mut datagram[body_start..]);
+        buf.write_u32(sequence);
+        buf.write_u32(ack);
+        buf.write_u32(ack_bits);
+        buf.write_u16(P::PACKET_ID);
+        encode_fn(&mut buf);
+
+        let body_end = body_start + buf.len();
+        datagram.truncate(body_end);
+
+        if P::ENCRYPTED {
+            // this unwrap is safe for the same reason as in `send_packet_alloca_with`
+            let cbox = self.crypto_box.get().unwrap();
+
+            let nonce = ChaChaBox::generate_nonce(&mut OsRng);
+            let tag = cbox
+                .encrypt_in_place_detached(&nonce, b"", &mut datagram[body_start..])
+                .map_err(|_| PacketHandlingError::EncryptionError)?;
+
+            datagram[PacketHeader::SIZE..PacketHeader::SIZE + NONCE_SIZE].copy_from_slice(&nonce);
+            datagram[PacketHeader::SIZE + NONCE_SIZE..body_start].copy_from_slice(&tag);
+        }
+
+        self.reliable.lock().track(sequence, datagram.clone(), Instant::now());
+        self.send_buffer(&datagram).await
+    }
 }
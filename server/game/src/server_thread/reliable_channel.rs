@@ -0,0 +1,183 @@
+use std::{
+    collections::{BTreeMap, VecDeque},
+    time::{Duration, Instant},
+};
+
+/// how far past the next expected packet we accept packets out of order. also the number of bits in a selective ack.
+const RECEIVE_WINDOW: u32 = 32;
+/// retransmission timeout until the first round trip is measured
+const INITIAL_RTO: Duration = Duration::from_millis(500);
+const MIN_RTO: Duration = Duration::from_millis(100);
+const MAX_RTO: Duration = Duration::from_secs(3);
+/// a packet that still isn't acknowledged after this many retransmissions is dropped, the client is most likely gone
+const MAX_RETRANSMITS: u32 = 8;
+
+struct Unacked {
+    sequence: u32,
+    datagram: Vec<u8>,
+    sent_at: Instant,
+    retransmits: u32,
+}
+
+/// `ReliableChannel` is the state of the reliable ordered channel with one client, see `GameServerThread::handle_reliable`.
+/// Sent packets are kept until the client acknowledges them, and sent again once the retransmission timeout
+/// (derived from the measured round trip time) passes. Received packets are handled in order,
+/// packets that arrive early are held until everything before them has arrived.
+#[derive(Default)]
+pub struct ReliableChannel {
+    next_sequence: u32,
+    unacked: VecDeque<Unacked>,
+    srtt: Option<Duration>,
+    rttvar: Duration,
+
+    next_expected: u32,
+    early: BTreeMap<u32, (u16, Vec<u8>)>,
+    ack_pending: bool,
+}
+
+impl ReliableChannel {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// sequence number for the next outgoing packet
+    pub fn next_sequence(&mut self) -> u32 {
+        let sequence = self.next_sequence;
+        self.next_sequence += 1;
+        sequence
+    }
+
+    /// keep a sent datagram around until the client acknowledges it
+    pub fn track(&mut self, sequence: u32, datagram: Vec<u8>, now: Instant) {
+        self.unacked.push_back(Unacked {
+            sequence,
+            datagram,
+            sent_at: now,
+            retransmits: 0,
+        });
+    }
+
+    /// whether the client has sent something that we haven't acknowledged yet
+    pub fn ack_pending(&self) -> bool {
+        self.ack_pending
+    }
+
+    /// the cumulative ack (next sequence number we expect) and the selective ack bits, where bit `n` means
+    /// that packet `ack + 1 + n` has arrived. this clears the pending ack, so it must be sent to the client.
+    pub fn take_ack(&mut self) -> (u32, u32) {
+        self.ack_pending = false;
+
+        let ack_bits = self
+            .early
+            .keys()
+            .fold(0u32, |bits, &sequence| bits | (1 << (sequence - self.next_expected - 1)));
+
+        (self.next_expected, ack_bits)
+    }
+
+    /// handle an ack from the client
+    pub fn acknowledge(&mut self, ack: u32, ack_bits: u32, now: Instant) {
+        let mut rtt_sample = None;
+
+        self.unacked.retain(|packet| {
+            let acked = packet.sequence < ack || {
+                let offset = packet.sequence - ack;
+                offset > 0 && offset <= RECEIVE_WINDOW && ack_bits & (1 << (offset - 1)) != 0
+            };
+
+            // a retransmitted packet doesn't tell which of the copies got acknowledged, so it can't be used to measure the rtt
+            if acked && packet.retransmits == 0 {
+                rtt_sample = Some(now.saturating_duration_since(packet.sent_at));
+            }
+
+            !acked
+        });
+
+        if let Some(sample) = rtt_sample {
+            self.update_rtt(sample);
+        }
+    }
+
+    /// handle an incoming packet. returns `true` if it is the next one in order and should be handled now,
+    /// after which `pop_early` returns the packets that were waiting for it. duplicates and early packets return `false`.
+    pub fn receive(&mut self, sequence: u32, packet_id: u16, data: &[u8]) -> bool {
+        // acknowledge duplicates too, as our previous ack was likely lost
+        self.ack_pending = true;
+
+        if sequence == self.next_expected {
+            self.next_expected += 1;
+            return true;
+        }
+
+        if sequence > self.next_expected && sequence - self.next_expected <= RECEIVE_WINDOW {
+            self.early.entry(sequence).or_insert_with(|| (packet_id, data.to_vec()));
+        }
+
+        false
+    }
+
+    /// the next early packet that can now be handled, in order
+    pub fn pop_early(&mut self) -> Option<(u16, Vec<u8>)> {
+        let packet = self.early.remove(&self.next_expected)?;
+        self.next_expected += 1;
+        Some(packet)
+    }
+
+    /// time until the next retransmission is due, `None` if nothing is waiting for an ack
+    pub fn next_retransmit(&self, now: Instant) -> Option<Duration> {
+        let rto = self.rto();
+
+        self.unacked
+            .iter()
+            .map(|packet| Self::deadline(packet, rto).saturating_duration_since(now))
+            .min()
+    }
+
+    /// datagrams that have to be sent again now. packets that were retransmitted too many times are dropped.
+    pub fn poll_retransmits(&mut self, now: Instant) -> Vec<Vec<u8>> {
+        let rto = self.rto();
+        let mut datagrams = Vec::new();
+
+        self.unacked.retain_mut(|packet| {
+            if now < Self::deadline(packet, rto) {
+                return true;
+            }
+
+            if packet.retransmits >= MAX_RETRANSMITS {
+                return false;
+            }
+
+            packet.retransmits += 1;
+            packet.sent_at = now;
+            datagrams.push(packet.datagram.clone());
+            true
+        });
+
+        datagrams
+    }
+
+    fn update_rtt(&mut self, sample: Duration) {
+        // same smoothing as tcp (rfc 6298)
+        match self.srtt {
+            None => {
+                self.srtt = Some(sample);
+                self.rttvar = sample / 2;
+            }
+            Some(srtt) => {
+                let diff = if srtt > sample { srtt - sample } else { sample - srtt };
+                self.rttvar = (self.rttvar * 3 + diff) / 4;
+                self.srtt = Some((srtt * 7 + sample) / 8);
+            }
+        }
+    }
+
+    fn rto(&self) -> Duration {
+        self.srtt
+            .map_or(INITIAL_RTO, |srtt| (srtt + self.rttvar * 4).clamp(MIN_RTO, MAX_RTO))
+    }
+
+    /// when the packet should be sent again, the timeout doubles with every retransmission
+    fn deadline(packet: &Unacked, rto: Duration) -> Instant {
+        packet.sent_at + (rto * (1 << packet.retransmits)).min(MAX_RTO)
+    }
+}
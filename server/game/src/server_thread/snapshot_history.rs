@@ -0,0 +1,97 @@
+use crate::data::*;
+
+/// how many sent `LevelDataPacket`s are remembered. the client must remember at least as many.
+const HISTORY_SIZE: usize = 8;
+
+#[derive(Default)]
+struct Snapshot {
+    sequence: u32,
+    players: Vec<(i32, PlayerData)>, // sorted by account ID
+}
+
+/// `SnapshotHistory` remembers the player data sent in the last few `LevelDataPacket`s to a client,
+/// so that new packets can be delta encoded against the latest one that the client has acknowledged.
+/// If the acknowledged snapshot is too old (or there is none), full data is sent instead.
+#[derive(Default)]
+pub struct SnapshotHistory {
+    snapshots: [Snapshot; HISTORY_SIZE],
+    sequence: u32,
+    acknowledged: u32,
+}
+
+impl SnapshotHistory {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// forget everything, the next packet will contain full data
+    pub fn reset(&mut self) {
+        *self = Self::default();
+    }
+
+    pub fn acknowledge(&mut self, sequence: u32) {
+        // the client can never acknowledge a packet we haven't sent yet
+        if sequence > self.acknowledged && sequence <= self.sequence {
+            self.acknowledged = sequence;
+        }
+    }
+
+    /// start a new snapshot, returns its sequence number and the sequence number of the baseline (0 if none)
+    pub fn begin(&mut self) -> (u32, u32) {
+        self.sequence += 1;
+
+        let baseline = if self.acknowledged != 0
+            && self.sequence - self.acknowledged < HISTORY_SIZE as u32
+            && self.has_snapshot(self.acknowledged)
+        {
+            self.acknowledged
+        } else {
+            0
+        };
+
+        // the baseline is always in a different slot, as it's less than `HISTORY_SIZE` packets old
+        let current = &mut self.snapshots[self.sequence as usize % HISTORY_SIZE];
+        current.sequence = 0; // invalid until `finish` is called
+        current.players.clear();
+
+        (self.sequence, baseline)
+    }
+
+    /// encode the data of a player in the current snapshot, relative to the baseline if there is one
+    pub fn encode_player(&mut self, buf: &mut FastByteBuffer, baseline: u32, account_id: i32, data: &PlayerData) {
+        let base = if baseline == 0 {
+            None
+        } else {
+            let snapshot = &self.snapshots[baseline as usize % HISTORY_SIZE];
+            snapshot
+                .players
+                .binary_search_by_key(&account_id, |(id, _)| *id)
+                .ok()
+                .map(|idx| &snapshot.players[idx].1)
+        };
+
+        match base {
+            Some(base) => data.encode_relative(buf, base),
+            None => buf.write_value(data),
+        }
+
+        // players that haven't sent any data are not remembered, the client doesn't keep them either
+        if !data.is_empty() {
+            self.snapshots[self.sequence as usize % HISTORY_SIZE]
+                .players
+                .push((account_id, data.clone()));
+        }
+    }
+
+    /// finish the current snapshot, making it usable as a baseline once the client acknowledges it
+    pub fn finish(&mut self) {
+        let current = &mut self.snapshots[self.sequence as usize % HISTORY_SIZE];
+        current.players.sort_unstable_by_key(|(id, _)| *id);
+        current.sequence = self.sequence;
+    }
+
+    /// returns whether the snapshot with the given sequence number is still remembered
+    fn has_snapshot(&self, sequence: u32) -> bool {
+        self.snapshots[sequence as usize % HISTORY_SIZE].sequence == sequence
+    }
+}
@@ -0,0 +1,203 @@
+//! LZ77 compression in the LZ4 block format, primed with a small static dictionary of byte patterns
+//! that are common in list packets. Used for sending big lists, see `ServerCompressedPacket`.
+//!
+//! The dictionary has to be byte for byte the same as the one in the client (`src/util/compression.cpp`).
+
+const MIN_MATCH: usize = 4;
+/// the format requires the last 5 bytes to be literals, and the last match to start at least 12 bytes before the end
+const LAST_LITERALS: usize = 5;
+const MATCH_LIMIT: usize = 12;
+const MAX_OFFSET: usize = 65535;
+
+const HASH_BITS: u32 = 12;
+
+/// sits right before the data, so matches can reference it like data that came earlier.
+/// zeroes, the encoded default icons, unset glow colors and special user data, and a couple of list entries.
+/// picked by hand from the layout of the list packets, it's not trained on captured traffic since there were no captures
+/// from real servers to train it on. `globed-dict` (bench/src/dict.cpp) builds one from GLOBED_CAPTURE files, replace it
+/// with that output once there are some, here and in the client at the same time.
+const DICTIONARY: [u8; 105] = [
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //
+    0x00, 0x00, 0x00, 0x06, 0x50, 0x6c, 0x61, 0x79, 0x65, 0x72, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, //
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, //
+    0x00, 0x03, 0xff, 0xff, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0xff, 0xff, 0x00, 0x00, 0x00, //
+    0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x03, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff, 0x00, 0x01, 0x00, //
+    0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, //
+    0x02, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+];
+
+/// compressed size of `len` bytes in the worst case, when nothing in them can be compressed
+pub const fn max_compressed_size(len: usize) -> usize {
+    len + len / 255 + 16
+}
+
+#[inline]
+fn read32(data: &[u8], pos: usize) -> u32 {
+    u32::from_ne_bytes([data[pos], data[pos + 1], data[pos + 2], data[pos + 3]])
+}
+
+#[inline]
+fn hash(sequence: u32) -> usize {
+    (sequence.wrapping_mul(2_654_435_761) >> (32 - HASH_BITS)) as usize
+}
+
+/// lengths that don't fit in the 4 bits of the token continue in bytes of 255, ending with a smaller one
+fn write_length(out: &mut Vec<u8>, mut len: usize) {
+    while len >= 255 {
+        out.push(255);
+        len -= 255;
+    }
+
+    out.push(len as u8);
+}
+
+fn read_length(src: &[u8], pos: &mut usize) -> Option<usize> {
+    let mut value = 0usize;
+
+    loop {
+        let next = *src.get(*pos)?;
+        *pos += 1;
+        value += next as usize;
+
+        if next != 255 {
+            return Some(value);
+        }
+    }
+}
+
+/// a match length of 0 means the sequence is only literals, which is how the last one has to be
+fn write_sequence(out: &mut Vec<u8>, literals: &[u8], offset: usize, match_len: usize) {
+    let token_pos = out.len();
+    out.push((literals.len().min(15) as u8) << 4);
+
+    if literals.len() >= 15 {
+        write_length(out, literals.len() - 15);
+    }
+
+    out.extend_from_slice(literals);
+
+    if match_len == 0 {
+        return;
+    }
+
+    out.extend_from_slice(&(offset as u16).to_le_bytes());
+
+    let match_len = match_len - MIN_MATCH;
+    out[token_pos] |= match_len.min(15) as u8;
+
+    if match_len >= 15 {
+        write_length(out, match_len - 15);
+    }
+}
+
+/// compress `src`, appending the compressed data to `out`
+pub fn compress(src: &[u8], out: &mut Vec<u8>) {
+    // matches are found in one contiguous buffer of the dictionary followed by the data
+    let mut window = Vec::with_capacity(DICTIONARY.len() + src.len());
+    window.extend_from_slice(&DICTIONARY);
+    window.extend_from_slice(src);
+
+    let end = window.len();
+
+    // last position of every hashed 4 byte sequence. entries that were never set point at the start of the dictionary,
+    // which is fine since a candidate is always compared before being used.
+    let mut table = [0u32; 1 << HASH_BITS];
+    for i in 0..=(DICTIONARY.len() - MIN_MATCH) {
+        table[hash(read32(&window, i))] = i as u32;
+    }
+
+    out.reserve(max_compressed_size(src.len()));
+
+    let mut anchor = DICTIONARY.len();
+    let mut ip = DICTIONARY.len();
+
+    while ip + MATCH_LIMIT <= end {
+        let sequence = read32(&window, ip);
+        let slot = hash(sequence);
+        let mut candidate = table[slot] as usize;
+        table[slot] = ip as u32;
+
+        if ip - candidate > MAX_OFFSET || read32(&window, candidate) != sequence {
+            ip += 1;
+            continue;
+        }
+
+        let match_end = end - LAST_LITERALS;
+        let mut match_len = MIN_MATCH;
+        while ip + match_len < match_end && window[candidate + match_len] == window[ip + match_len] {
+            match_len += 1;
+        }
+
+        // the match might also start a bit earlier than where the hash found it
+        while ip > anchor && candidate > 0 && window[ip - 1] == window[candidate - 1] {
+            ip -= 1;
+            candidate -= 1;
+            match_len += 1;
+        }
+
+        write_sequence(out, &window[anchor..ip], ip - candidate, match_len);
+
+        ip += match_len;
+        anchor = ip;
+
+        // positions inside the match aren't hashed, except for one near its end, so the next match can begin there
+        if ip + MATCH_LIMIT <= end {
+            table[hash(read32(&window, ip - 2))] = (ip - 2) as u32;
+        }
+    }
+
+    write_sequence(out, &window[anchor..], 0, 0);
+}
+
+/// decompress data that is exactly `raw_len` bytes long uncompressed, `None` if it's malformed
+pub fn decompress(src: &[u8], raw_len: usize) -> Option<Vec<u8>> {
+    let mut out = Vec::with_capacity(raw_len);
+    let mut ip = 0usize;
+
+    loop {
+        let token = *src.get(ip)?;
+        ip += 1;
+
+        let mut literal_count = (token >> 4) as usize;
+        if literal_count == 15 {
+            literal_count += read_length(src, &mut ip)?;
+        }
+
+        if literal_count > src.len() - ip || literal_count > raw_len - out.len() {
+            return None;
+        }
+
+        out.extend_from_slice(&src[ip..ip + literal_count]);
+        ip += literal_count;
+
+        if ip == src.len() {
+            break;
+        }
+
+        let offset = u16::from_le_bytes([*src.get(ip)?, *src.get(ip + 1)?]) as usize;
+        ip += 2;
+
+        let mut match_len = (token & 15) as usize;
+        if match_len == 15 {
+            match_len += read_length(src, &mut ip)?;
+        }
+        match_len += MIN_MATCH;
+
+        if offset == 0 || offset > out.len() + DICTIONARY.len() || match_len > raw_len - out.len() {
+            return None;
+        }
+
+        // byte by byte, since the match can overlap itself or start in the dictionary
+        for _ in 0..match_len {
+            let byte = if offset > out.len() {
+                DICTIONARY[DICTIONARY.len() - (offset - out.len())]
+            } else {
+                out[out.len() - offset]
+            };
+
+            out.push(byte);
+        }
+    }
+
+    (out.len() == raw_len).then_some(out)
+}
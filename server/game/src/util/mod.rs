@@ -1,4 +1,5 @@
 pub mod channel;
+pub mod compression;
 pub mod lockfreemutcell;
 pub mod rate_limiter;
 
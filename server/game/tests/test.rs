@@ -1,7 +1,7 @@
 // this doc is mostly for flamegraphs
 #![allow(clippy::wildcard_imports)]
 use esp::{ByteBuffer, ByteReader};
-use globed_game_server::{data::*, managers::PlayerManager};
+use globed_game_server::{data::*, managers::PlayerManager, util::compression};
 use std::hint::black_box;
 
 const ITERS: usize = 500_000;
@@ -136,3 +136,64 @@ fn test_player_manager() {
         }
     }
 }
+
+#[test]
+fn test_compression() {
+    let mut buffer = ByteBuffer::new();
+    for i in 0..100 {
+        buffer.write_value(&PlayerAccountData {
+            account_id: 100_000 + i,
+            name: FastString::from_str(&format!("player{i}")),
+            icons: PlayerIconData::default(),
+            special_user_data: None,
+        });
+    }
+
+    let raw = buffer.as_bytes();
+    let mut compressed = Vec::new();
+    compression::compress(raw, &mut compressed);
+
+    assert!(compressed.len() < raw.len() / 2);
+    assert!(compressed.len() <= compression::max_compressed_size(raw.len()));
+    assert_eq!(compression::decompress(&compressed, raw.len()).as_deref(), Some(raw));
+
+    // too short, too long and cut off
+    assert!(compression::decompress(&compressed, raw.len() - 1).is_none());
+    assert!(compression::decompress(&compressed, raw.len() + 1).is_none());
+    assert!(compression::decompress(&compressed[..compressed.len() - 1], raw.len()).is_none());
+
+    // incompressible data and data too short to have any matches
+    let noise: Vec<u8> = (0..1000u32).map(|i| (i.wrapping_mul(2_654_435_761) >> 13) as u8).collect();
+    for data in [&noise[..], &noise[..5], &[]] {
+        let mut compressed = Vec::new();
+        compression::compress(data, &mut compressed);
+        assert_eq!(compression::decompress(&compressed, data.len()).as_deref(), Some(data));
+    }
+}
+
+#[test]
+fn test_varint_list() {
+    let mut stackarray = [0u8; 64];
+    let mut buf = FastByteBuffer::new(&mut stackarray);
+
+    // the prefix keeps the width reserved for the upper bound even if fewer elements are written
+    let written = buf.write_varint_list_with(200, |buf| {
+        for i in 0..3u8 {
+            buf.write_u8(i);
+        }
+        3
+    });
+
+    assert_eq!(written, 3);
+    assert_eq!(size_of_varuint(200), 2);
+    assert_eq!(&stackarray[..5], &[0x83, 0x00, 0, 1, 2]);
+
+    let mut buffer = ByteBuffer::new();
+    buffer.write_varint_list_with(300, |_| 300);
+    assert_eq!(buffer.as_bytes(), &[0xac, 0x02]);
+
+    assert_eq!(size_of_varuint(0), 1);
+    assert_eq!(size_of_varuint(127), 1);
+    assert_eq!(size_of_varuint(128), 2);
+    assert_eq!(size_of_varuint(u32::MAX as usize), 5);
+}
@@ -24,6 +24,10 @@ public:
 #endif // GLOBED_DEBUG
     }
 
+    size_t encodedSize() const {
+        return sizeof(uint32_t) + length;
+    }
+
     GLOBED_ENCODE {
         buf.writeByteArray(ptr, length);
     }
@@ -1,9 +1,15 @@
 #include "frame.hpp"
 
+#include <data/types/audio.hpp>
+
 #if GLOBED_VOICE_SUPPORT
 
 using namespace util::data;
 
+// ReceivedAudioFrame decodes what this encodes
+static_assert(ReceivedAudioFrame::MAX_FRAMES == EncodedAudioFrame::VOICE_MAX_FRAMES_IN_AUDIO_FRAME);
+static_assert(ReceivedAudioFrame::MAX_BYTES_IN_FRAME == VOICE_MAX_BYTES_IN_FRAME);
+
 EncodedAudioFrame::EncodedAudioFrame() : _capacity(VOICE_MAX_FRAMES_IN_AUDIO_FRAME) {}
 EncodedAudioFrame::EncodedAudioFrame(size_t capacity) : _capacity(capacity) {}
 
@@ -48,6 +54,16 @@ const std::vector<EncodedOpusData>& EncodedAudioFrame::getFrames() const {
     return frames;
 }
 
+size_t EncodedAudioFrame::encodedSize() const {
+    // every slot has an optional flag, and only the present frames have data
+    size_t total = VOICE_MAX_FRAMES_IN_AUDIO_FRAME * sizeof(bool);
+    for (auto& frame : frames) {
+        total += frame.encodedSize();
+    }
+
+    return total;
+}
+
 void EncodedAudioFrame::encode(ByteBuffer& buf) const {
     GLOBED_REQUIRE(
         frames.size() <= _capacity,
@@ -66,7 +82,7 @@ void EncodedAudioFrame::encode(ByteBuffer& buf) const {
     }
 }
 
-void EncodedAudioFrame::decode(ByteBuffer& buf) {
+void EncodedAudioFrame::decode(ByteReader& buf) {
     for (size_t i = 0; i < VOICE_MAX_FRAMES_IN_AUDIO_FRAME; i++) {
         auto frame = buf.readOptionalValue<EncodedOpusData>();
         if (frame) frames.push_back(frame.value());
@@ -44,8 +44,9 @@ public:
 
     // implement Serializable
 
+    size_t encodedSize() const;
     void encode(ByteBuffer& buf) const;
-    void decode(ByteBuffer& buf);
+    void decode(ByteReader& buf);
 
 protected:
     mutable std::vector<EncodedOpusData> frames;
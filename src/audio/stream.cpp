@@ -70,10 +70,10 @@ void AudioStream::start() {
     this->channel = GlobedAudioManager::get().playSound(sound);
 }
 
-void AudioStream::writeData(const EncodedAudioFrame& frame) {
-    const auto& frames = frame.getFrames();
-    for (const auto& opusFrame : frames) {
-        auto decodedFrame = decoder.decode(opusFrame);
+void AudioStream::writeData(const ReceivedAudioFrame& frame) {
+    for (size_t i = 0; i < frame.size(); i++) {
+        auto opusFrame = frame[i];
+        auto decodedFrame = decoder.decode(opusFrame.data(), opusFrame.size());
         queue.writeData(decodedFrame);
 
         AudioDecoder::freeData(decodedFrame);
@@ -6,6 +6,7 @@
 #include "frame.hpp"
 #include "sample_queue.hpp"
 #include "decoder.hpp"
+#include <data/types/audio.hpp>
 
 class AudioStream {
 public:
@@ -55,7 +56,7 @@ public:
     // start playing this stream
     void start();
     // write an audio frame to this stream
-    void writeData(const EncodedAudioFrame& frame);
+    void writeData(const ReceivedAudioFrame& frame);
 
     // set the volume of the stream (0.0f - 1.0f)
     void setVolume(float volume);
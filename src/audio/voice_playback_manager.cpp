@@ -4,7 +4,7 @@
 
 #include "manager.hpp"
 
-void VoicePlaybackManager::playFrameStreamed(int playerId, const EncodedAudioFrame& frame) {
+void VoicePlaybackManager::playFrameStreamed(int playerId, const ReceivedAudioFrame& frame) {
     // if the stream doesn't exist yet, create it
     if (!streams.contains(playerId)) {
         this->prepareStream(playerId);
@@ -12,7 +12,7 @@
 */
 class VoicePlaybackManager : public SingletonBase<VoicePlaybackManager> {
 public:
-    void playFrameStreamed(int playerId, const EncodedAudioFrame& frame);
+    void playFrameStreamed(int playerId, const ReceivedAudioFrame& frame);
     void stopAllStreams();
 
     void prepareStream(int playerId);
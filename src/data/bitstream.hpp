@@ -0,0 +1,196 @@
+#pragma once
+#include "bytebuffer.hpp"
+
+#include <exception>
+
+/*
+* BitWriter and BitReader - streaming bit-level access on top of a ByteBuffer / ByteReader (MSB to LSB, like BitBuffer).
+*
+* Unlike BitBuffer, values don't have to add up to whole bytes and there is no limit on the total length,
+* so a 4-bit enum, 3 flags and an 11-bit number take 18 bits (3 bytes) in total.
+* The last byte is zero-padded when the writer is flushed, and the reader only ever consumes whole bytes,
+* so regular byte-aligned writes and reads can continue right after either of them is done.
+*
+* The writer has to be flushed before it's destroyed. Flushing writes to the buffer, which can throw, so the destructor
+* doesn't do it, and debug builds check that it was done instead.
+*/
+
+class BitWriter {
+public:
+    explicit BitWriter(ByteBuffer& buf) : buf(buf) {}
+
+    BitWriter(const BitWriter&) = delete;
+    BitWriter& operator=(const BitWriter&) = delete;
+
+    ~BitWriter() {
+#if defined(GLOBED_DEBUG) && GLOBED_DEBUG
+        // unless an exception is why it's being destroyed
+        GLOBED_HARD_ASSERT(accBits == 0 || std::uncaught_exceptions() > exceptionsOnCreation, "BitWriter destroyed without being flushed")
+#endif
+    }
+
+    void writeBit(bool value) {
+        this->writeBitsRaw(value ? 1 : 0, 1);
+    }
+
+    template <typename... Args> requires (std::same_as<Args, bool> && ...)
+    void writeBits(Args... args) {
+        (writeBit(args), ...);
+    }
+
+    // Write the lowest `bitCount` bits of `value`. Bits above `bitCount` must be zero.
+    void writeUnsigned(uint64_t value, size_t bitCount) {
+        GLOBED_REQUIRE(bitCount <= 64 && (bitCount == 64 || (value >> bitCount) == 0), "value does not fit in the given amount of bits")
+
+        // keep every step at most 32 bits so the accumulator can never overflow
+        if (bitCount > 32) {
+            this->writeBitsRaw(value >> 32, bitCount - 32);
+            bitCount = 32;
+        }
+
+        this->writeBitsRaw(value & lowMask(bitCount), bitCount);
+    }
+
+    // Write a signed integer in two's complement, using `bitCount` bits
+    void writeSigned(int64_t value, size_t bitCount) {
+        GLOBED_REQUIRE(bitCount > 0 && bitCount <= 64, "invalid bit count")
+
+        if (bitCount < 64) {
+            int64_t limit = int64_t(1) << (bitCount - 1);
+            GLOBED_REQUIRE(value >= -limit && value < limit, "value does not fit in the given amount of bits")
+        }
+
+        this->writeUnsigned(static_cast<uint64_t>(value) & lowMask(bitCount), bitCount);
+    }
+
+    // Write an enum, using only `bitCount` bits
+    template <typename E> requires std::is_enum_v<E>
+    void writeEnum(E value, size_t bitCount) {
+        this->writeUnsigned(static_cast<uint64_t>(static_cast<std::underlying_type_t<E>>(value)), bitCount);
+    }
+
+    // Pad the last partial byte with zeroes and write it to the buffer. Must be called once everything is written.
+    void flush() {
+        if (accBits > 0) {
+            buf.writeU8(static_cast<uint8_t>(acc << (8 - accBits)));
+            acc = 0;
+            accBits = 0;
+        }
+    }
+
+    // Returns the amount of bits written so far, including ones that haven't been flushed yet
+    size_t bitsWritten() const {
+        return totalBits;
+    }
+
+    // Returns the amount of bytes `bits` bits take after flushing
+    static constexpr size_t bytesForBits(size_t bits) {
+        return util::data::bitsToBytes(bits);
+    }
+
+private:
+    ByteBuffer& buf;
+    uint64_t acc = 0;
+    size_t accBits = 0;
+    size_t totalBits = 0;
+#if defined(GLOBED_DEBUG) && GLOBED_DEBUG
+    int exceptionsOnCreation = std::uncaught_exceptions();
+#endif
+
+    static constexpr uint64_t lowMask(size_t bits) {
+        return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+
+    // bitCount <= 32, value has no bits above bitCount
+    void writeBitsRaw(uint64_t value, size_t bitCount) {
+        acc = (acc << bitCount) | value;
+        accBits += bitCount;
+        totalBits += bitCount;
+
+        while (accBits >= 8) {
+            accBits -= 8;
+            buf.writeU8(static_cast<uint8_t>(acc >> accBits));
+        }
+
+        acc &= lowMask(accBits);
+    }
+};
+
+class BitReader {
+public:
+    explicit BitReader(ByteReader& buf) : buf(buf) {}
+
+    BitReader(const BitReader&) = delete;
+    BitReader& operator=(const BitReader&) = delete;
+
+    bool readBit() {
+        return this->readBitsRaw(1) != 0;
+    }
+
+    void readBitInto(bool& out) {
+        out = this->readBit();
+    }
+
+    template <typename... Args> requires (std::same_as<Args, bool> && ...)
+    void readBitsInto(Args&... args) {
+        (readBitInto(args), ...);
+    }
+
+    // Read a `bitCount` bits long unsigned integer
+    uint64_t readUnsigned(size_t bitCount) {
+        GLOBED_REQUIRE(bitCount <= 64, "invalid bit count")
+
+        uint64_t value = 0;
+        if (bitCount > 32) {
+            value = this->readBitsRaw(bitCount - 32) << 32;
+            bitCount = 32;
+        }
+
+        return value | this->readBitsRaw(bitCount);
+    }
+
+    // Read a `bitCount` bits long signed integer in two's complement
+    int64_t readSigned(size_t bitCount) {
+        GLOBED_REQUIRE(bitCount > 0 && bitCount <= 64, "invalid bit count")
+
+        uint64_t value = this->readUnsigned(bitCount);
+        if (bitCount < 64 && (value >> (bitCount - 1)) != 0) {
+            // sign extend
+            value |= ~uint64_t(0) << bitCount;
+        }
+
+        return static_cast<int64_t>(value);
+    }
+
+    // Read an enum that was written with `bitCount` bits. Like `ByteReader::readEnum`, the value is not validated.
+    template <typename E> requires std::is_enum_v<E>
+    E readEnum(size_t bitCount) {
+        return static_cast<E>(static_cast<std::underlying_type_t<E>>(this->readUnsigned(bitCount)));
+    }
+
+    // Discard the remaining bits of the current byte. Bytes are only consumed from the underlying reader when needed,
+    // so after this the reader is positioned right after the last byte that contained any bits.
+    void align() {
+        acc = 0;
+        accBits = 0;
+    }
+
+private:
+    ByteReader& buf;
+    uint64_t acc = 0;
+    size_t accBits = 0;
+
+    // bitCount <= 32
+    uint64_t readBitsRaw(size_t bitCount) {
+        while (accBits < bitCount) {
+            acc = (acc << 8) | buf.readU8();
+            accBits += 8;
+        }
+
+        accBits -= bitCount;
+        uint64_t value = (acc >> accBits) & ((uint64_t(1) << bitCount) - 1);
+        acc &= (uint64_t(1) << accBits) - 1;
+
+        return value;
+    }
+};
@@ -1,5 +1,7 @@
 #include "bytebuffer.hpp"
+#include <algorithm>
 #include <cstring> // std::memcpy
+#include <limits>
 
 using namespace util::data;
 
@@ -8,8 +10,8 @@ using namespace util::data;
 #define WRITE_VALUE(type, value) this->write<type>(util::data::maybeByteswap<type>(value));
 
 #define MAKE_READ_FUNC(type, suffix) \
-    type ByteBuffer::read##suffix() { READ_VALUE(type) } \
-    template type ByteBuffer::read<type>();
+    type ByteReader::read##suffix() { READ_VALUE(type) } \
+    template type ByteReader::read<type>();
 
 #define MAKE_WRITE_FUNC(type, suffix) \
     void ByteBuffer::write##suffix(type val) { WRITE_VALUE(type, val) } \
@@ -18,82 +20,214 @@ using namespace util::data;
 #define MAKE_BOTH_FUNCS(type, suffix) MAKE_READ_FUNC(type, suffix) \
     MAKE_WRITE_FUNC(type, suffix)
 
-ByteBuffer::ByteBuffer() : _position(0) {}
-ByteBuffer::ByteBuffer(const bytevector& data) : _data(data), _position(0) {}
-ByteBuffer::ByteBuffer(const byte* data, size_t length) : _data(bytevector(data, data + length)), _position(0) {}
-ByteBuffer::ByteBuffer(util::data::bytevector&& data) : _data(std::move(data)), _position(0) {}
+/* ByteReader */
+
+ByteReader::ByteReader() : _rawData(nullptr), _rawSize(0), _position(0) {}
+ByteReader::ByteReader(const byte* data, size_t length) : _rawData(data), _rawSize(length), _position(0) {}
+ByteReader::ByteReader(const bytevector& data) : _rawData(data.data()), _rawSize(data.size()), _position(0) {}
 
 template <typename T>
-T ByteBuffer::read() {
+T ByteReader::read() {
     this->boundsCheck(sizeof(T));
 
     T value;
-    std::memcpy(&value, _data.data() + _position, sizeof(T));
+    std::memcpy(&value, _rawData + _position, sizeof(T));
     _position += sizeof(T);
     return value;
 }
 
-template <typename T>
-void ByteBuffer::write(T value) {
-    const byte* bytes = reinterpret_cast<const byte*>(&value);
-    _data.insert(_data.end(), bytes, bytes + sizeof(T));
-    _position += sizeof(T);
+bool ByteReader::readBool() {
+    return this->readU8() != 0;
 }
 
-bool ByteBuffer::readBool() {
-    return this->readU8() != 0;
+uint64_t ByteReader::readVarUint() {
+    uint64_t value = 0;
+
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        auto b = this->readU8();
+        value |= static_cast<uint64_t>(b & 0x7f) << shift;
+
+        if ((b & 0x80) == 0) {
+            // the 10th byte can only carry the single remaining bit
+            GLOBED_REQUIRE(shift != 63 || b <= 1, "varint overflows 64 bits")
+            return value;
+        }
+    }
+
+    GLOBED_REQUIRE(false, "varint is longer than 10 bytes")
+    return 0;
 }
 
-void ByteBuffer::writeBool(bool value) {
-    this->writeU8(value ? 1 : 0);
+int64_t ByteReader::readVarInt() {
+    return util::data::zigzagDecode(this->readVarUint());
 }
 
-MAKE_BOTH_FUNCS(uint8_t, U8)
-MAKE_BOTH_FUNCS(int8_t, I8)
-MAKE_BOTH_FUNCS(uint16_t, U16)
-MAKE_BOTH_FUNCS(int16_t, I16)
-MAKE_BOTH_FUNCS(uint32_t, U32)
-MAKE_BOTH_FUNCS(int32_t, I32)
-MAKE_BOTH_FUNCS(uint64_t, U64)
-MAKE_BOTH_FUNCS(int64_t, I64)
-MAKE_BOTH_FUNCS(float, F32)
-MAKE_BOTH_FUNCS(double, F64)
+size_t ByteReader::readLength(LengthPrefix prefix) {
+    if (prefix == LengthPrefix::U32) {
+        return this->readU32();
+    }
 
-std::string ByteBuffer::readString() {
-    auto length = this->readU32();
+    auto length = this->readVarUint();
+    GLOBED_REQUIRE(length <= std::numeric_limits<uint32_t>::max(), "length prefix is too large")
+
+    return static_cast<size_t>(length);
+}
+
+size_t ByteReader::readListLength(size_t minElementSize, LengthPrefix prefix) {
+    auto length = this->readLength(prefix);
+    GLOBED_REQUIRE(length <= this->remaining() / std::max<size_t>(minElementSize, 1), "list length is bigger than the remaining data")
+
+    return length;
+}
+
+std::string ByteReader::readString(LengthPrefix prefix) {
+    return std::string(this->readStringView(prefix));
+}
+
+std::string_view ByteReader::readStringView(LengthPrefix prefix) {
+    auto length = this->readLength(prefix);
 
     this->boundsCheck(length);
 
-    std::string str(reinterpret_cast<const char*>(_data.data() + _position), length);
+    std::string_view str(reinterpret_cast<const char*>(_rawData + _position), length);
     _position += length;
 
     return str;
 }
 
-bytevector ByteBuffer::readByteArray() {
+void ByteReader::readArrayRaw(byte* out, size_t bytes, size_t elemSize) {
+    this->boundsCheck(bytes);
+    util::data::maybeByteswapCopy(out, _rawData + _position, bytes / elemSize, elemSize);
+    _position += bytes;
+}
+
+bytevector ByteReader::readByteArray() {
     auto length = this->readU32();
     return this->readBytes(length);
 }
 
-bytevector ByteBuffer::readBytes(size_t size) {
+bytevector ByteReader::readBytes(size_t size) {
     this->boundsCheck(size);
 
-    bytevector vec(_data.begin() + _position, _data.begin() + _position + size);
+    bytevector vec(_rawData + _position, _rawData + _position + size);
     _position += size;
 
     return vec;
 }
 
-void ByteBuffer::readBytesInto(byte* out, size_t size) {
+void ByteReader::readBytesInto(byte* out, size_t size) {
     this->boundsCheck(size);
-    std::memcpy(out, _data.data() + _position, size);
+    std::memcpy(out, _rawData + _position, size);
     _position += size;
 }
 
-void ByteBuffer::writeString(const std::string_view str) {
-    this->writeU32(str.size());
+size_t ByteReader::size() const {
+    return _rawSize;
+}
+
+size_t ByteReader::remaining() const {
+    return _position < _rawSize ? _rawSize - _position : 0;
+}
+
+size_t ByteReader::getPosition() const {
+    return _position;
+}
+
+void ByteReader::setPosition(size_t pos) {
+    _position = pos;
+}
+
+/* ByteBuffer */
+
+ByteBuffer::ByteBuffer() {}
+ByteBuffer::ByteBuffer(const bytevector& data) : _data(data) { this->updateView(); }
+ByteBuffer::ByteBuffer(const byte* data, size_t length) : _data(bytevector(data, data + length)) { this->updateView(); }
+ByteBuffer::ByteBuffer(util::data::bytevector&& data) : _data(std::move(data)) { this->updateView(); }
+
+ByteBuffer::ByteBuffer(const ByteBuffer& other) : ByteReader(other), _data(other._data) {
+    // the base still points into `other`
+    this->updateView();
+}
+
+ByteBuffer& ByteBuffer::operator=(const ByteBuffer& other) {
+    if (this != &other) {
+        _data = other._data;
+        _position = other._position;
+        this->updateView();
+    }
+
+    return *this;
+}
+
+ByteBuffer::ByteBuffer(ByteBuffer&& other) noexcept : ByteReader(other), _data(std::move(other._data)) {
+    this->updateView();
+    other.clear();
+}
+
+ByteBuffer& ByteBuffer::operator=(ByteBuffer&& other) noexcept {
+    if (this != &other) {
+        _data = std::move(other._data);
+        _position = other._position;
+        this->updateView();
+        other.clear();
+    }
+
+    return *this;
+}
+
+template <typename T>
+void ByteBuffer::write(T value) {
+    const byte* bytes = reinterpret_cast<const byte*>(&value);
+    _data.insert(_data.end(), bytes, bytes + sizeof(T));
+    _position += sizeof(T);
+    this->updateView();
+}
+
+void ByteBuffer::writeBool(bool value) {
+    this->writeU8(value ? 1 : 0);
+}
+
+MAKE_BOTH_FUNCS(uint8_t, U8)
+MAKE_BOTH_FUNCS(int8_t, I8)
+MAKE_BOTH_FUNCS(uint16_t, U16)
+MAKE_BOTH_FUNCS(int16_t, I16)
+MAKE_BOTH_FUNCS(uint32_t, U32)
+MAKE_BOTH_FUNCS(int32_t, I32)
+MAKE_BOTH_FUNCS(uint64_t, U64)
+MAKE_BOTH_FUNCS(int64_t, I64)
+MAKE_BOTH_FUNCS(float, F32)
+MAKE_BOTH_FUNCS(double, F64)
+
+void ByteBuffer::writeVarUint(uint64_t value) {
+    byte encoded[10];
+    size_t len = 0;
+
+    while (value >= 0x80) {
+        encoded[len++] = static_cast<byte>(value | 0x80);
+        value >>= 7;
+    }
+
+    encoded[len++] = static_cast<byte>(value);
+    this->writeBytes(encoded, len);
+}
+
+void ByteBuffer::writeVarInt(int64_t value) {
+    this->writeVarUint(util::data::zigzagEncode(value));
+}
+
+void ByteBuffer::writeLength(size_t length, LengthPrefix prefix) {
+    if (prefix == LengthPrefix::Varint) {
+        this->writeVarUint(length);
+    } else {
+        this->writeU32(length);
+    }
+}
+
+void ByteBuffer::writeString(const std::string_view str, LengthPrefix prefix) {
+    this->writeLength(str.size(), prefix);
     _data.insert(_data.end(), str.begin(), str.end());
     _position += str.size();
+    this->updateView();
 }
 
 void ByteBuffer::writeByteArray(const bytevector& vec) {
@@ -109,22 +243,35 @@ void ByteBuffer::writeByteArray(const byte* data, size_t length) {
 void ByteBuffer::writeBytes(const util::data::byte* data, size_t size) {
     _data.insert(_data.end(), data, data + size);
     _position += size;
+    this->updateView();
 }
 
 void ByteBuffer::writeBytes(const bytevector& vec) {
     this->writeBytes(vec.data(), vec.size());
 }
 
+void ByteBuffer::writeArrayRaw(const byte* data, size_t bytes, size_t elemSize) {
+    size_t start = _data.size();
+    _data.insert(_data.end(), data, data + bytes);
+
+    // swap in place, straight in the destination
+    byte* dest = _data.data() + start;
+    util::data::maybeByteswapCopy(dest, dest, bytes / elemSize, elemSize);
+
+    _position += bytes;
+    this->updateView();
+}
+
 /* cocos/gd */
 
-cocos2d::ccColor3B ByteBuffer::readColor3() {
+cocos2d::ccColor3B ByteReader::readColor3() {
     auto r = this->readU8();
     auto g = this->readU8();
     auto b = this->readU8();
     return cocos2d::ccc3(r, g, b);
 }
 
-cocos2d::ccColor4B ByteBuffer::readColor4() {
+cocos2d::ccColor4B ByteReader::readColor4() {
     auto r = this->readU8();
     auto g = this->readU8();
     auto b = this->readU8();
@@ -132,7 +279,7 @@ cocos2d::ccColor4B ByteBuffer::readColor4() {
     return cocos2d::ccc4(r, g, b, a);
 }
 
-cocos2d::CCPoint ByteBuffer::readPoint() {
+cocos2d::CCPoint ByteReader::readPoint() {
     float x = this->readF32();
     float y = this->readF32();
     return ccp(x, y);
@@ -167,22 +314,21 @@ bytevector& ByteBuffer::getDataRef() {
 void ByteBuffer::clear() {
     _data.clear();
     _position = 0;
+    this->updateView();
 }
 
-size_t ByteBuffer::size() const {
-    return _data.size();
+void ByteBuffer::reserve(size_t bytes) {
+    _data.reserve(bytes);
+    this->updateView();
 }
 
-size_t ByteBuffer::getPosition() const {
-    return _position;
-}
-
-void ByteBuffer::setPosition(size_t pos) {
-    _position = pos;
+size_t ByteBuffer::capacity() const {
+    return _data.capacity();
 }
 
 void ByteBuffer::resize(size_t bytes) {
     _data.resize(bytes);
+    this->updateView();
 }
 
 void ByteBuffer::grow(size_t bytes) {
@@ -1,12 +1,15 @@
 #pragma once
 #include <defs.hpp>
 
+#include <cstring> // std::memcpy
+#include <span>
 #include <type_traits>
 
 #include "bitbuffer.hpp"
 #include <util/data.hpp>
 
 class ByteBuffer;
+class ByteReader;
 
 // Represents a data type that can be easily written to a ByteBuffer
 template <typename T>
@@ -14,9 +17,9 @@ concept Encodable = requires(const T t, ByteBuffer& buf) {
     { t.encode(buf) } -> std::same_as<void>;
 };
 
-// Represents a data type that can be easily read from a ByteBuffer
+// Represents a data type that can be easily read from a ByteReader (or a ByteBuffer)
 template <typename T>
-concept Decodable = requires(T t, ByteBuffer& buf) {
+concept Decodable = requires(T t, ByteReader& buf) {
     { t.decode(buf) } -> std::same_as<void>;
 } && std::is_default_constructible_v<T>;
 
@@ -24,31 +27,73 @@ concept Decodable = requires(T t, ByteBuffer& buf) {
 template <typename T>
 concept Serializable = Encodable<T> && Decodable<T>;
 
-// helper macros so you can do GLOBED_ENCODE {...} in serializable structs or packets
-#define GLOBED_ENCODE inline void encode(ByteBuffer& buf) const
-#define GLOBED_DECODE inline void decode(ByteBuffer& buf)
+// Represents a data type whose encoded size is always the same and known at compile time
+template <typename T>
+concept StaticSize = requires {
+    { T::ENCODED_SIZE } -> std::convertible_to<size_t>;
+};
 
-class ByteBuffer {
-public:
-    // Constructs an empty ByteBuffer
-    ByteBuffer();
+// Represents a data type whose encoded size can be calculated at runtime
+template <typename T>
+concept DynamicSize = requires(const T t) {
+    { t.encodedSize() } -> std::convertible_to<size_t>;
+};
 
-    // Construct a ByteBuffer and initializes it with some data
-    ByteBuffer(const util::data::bytevector& data);
-    ByteBuffer(const util::data::byte* data, size_t length);
+// Represents a data type whose encoded size varies, but is known to never be smaller than `MIN_ENCODED_SIZE`
+template <typename T>
+concept MinSize = requires {
+    { T::MIN_ENCODED_SIZE } -> std::convertible_to<size_t>;
+};
 
-    ByteBuffer(util::data::bytevector&& data);
+// The smallest amount of bytes an encoded T can take, used to reject list lengths that could never fit in the remaining data.
+// If it isn't known, the value is assumed to take at least 1 byte.
+template <typename T>
+constexpr size_t minEncodedSize() {
+    if constexpr (StaticSize<T>) {
+        return T::ENCODED_SIZE > 0 ? T::ENCODED_SIZE : 1;
+    } else if constexpr (MinSize<T>) {
+        return T::MIN_ENCODED_SIZE > 0 ? T::MIN_ENCODED_SIZE : 1;
+    } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        return sizeof(T);
+    } else {
+        return 1;
+    }
+}
+
+// Represents a type that can be written or read in bulk with `writeArray` and `readArrayInto`
+template <typename T>
+concept BulkEncodable = util::data::IsPrimitive<T> || std::is_same_v<T, cocos2d::CCPoint>;
+
+// Encoding of the length prefix used for strings, byte arrays and lists
+enum class LengthPrefix {
+    U32,    // always 4 bytes, this is the default
+    Varint, // LEB128, 1 byte for lengths below 128, 2 bytes below 16384
+};
+
+// helper macros so you can do GLOBED_ENCODE {...} in serializable structs or packets
+#define GLOBED_ENCODE inline void encode(ByteBuffer& buf) const
+#define GLOBED_DECODE inline void decode(ByteReader& buf)
+
+/*
+* ByteReader is a non-owning view over a chunk of bytes, that implements all the read methods of a ByteBuffer.
+* It does no allocations on its own, so it's the preferred way of decoding data that already lives somewhere else,
+* for example in the receive buffer of a socket. The underlying data must outlive the reader.
+*
+* ByteBuffer inherits from this class, so anything that can be decoded from a ByteReader can be decoded from a ByteBuffer too.
+*/
+class ByteReader {
+public:
+    // Construct a ByteReader over `length` bytes starting at `data`
+    ByteReader(const util::data::byte* data, size_t length);
+    // Construct a ByteReader over the contents of a bytevector. The vector must not be modified while the reader is in use.
+    ByteReader(const util::data::bytevector& data);
 
     // Read a primitive type T. It is highly advised not to use this directly, as it performs no endianness conversions.
     template<typename T>
     T read();
 
-    // Write a primitive type T. It is highly advised not to use this directly, as it performs no endianness conversions.
-    template<typename T>
-    void write(T value);
-
     /*
-    * Read and write method for primitive types
+    * Read methods for primitive types
     */
 
     bool readBool();
@@ -63,38 +108,34 @@ public:
     float readF32();
     double readF64();
 
-    void writeBool(bool value);
-    void writeU8(uint8_t value);
-    void writeI8(int8_t value);
-    void writeU16(uint16_t value);
-    void writeI16(int16_t value);
-    void writeU32(uint32_t value);
-    void writeI32(int32_t value);
-    void writeU64(uint64_t value);
-    void writeI64(int64_t value);
-    void writeF32(float value);
-    void writeF64(double value);
-
     /*
-    * Read and write methods for dynamic-sized types
+    * Read methods for variable-length integers
     */
 
-    // keep in mind strings might be broken if non ascii characters are sent
+    // Read an unsigned LEB128 varint (1 to 10 bytes)
+    uint64_t readVarUint();
+    // Read a signed zigzag LEB128 varint (1 to 10 bytes)
+    int64_t readVarInt();
+    // Read a length prefix of strings or lists
+    size_t readLength(LengthPrefix prefix = LengthPrefix::U32);
+    // Read a length prefix of a list, and throw if that many elements of at least `minElementSize` bytes can't fit in the remaining data.
+    // This way a bogus length is rejected before anything gets allocated.
+    size_t readListLength(size_t minElementSize, LengthPrefix prefix = LengthPrefix::U32);
+
+    /*
+    * Read methods for dynamic-sized types
+    */
 
-    // Read a string, prefixed with 4 bytes indicating length
-    std::string readString();
+    // Read a length-prefixed string
+    std::string readString(LengthPrefix prefix = LengthPrefix::U32);
+    // Read a length-prefixed string. The returned view borrows the underlying data,
+    // so it is only valid for as long as the data this reader points to.
+    std::string_view readStringView(LengthPrefix prefix = LengthPrefix::U32);
     // Read a bytevector, prefixed with 4 bytes indicating length
     util::data::bytevector readByteArray();
 
-    // Write a string, prefixed with 4 bytes indicating length
-    void writeString(const std::string_view str);
-    // Write a bytevector, prefixed with 4 bytes indicating length
-    void writeByteArray(const util::data::bytevector& vec);
-    // Write bytes from a buffer, prefixed with 4 bytes indicating length
-    void writeByteArray(const util::data::byte* data, size_t length);
-
     /*
-    * Read and write methods for fixed-size types
+    * Read methods for fixed-size types
     */
 
     // Read a fixed-size bytevector
@@ -105,7 +146,7 @@ public:
     util::data::bytearray<Count> readBytes() {
         this->boundsCheck(Count);
         util::data::bytearray<Count> arr;
-        std::copy(_data.begin() + _position, _data.begin() + _position + Count, arr.begin());
+        std::copy(_rawData + _position, _rawData + _position + Count, arr.begin());
 
         _position += Count;
 
@@ -115,23 +156,18 @@ public:
     // Read `size` bytes into the pointer `out`
     void readBytesInto(util::data::byte* out, size_t size);
 
-    // Write a fixed-size buffer of bytes without length prefix. If the size isn't a constant,
-    // it is recommended to use writeByteArray instead.
-    void writeBytes(const util::data::byte* data, size_t size);
-    // Write a fixed-size bytevector without length prefix. If the size isn't a constant,
-    // it is recommended to use writeByteArray instead.
-    void writeBytes(const util::data::bytevector& vec);
-    // Write a bytearray whose size is known at compile time (without length prefix)
-    template <size_t Count>
-    void writeBytes(const util::data::bytearray<Count>& arr) {
-        this->writeBytes(arr.data(), Count);
+    // Read `out.size()` primitives or points into `out`, without a length prefix.
+    // The byte order is converted for the whole array at once, which is much faster than reading values one by one.
+    template <BulkEncodable T>
+    void readArrayInto(std::span<T> out) {
+        this->readArrayRaw(reinterpret_cast<util::data::byte*>(out.data()), out.size_bytes(), bulkElementSize<T>());
     }
 
     /*
-    * Read and write methods for bit manipulation
+    * Read methods for bit manipulation
     */
 
-    // Read `BitCount` bits from this ByteBuffer. The bit amount must be known at compile time.
+    // Read `BitCount` bits from this ByteReader. The bit amount must be known at compile time.
     // The amount of bytes read is rounded up from the bit count. So reading 10 bits would read 2 whole bytes.
     template<size_t BitCount>
     BitBuffer<BitCount> readBits() {
@@ -143,14 +179,8 @@ public:
         return BitBuffer<BitCount>(value);
     }
 
-    // Write all bits from the given `BitBuffer` into the current `ByteBuffer`
-    template<size_t BitCount>
-    void writeBits(BitBuffer<BitCount> bitbuf) {
-        this->write(bitbuf.contents());
-    }
-
     /*
-    * Read and write methods for types implementing Encodable/Decodable/Serializable
+    * Read methods for types implementing Decodable
     */
 
     // Read a `Decodable` object
@@ -161,12 +191,6 @@ public:
         return value;
     }
 
-    // Write an `Encodable` object
-    template <Encodable T>
-    void writeValue(const T& value) {
-        value.encode(*this);
-    }
-
     // Read an `std::optional<T>` where T: Decodable
     template <Decodable T>
     std::optional<T> readOptionalValue() {
@@ -178,37 +202,25 @@ public:
         return value;
     }
 
-    template <Encodable T>
-    void writeOptionalValue(const std::optional<T>& value) {
-        this->writeBool(value.has_value());
-        if (value) {
-            this->writeValue(value.value());
-        }
-    }
-
-    template <typename T>
-    void writeOptionalValue(const std::optional<T>& value, std::function<void(ByteBuffer&, const T& val)> encodeFunc) {
-        this->writeBool(value.has_value());
-        if (value) {
-            encodeFunc(*this, value.value());
-        }
-    }
-
-    // Read a list of `Decodable` objects, prefixed with 4 bytes indicating the count.
+    // Read a list of `Decodable` objects, prefixed with the count (4 bytes unless specified otherwise).
+    // The count is checked against the remaining data (see `minEncodedSize`) and the vector is allocated only once.
     template <Decodable T>
-    std::vector<T> readValueVector() {
+    std::vector<T> readValueVector(LengthPrefix prefix = LengthPrefix::U32) {
         std::vector<T> out;
-        this->readValueVectorInto(out);
+        this->readValueVectorInto(out, prefix);
         return out;
     }
 
-    // Same as `readValueVector` but you get to specify the destination
+    // Same as `readValueVector`, but replaces the contents of an existing vector. Existing elements are decoded into in place
+    // and the capacity is kept, so a vector that is reused for every packet stops allocating once it's big enough.
+    // If decoding fails, the contents of `out` are unspecified.
     template <Decodable T>
-    void readValueVectorInto(std::vector<T>& out) {
-        auto length = this->readU32();
+    void readValueVectorInto(std::vector<T>& out, LengthPrefix prefix = LengthPrefix::U32) {
+        auto length = this->readListLength(minEncodedSize<T>(), prefix);
 
-        for (size_t i = 0; i < length; i++) {
-            out.push_back(this->readValue<T>());
+        out.resize(length);
+        for (auto& elem : out) {
+            elem.decode(*this);
         }
     }
 
@@ -223,23 +235,6 @@ public:
         return out;
     }
 
-    // Write a list of `Encodable` objects, prefixed with 4 bytes indicating the count.
-    template <Encodable T>
-    void writeValueVector(const std::vector<T>& values) {
-        this->writeU32(values.size());
-        for (const T& value : values) {
-            value.encode(*this);
-        }
-    }
-
-    // Write an array of `Encodable` objects, without encoding the size.
-    template <Encodable T, size_t Count>
-    void writeValueArray(const std::array<T, Count>& values) {
-        for (const T& value : values) {
-            value.encode(*this);
-        }
-    }
-
     // Read a generic primitive number (like read<T> but with endianness checks)
     template <typename T>
     T readPrimitive() {
@@ -268,6 +263,226 @@ public:
         }
     }
 
+    // Read an enum
+    // TODO no validation, likely not planning to add but still important to know
+    template <typename E>
+    E readEnum() {
+        using P = typename std::underlying_type<E>::type;
+        static_assert(util::data::IsPrimitive<P>, "enum underlying type must be a primitive");
+
+        return static_cast<E>(this->readPrimitive<P>());
+    }
+
+    /*
+    * Cocos/GD serializable methods
+    */
+
+    // Read an RGB color (3 bytes)
+    cocos2d::ccColor3B readColor3();
+    // Read an RGBA color (4 bytes)
+    cocos2d::ccColor4B readColor4();
+    // Read a CCPoint (2 floats)
+    cocos2d::CCPoint readPoint();
+
+    /*
+    * Misc util functions
+    */
+
+    size_t size() const;
+
+    // Returns the amount of bytes left to read
+    size_t remaining() const;
+
+    size_t getPosition() const;
+    void setPosition(size_t pos);
+
+    /*
+    * Unchecked reads, for decoding fixed-size structures with a single bounds check (see data/schema.hpp)
+    */
+
+    // Throws if there are less than `bytes` bytes left to read
+    void ensureRemaining(size_t bytes) {
+        this->boundsCheck(bytes);
+    }
+
+    // Read a primitive (with endianness conversion) without doing any bounds checks.
+    // Must only be called after `ensureRemaining` has verified there is enough data left.
+    template <typename T>
+    T readUnchecked() {
+        static_assert(util::data::IsPrimitive<T>, "Unsupported type for readUnchecked, must be a primitive");
+
+        T value;
+        std::memcpy(&value, _rawData + _position, sizeof(T));
+        _position += sizeof(T);
+        return util::data::maybeByteswap<T>(value);
+    }
+
+protected:
+    // ByteBuffer needs to construct an empty view and point it to its own storage later
+    ByteReader();
+
+    const util::data::byte* _rawData;
+    size_t _rawSize;
+    size_t _position;
+
+    void boundsCheck(size_t readBytes) {
+        GLOBED_REQUIRE(readBytes <= this->remaining(), "ByteBuffer out of bounds read")
+    }
+
+    // size of a single value that has to be byteswapped, a point is just 2 floats
+    template <BulkEncodable T>
+    static constexpr size_t bulkElementSize() {
+        if constexpr (std::is_same_v<T, cocos2d::CCPoint>) {
+            static_assert(sizeof(cocos2d::CCPoint) == sizeof(float) * 2 && std::is_standard_layout_v<cocos2d::CCPoint>);
+            return sizeof(float);
+        } else {
+            return sizeof(T);
+        }
+    }
+
+private:
+    void readArrayRaw(util::data::byte* out, size_t bytes, size_t elemSize);
+};
+
+/*
+* ByteBuffer is an owning, growable buffer that can be both written to and read from.
+*/
+class ByteBuffer : public ByteReader {
+public:
+    // Constructs an empty ByteBuffer
+    ByteBuffer();
+
+    // Construct a ByteBuffer and initializes it with some data
+    ByteBuffer(const util::data::bytevector& data);
+    ByteBuffer(const util::data::byte* data, size_t length);
+
+    ByteBuffer(util::data::bytevector&& data);
+
+    ByteBuffer(const ByteBuffer& other);
+    ByteBuffer& operator=(const ByteBuffer& other);
+    ByteBuffer(ByteBuffer&& other) noexcept;
+    ByteBuffer& operator=(ByteBuffer&& other) noexcept;
+
+    // Write a primitive type T. It is highly advised not to use this directly, as it performs no endianness conversions.
+    template<typename T>
+    void write(T value);
+
+    /*
+    * Write methods for primitive types
+    */
+
+    void writeBool(bool value);
+    void writeU8(uint8_t value);
+    void writeI8(int8_t value);
+    void writeU16(uint16_t value);
+    void writeI16(int16_t value);
+    void writeU32(uint32_t value);
+    void writeI32(int32_t value);
+    void writeU64(uint64_t value);
+    void writeI64(int64_t value);
+    void writeF32(float value);
+    void writeF64(double value);
+
+    /*
+    * Write methods for variable-length integers
+    */
+
+    // Write an unsigned LEB128 varint, 7 bits per byte
+    void writeVarUint(uint64_t value);
+    // Write a signed varint, zigzag encoded so that small negative numbers stay short
+    void writeVarInt(int64_t value);
+    // Write a length prefix of strings or lists
+    void writeLength(size_t length, LengthPrefix prefix = LengthPrefix::U32);
+
+    /*
+    * Write methods for dynamic-sized types
+    */
+
+    // keep in mind strings might be broken if non ascii characters are sent
+
+    // Write a length-prefixed string
+    void writeString(const std::string_view str, LengthPrefix prefix = LengthPrefix::U32);
+    // Write a bytevector, prefixed with 4 bytes indicating length
+    void writeByteArray(const util::data::bytevector& vec);
+    // Write bytes from a buffer, prefixed with 4 bytes indicating length
+    void writeByteArray(const util::data::byte* data, size_t length);
+
+    /*
+    * Write methods for fixed-size types
+    */
+
+    // Write a fixed-size buffer of bytes without length prefix. If the size isn't a constant,
+    // it is recommended to use writeByteArray instead.
+    void writeBytes(const util::data::byte* data, size_t size);
+    // Write a fixed-size bytevector without length prefix. If the size isn't a constant,
+    // it is recommended to use writeByteArray instead.
+    void writeBytes(const util::data::bytevector& vec);
+    // Write a bytearray whose size is known at compile time (without length prefix)
+    template <size_t Count>
+    void writeBytes(const util::data::bytearray<Count>& arr) {
+        this->writeBytes(arr.data(), Count);
+    }
+
+    // Write an array of primitives or points, without a length prefix.
+    // The byte order is converted for the whole array at once, which is much faster than writing values one by one.
+    template <BulkEncodable T>
+    void writeArray(std::span<const T> values) {
+        this->writeArrayRaw(reinterpret_cast<const util::data::byte*>(values.data()), values.size_bytes(), bulkElementSize<T>());
+    }
+
+    /*
+    * Write methods for bit manipulation
+    */
+
+    // Write all bits from the given `BitBuffer` into the current `ByteBuffer`
+    template<size_t BitCount>
+    void writeBits(BitBuffer<BitCount> bitbuf) {
+        this->write(bitbuf.contents());
+    }
+
+    /*
+    * Write methods for types implementing Encodable
+    */
+
+    // Write an `Encodable` object
+    template <Encodable T>
+    void writeValue(const T& value) {
+        value.encode(*this);
+    }
+
+    template <Encodable T>
+    void writeOptionalValue(const std::optional<T>& value) {
+        this->writeBool(value.has_value());
+        if (value) {
+            this->writeValue(value.value());
+        }
+    }
+
+    template <typename T>
+    void writeOptionalValue(const std::optional<T>& value, std::function<void(ByteBuffer&, const T& val)> encodeFunc) {
+        this->writeBool(value.has_value());
+        if (value) {
+            encodeFunc(*this, value.value());
+        }
+    }
+
+    // Write a list of `Encodable` objects, prefixed with the count (4 bytes unless specified otherwise).
+    template <Encodable T>
+    void writeValueVector(const std::vector<T>& values, LengthPrefix prefix = LengthPrefix::U32) {
+        this->writeLength(values.size(), prefix);
+        for (const T& value : values) {
+            value.encode(*this);
+        }
+    }
+
+    // Write an array of `Encodable` objects, without encoding the size.
+    template <Encodable T, size_t Count>
+    void writeValueArray(const std::array<T, Count>& values) {
+        for (const T& value : values) {
+            value.encode(*this);
+        }
+    }
+
     // Write a generic primitive number (like read<T> but with endianness checks)
     template <typename T>
     void writePrimitive(T value) {
@@ -306,27 +521,10 @@ public:
         this->writePrimitive<P>(static_cast<P>(val));
     }
 
-    // Read an enum
-    // TODO no validation, likely not planning to add but still important to know
-    template <typename E>
-    E readEnum() {
-        using P = typename std::underlying_type<E>::type;
-        static_assert(util::data::IsPrimitive<P>, "enum underlying type must be a primitive");
-
-        return static_cast<E>(this->readPrimitive<P>());
-    }
-
     /*
     * Cocos/GD serializable methods
     */
 
-    // Read an RGB color (3 bytes)
-    cocos2d::ccColor3B readColor3();
-    // Read an RGBA color (4 bytes)
-    cocos2d::ccColor4B readColor4();
-    // Read a CCPoint (2 floats)
-    cocos2d::CCPoint readPoint();
-
     // Write an RGB color (3 bytes)
     void writeColor3(cocos2d::ccColor3B color);
     // Write an RGBA color (4 bytes)
@@ -334,6 +532,67 @@ public:
     // Write a CCPoint (2 floats)
     void writePoint(cocos2d::CCPoint point);
 
+    /*
+    * Size calculation helpers, useful for implementing `encodedSize()`
+    */
+
+    // Returns the encoded size of an unsigned varint
+    static constexpr size_t sizeOfVarUint(uint64_t value) {
+        size_t bytes = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            bytes++;
+        }
+
+        return bytes;
+    }
+
+    // Returns the encoded size of a signed (zigzag) varint
+    static constexpr size_t sizeOfVarInt(int64_t value) {
+        return sizeOfVarUint(util::data::zigzagEncode(value));
+    }
+
+    // Returns the encoded size of a length prefix
+    static constexpr size_t sizeOfLength(size_t length, LengthPrefix prefix = LengthPrefix::U32) {
+        return prefix == LengthPrefix::Varint ? sizeOfVarUint(length) : sizeof(uint32_t);
+    }
+
+    // Returns the encoded size of a length-prefixed string
+    static constexpr size_t sizeOfString(const std::string_view str, LengthPrefix prefix = LengthPrefix::U32) {
+        return sizeOfLength(str.size(), prefix) + str.size();
+    }
+
+    // Returns the encoded size of a value that implements either `StaticSize` or `DynamicSize`
+    template <typename T> requires StaticSize<T> || DynamicSize<T>
+    static constexpr size_t sizeOfValue(const T& value) {
+        if constexpr (StaticSize<T>) {
+            return T::ENCODED_SIZE;
+        } else {
+            return value.encodedSize();
+        }
+    }
+
+    // Returns the encoded size of an optional value, as written by `writeOptionalValue`
+    template <typename T>
+    static constexpr size_t sizeOfOptional(const std::optional<T>& value) {
+        return sizeof(bool) + (value.has_value() ? sizeOfValue(value.value()) : 0);
+    }
+
+    // Returns the encoded size of a list of values, as written by `writeValueVector`
+    template <typename T>
+    static constexpr size_t sizeOfValueVector(const std::vector<T>& values, LengthPrefix prefix = LengthPrefix::U32) {
+        if constexpr (StaticSize<T>) {
+            return sizeOfLength(values.size(), prefix) + values.size() * T::ENCODED_SIZE;
+        } else {
+            size_t total = sizeOfLength(values.size(), prefix);
+            for (const T& value : values) {
+                total += value.encodedSize();
+            }
+
+            return total;
+        }
+    }
+
     /*
     * Misc util functions
     */
@@ -341,14 +600,17 @@ public:
     // Get the internal data as a bytevector
     util::data::bytevector getData() const;
 
-    // Get a reference to internal data instead of a copy
+    // Get a reference to internal data instead of a copy. Do not change the size of the vector through this reference,
+    // use `resize`, `grow` or `shrink` instead.
     util::data::bytevector& getDataRef();
 
-    size_t size() const;
+    // Clears the data and resets the position. Keeps the allocated capacity, so the buffer can be reused without reallocating.
     void clear();
 
-    size_t getPosition() const;
-    void setPosition(size_t pos);
+    // Reserve space for at least `bytes` bytes in total, so that writes up to that size will not cause a reallocation
+    void reserve(size_t bytes);
+
+    size_t capacity() const;
 
     // Resize the internal vector to length `bytes`. Does not change the position
     void resize(size_t bytes);
@@ -360,9 +622,12 @@ public:
     void shrink(size_t bytes);
 private:
     util::data::bytevector _data;
-    size_t _position;
 
-    void boundsCheck(size_t readBytes) {
-        GLOBED_REQUIRE(_position + readBytes <= _data.size(), "ByteBuffer out of bounds read")
+    void writeArrayRaw(const util::data::byte* data, size_t bytes, size_t elemSize);
+
+    // must be called after every operation that could reallocate or resize `_data`
+    void updateView() {
+        _rawData = _data.data();
+        _rawSize = _data.size();
     }
 };
\ No newline at end of file
@@ -11,11 +11,12 @@
 * 2. in your class, inherit Packet and add GLOBED_PACKET(id, encrypt), encrypt should be true for packets that are sensitive.
 * 3. add the GLOBED_ENCODE or GLOBED_DECODE method
 * 4. For client packets, you may also choose to add a ::create(...) function and/or a constructor
-* 5. For server packets, in `all.cpp` add the packet to the switch as PACKET(cls).
+* 5. For server packets, add the class to `ServerPackets` below.
 */
 
 #pragma once
 #include "packet.hpp"
+#include "registry.hpp"
 
 #include "client/admin.hpp"
 #include "client/connection.hpp"
@@ -28,5 +29,39 @@
 #include "server/general.hpp"
 #include "server/game.hpp"
 
-// Matches a packet by packet ID, returns nullptr if not found. Otherwise returns an Packet pointer with uninitialized data
-std::shared_ptr<Packet> matchPacket(packetid_t packetId);
\ No newline at end of file
+// Every packet that can be received from the server. Only these can be decoded and have listeners.
+using ServerPackets = PacketList<
+    // connection related
+
+    PingResponsePacket,
+    CryptoHandshakeResponsePacket,
+    KeepaliveResponsePacket,
+    ServerDisconnectPacket,
+    LoggedInPacket,
+    LoginFailedPacket,
+    ServerNoticePacket,
+    ProtocolMismatchPacket,
+
+    // general
+
+    GlobalPlayerListPacket,
+    RoomCreatedPacket,
+    RoomJoinedPacket,
+    RoomJoinFailedPacket,
+    RoomPlayerListPacket,
+    LevelListPacket,
+
+    // game related
+
+    PlayerProfilesPacket,
+    LevelDataPacket,
+    VoiceBroadcastPacket,
+    ChatMessageBroadcastPacket,
+
+    // admin related
+
+    AdminAuthSuccessPacket
+>;
+
+// Matches a packet by packet ID, returns nullptr if not found. Otherwise returns a pooled packet that is ready to be decoded into
+PacketPtr<Packet> matchPacket(packetid_t packetId);
\ No newline at end of file
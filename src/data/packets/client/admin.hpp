@@ -1,15 +1,16 @@
 #pragma once
-#include <data/packets/packet.hpp>
+#include <data/packets/pool.hpp>
 
 class AdminAuthPacket : public Packet {
     GLOBED_PACKET(19000, true)
 
     GLOBED_PACKET_ENCODE { buf.writeString(key); }
+    GLOBED_PACKET_ENCODED_SIZE { return ByteBuffer::sizeOfString(key); }
 
     AdminAuthPacket(const std::string_view key) : key(key) {}
 
-    static std::shared_ptr<Packet> create(const std::string_view key) {
-        return std::make_shared<AdminAuthPacket>(key);
+    static PacketPtr<Packet> create(const std::string_view key) {
+        return makePacket<AdminAuthPacket>(key);
     }
 
     std::string key;
@@ -32,11 +33,15 @@ class AdminSendNoticePacket : public Packet {
         buf.writeString(message);
     }
 
+    GLOBED_PACKET_ENCODED_SIZE {
+        return sizeof(AdminSendNoticeType) + sizeof(uint32_t) + sizeof(int32_t) + ByteBuffer::sizeOfString(player) + ByteBuffer::sizeOfString(message);
+    }
+
     AdminSendNoticePacket(AdminSendNoticeType ptype, uint32_t roomId, int levelId, const std::string_view player, const std::string_view message)
         : ptype(ptype), roomId(roomId), levelId(levelId), player(player), message(message) {}
 
-    static std::shared_ptr<Packet> create(AdminSendNoticeType ptype, uint32_t roomId, int levelId, const std::string_view player, const std::string_view message) {
-        return std::make_shared<AdminSendNoticePacket>(ptype, roomId, levelId, player, message);
+    static PacketPtr<Packet> create(AdminSendNoticeType ptype, uint32_t roomId, int levelId, const std::string_view player, const std::string_view message) {
+        return makePacket<AdminSendNoticePacket>(ptype, roomId, levelId, player, message);
     }
 
     AdminSendNoticeType ptype;
@@ -1,5 +1,5 @@
 #pragma once
-#include <data/packets/packet.hpp>
+#include <data/packets/pool.hpp>
 #include <data/types/crypto.hpp>
 #include <data/types/gd.hpp>
 
@@ -7,11 +7,12 @@ class PingPacket : public Packet {
     GLOBED_PACKET(10000, false)
 
     GLOBED_PACKET_ENCODE { buf.writeU32(id); }
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(uint32_t); }
 
     PingPacket(uint32_t _id) : id(_id) {}
 
-    static std::shared_ptr<Packet> create(uint32_t id) {
-        return std::make_shared<PingPacket>(id);
+    static PacketPtr<Packet> create(uint32_t id) {
+        return makePacket<PingPacket>(id);
     }
 
     uint32_t id;
@@ -25,10 +26,12 @@ class CryptoHandshakeStartPacket : public Packet {
         buf.writeValue(key);
     }
 
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(uint16_t) + CryptoPublicKey::ENCODED_SIZE; }
+
     CryptoHandshakeStartPacket(uint16_t _protocol, CryptoPublicKey _key) : protocol(_protocol), key(_key) {}
 
-    static std::shared_ptr<Packet> create(uint16_t protocol, CryptoPublicKey key) {
-        return std::make_shared<CryptoHandshakeStartPacket>(protocol, key);
+    static PacketPtr<Packet> create(uint16_t protocol, CryptoPublicKey key) {
+        return makePacket<CryptoHandshakeStartPacket>(protocol, key);
     }
 
     uint16_t protocol;
@@ -41,8 +44,8 @@ class KeepalivePacket : public Packet {
     GLOBED_PACKET_ENCODE {}
 
     KeepalivePacket() {}
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<KeepalivePacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<KeepalivePacket>();
     }
 };
 
@@ -56,11 +59,15 @@ class LoginPacket : public Packet {
         buf.writeValue(icons);
     }
 
+    GLOBED_PACKET_ENCODED_SIZE {
+        return sizeof(int32_t) + ByteBuffer::sizeOfString(name) + ByteBuffer::sizeOfString(token) + PlayerIconData::ENCODED_SIZE;
+    }
+
     LoginPacket(int32_t accid, const std::string_view name, const std::string_view token, const PlayerIconData& icons)
         : accountId(accid), name(name), token(token), icons(icons) {}
 
-    static std::shared_ptr<Packet> create(int32_t accid, const std::string_view name, const std::string_view token, const PlayerIconData& icons) {
-        return std::make_shared<LoginPacket>(accid, name, token, icons);
+    static PacketPtr<Packet> create(int32_t accid, const std::string_view name, const std::string_view token, const PlayerIconData& icons) {
+        return makePacket<LoginPacket>(accid, name, token, icons);
     }
 
     int32_t accountId;
@@ -75,7 +82,186 @@ class DisconnectPacket : public Packet {
     GLOBED_PACKET_ENCODE {}
 
     DisconnectPacket() {}
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<DisconnectPacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<DisconnectPacket>();
+    }
+};
+
+/*
+* BundlePacket carries several packets in one datagram, so they share a single header, and if any of them
+* has to be encrypted, a single nonce and MAC. The server sends bundles with the ID `SERVER_PACKET_ID` in the same format.
+*
+* Each entry is the packet ID (u16), the length of the packet data (u16) and then the data itself.
+* Every entry is encrypted if the bundle is, see `GameSocket::sendPackets` for how packets are bundled.
+*/
+class BundlePacket : public Packet {
+public:
+    static constexpr packetid_t PACKET_ID = 10005;
+    static constexpr packetid_t SERVER_PACKET_ID = 20008;
+
+    static constexpr size_t ENTRY_HEADER_SIZE = sizeof(packetid_t) + sizeof(uint16_t);
+    // the size that all entries together should fit in, so that the datagram is not fragmented on common links
+    static constexpr size_t MAX_ENTRIES_SIZE = 1200;
+
+    packetid_t getPacketId() const override {
+        return PACKET_ID;
+    }
+
+    bool getEncrypted() const override {
+        return encrypted;
+    }
+
+    GLOBED_PACKET_ENCODE {
+        buf.writeBytes(entries.getDataRef());
+    }
+
+    GLOBED_PACKET_ENCODED_SIZE { return entries.size(); }
+
+    // Encode the packet as a new entry
+    void push(const Packet& packet) {
+        size_t start = entries.size();
+        entries.writeU16(packet.getPacketId());
+        entries.writeU16(0); // replaced with the length once it is known
+
+        packet.encode(entries);
+
+        size_t length = entries.size() - start - ENTRY_HEADER_SIZE;
+        GLOBED_REQUIRE(length <= std::numeric_limits<uint16_t>::max(), "packet is too big to be bundled")
+
+        auto& data = entries.getDataRef();
+        data[start + 2] = static_cast<util::data::byte>(length >> 8);
+        data[start + 3] = static_cast<util::data::byte>(length & 0xff);
+
+        encrypted = encrypted || packet.getEncrypted();
+        count++;
+    }
+
+    void clear() {
+        entries.clear();
+        encrypted = false;
+        count = 0;
+    }
+
+    mutable ByteBuffer entries;
+    bool encrypted = false;
+    size_t count = 0;
+};
+
+/*
+* ReliablePacket wraps a packet that is sent on the reliable ordered channel, see `ReliableChannel`.
+* The server sends them with the ID `SERVER_PACKET_ID` in the same format.
+*
+* The header is the sequence number (u32), the cumulative ack (u32) and the selective ack bits (u32) for the other side's packets,
+* and the ID of the wrapped packet (u16), followed by its data. It is encrypted if the wrapped packet is.
+*/
+class ReliablePacket : public Packet {
+public:
+    static constexpr packetid_t PACKET_ID = 10006;
+    static constexpr packetid_t SERVER_PACKET_ID = 20009;
+
+    static constexpr size_t HEADER_SIZE = 3 * sizeof(uint32_t) + sizeof(packetid_t);
+
+    ReliablePacket(uint32_t sequence, PacketPtr<Packet> packet) : sequence(sequence), packet(std::move(packet)) {}
+
+    packetid_t getPacketId() const override {
+        return PACKET_ID;
+    }
+
+    bool getEncrypted() const override {
+        return packet->getEncrypted();
+    }
+
+    GLOBED_PACKET_ENCODE {
+        buf.writeU32(sequence);
+        buf.writeU32(ack);
+        buf.writeU32(ackBits);
+        buf.writeU16(packet->getPacketId());
+        packet->encode(buf);
     }
-};
\ No newline at end of file
+
+    GLOBED_PACKET_ENCODED_SIZE { return HEADER_SIZE + packet->encodedSize(); }
+
+    static PacketPtr<ReliablePacket> create(uint32_t sequence, PacketPtr<Packet> packet) {
+        return makePacket<ReliablePacket>(sequence, std::move(packet));
+    }
+
+    uint32_t sequence;
+    // updated every time the packet is sent
+    uint32_t ack = 0;
+    uint32_t ackBits = 0;
+    PacketPtr<Packet> packet;
+};
+
+// Acknowledges reliable packets when there is no reliable packet to carry the ack. The server sends them with the ID `SERVER_PACKET_ID`.
+class ReliableAckPacket : public Packet {
+    GLOBED_PACKET(10007, false)
+
+    static constexpr packetid_t SERVER_PACKET_ID = 20010;
+
+    GLOBED_PACKET_ENCODE {
+        buf.writeU32(ack);
+        buf.writeU32(ackBits);
+    }
+
+    GLOBED_PACKET_ENCODED_SIZE { return 2 * sizeof(uint32_t); }
+
+    ReliableAckPacket(uint32_t ack, uint32_t ackBits) : ack(ack), ackBits(ackBits) {}
+
+    static PacketPtr<Packet> create(uint32_t ack, uint32_t ackBits) {
+        return makePacket<ReliableAckPacket>(ack, ackBits);
+    }
+
+    uint32_t ack;
+    uint32_t ackBits;
+};
+
+/*
+* FragmentPacket is a piece of a datagram from the server that was too big to be sent at once, see `FragmentReassembler`.
+* The header is the message ID (u32), the index of the fragment (u16) and the fragment count (u16), followed by the data.
+* Every fragment except the last one has exactly `MAX_DATA_SIZE` bytes of data. Only the server sends these.
+*/
+class FragmentPacket {
+public:
+    static constexpr packetid_t SERVER_PACKET_ID = 20011;
+
+    static constexpr size_t HEADER_SIZE = sizeof(uint32_t) + 2 * sizeof(uint16_t);
+    static constexpr size_t MAX_DATA_SIZE = 1200;
+    static constexpr size_t MAX_FRAGMENTS = 64;
+};
+
+/*
+* CompressedPacket wraps a big packet from the server (like a list of profiles or levels) that was compressed with `util::compression`.
+* The header is the ID of the wrapped packet (u16) and its uncompressed size (u32), followed by the compressed data.
+* The server only compresses packets of at least `THRESHOLD` bytes. Only the server sends these.
+*/
+class CompressedPacket {
+public:
+    static constexpr packetid_t SERVER_PACKET_ID = 20012;
+
+    static constexpr size_t HEADER_SIZE = sizeof(packetid_t) + sizeof(uint32_t);
+    static constexpr size_t THRESHOLD = 256;
+    // anything bigger would not fit in a fragmented datagram anyway
+    static constexpr size_t MAX_RAW_SIZE = 1024 * 1024;
+};
+
+// Asks the server to send the missing fragments of a datagram again
+class FragmentRequestPacket : public Packet {
+    GLOBED_PACKET(10008, false)
+
+    GLOBED_PACKET_ENCODE {
+        buf.writeU32(messageId);
+        buf.writeU64(missing);
+    }
+
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(uint32_t) + sizeof(uint64_t); }
+
+    FragmentRequestPacket(uint32_t messageId, uint64_t missing) : messageId(messageId), missing(missing) {}
+
+    static PacketPtr<Packet> create(uint32_t messageId, uint64_t missing) {
+        return makePacket<FragmentRequestPacket>(messageId, missing);
+    }
+
+    uint32_t messageId;
+    // bit n set means that fragment n is missing
+    uint64_t missing;
+};
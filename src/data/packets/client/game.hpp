@@ -1,5 +1,5 @@
 #pragma once
-#include <data/packets/packet.hpp>
+#include <data/packets/pool.hpp>
 #include <data/types/gd.hpp>
 
 class RequestPlayerProfilesPacket : public Packet {
@@ -9,10 +9,12 @@ class RequestPlayerProfilesPacket : public Packet {
         buf.writeI32(requested);
     }
 
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(int32_t); }
+
     RequestPlayerProfilesPacket(int requested) : requested(requested) {}
 
-    static std::shared_ptr<Packet> create(int requested) {
-        return std::make_shared<RequestPlayerProfilesPacket>(requested);
+    static PacketPtr<Packet> create(int requested) {
+        return makePacket<RequestPlayerProfilesPacket>(requested);
     }
 
     int requested;
@@ -25,10 +27,12 @@ class LevelJoinPacket : public Packet {
         buf.writeI32(levelId);
     }
 
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(int32_t); }
+
     LevelJoinPacket(int levelId) : levelId(levelId) {}
 
-    static std::shared_ptr<Packet> create(int levelId) {
-        return std::make_shared<LevelJoinPacket>(levelId);
+    static PacketPtr<Packet> create(int levelId) {
+        return makePacket<LevelJoinPacket>(levelId);
     }
 
     int levelId;
@@ -41,8 +45,8 @@ class LevelLeavePacket : public Packet {
 
     LevelLeavePacket() {}
 
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<LevelLeavePacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<LevelLeavePacket>();
     }
 };
 
@@ -50,15 +54,20 @@ class PlayerDataPacket : public Packet {
     GLOBED_PACKET(12003, false)
 
     GLOBED_PACKET_ENCODE {
+        buf.writeU32(acknowledged);
         buf.writeValue(data);
     }
 
-    PlayerDataPacket(const PlayerData& data) : data(data) {}
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(uint32_t) + data.encodedSize(); }
+
+    PlayerDataPacket(uint32_t acknowledged, const PlayerData& data) : acknowledged(acknowledged), data(data) {}
 
-    static std::shared_ptr<Packet> create(const PlayerData& data) {
-        return std::make_shared<PlayerDataPacket>(data);
+    static PacketPtr<Packet> create(uint32_t acknowledged, const PlayerData& data) {
+        return makePacket<PlayerDataPacket>(acknowledged, data);
     }
 
+    // sequence number of the latest LevelDataPacket we fully decoded, the server will send deltas against it
+    uint32_t acknowledged;
     PlayerData data;
 };
 
@@ -73,10 +82,12 @@ class VoicePacket : public Packet {
         buf.writeValue(*frame.get());
     }
 
+    GLOBED_PACKET_ENCODED_SIZE { return frame->encodedSize(); }
+
     VoicePacket(std::shared_ptr<EncodedAudioFrame> _frame) : frame(_frame) {}
 
-    static std::shared_ptr<Packet> create(std::shared_ptr<EncodedAudioFrame> frame) {
-        return std::make_shared<VoicePacket>(frame);
+    static PacketPtr<Packet> create(std::shared_ptr<EncodedAudioFrame> frame) {
+        return makePacket<VoicePacket>(frame);
     }
 
     std::shared_ptr<EncodedAudioFrame> frame;
@@ -91,10 +102,12 @@ class ChatMessagePacket : public Packet {
         buf.writeString(message);
     }
 
+    GLOBED_PACKET_ENCODED_SIZE { return ByteBuffer::sizeOfString(message); }
+
     ChatMessagePacket(const std::string_view message) : message(message) {}
 
-    static std::shared_ptr<Packet> create(const std::string_view message) {
-        return std::make_shared<ChatMessagePacket>(message);
+    static PacketPtr<Packet> create(const std::string_view message) {
+        return makePacket<ChatMessagePacket>(message);
     }
 
     std::string message;
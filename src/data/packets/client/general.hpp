@@ -1,16 +1,17 @@
 #pragma once
-#include <data/packets/packet.hpp>
+#include <data/packets/pool.hpp>
 #include <data/types/gd.hpp>
 
 class SyncIconsPacket : public Packet {
     GLOBED_PACKET(11000, false)
 
     GLOBED_PACKET_ENCODE { buf.writeValue(icons); }
+    GLOBED_PACKET_ENCODED_SIZE { return PlayerIconData::ENCODED_SIZE; }
 
     SyncIconsPacket(const PlayerIconData& icons) : icons(icons) {}
 
-    static std::shared_ptr<Packet> create(const PlayerIconData& icons) {
-        return std::make_shared<SyncIconsPacket>(icons);
+    static PacketPtr<Packet> create(const PlayerIconData& icons) {
+        return makePacket<SyncIconsPacket>(icons);
     }
 
     PlayerIconData icons;
@@ -23,8 +24,8 @@ class RequestGlobalPlayerListPacket : public Packet {
 
     RequestGlobalPlayerListPacket() {}
 
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<RequestGlobalPlayerListPacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<RequestGlobalPlayerListPacket>();
     }
 };
 
@@ -35,8 +36,8 @@ class CreateRoomPacket : public Packet {
 
     CreateRoomPacket() {}
 
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<CreateRoomPacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<CreateRoomPacket>();
     }
 };
 
@@ -44,11 +45,12 @@ class JoinRoomPacket : public Packet {
     GLOBED_PACKET(11003, false)
 
     GLOBED_PACKET_ENCODE { buf.writeU32(roomId); }
+    GLOBED_PACKET_ENCODED_SIZE { return sizeof(uint32_t); }
 
     JoinRoomPacket(uint32_t roomId) : roomId(roomId) {}
 
-    static std::shared_ptr<Packet> create(uint32_t roomId) {
-        return std::make_shared<JoinRoomPacket>(roomId);
+    static PacketPtr<Packet> create(uint32_t roomId) {
+        return makePacket<JoinRoomPacket>(roomId);
     }
 
     uint32_t roomId;
@@ -61,8 +63,8 @@ class LeaveRoomPacket : public Packet {
 
     LeaveRoomPacket() {}
 
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<LeaveRoomPacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<LeaveRoomPacket>();
     }
 };
 
@@ -73,8 +75,8 @@ class RequestRoomPlayerListPacket : public Packet {
 
     RequestRoomPlayerListPacket() {}
 
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<RequestRoomPlayerListPacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<RequestRoomPlayerListPacket>();
     }
 };
 
@@ -85,7 +87,7 @@ class RequestLevelListPacket : public Packet {
 
     RequestLevelListPacket() {}
 
-    static std::shared_ptr<Packet> create() {
-        return std::make_shared<RequestLevelListPacket>();
+    static PacketPtr<Packet> create() {
+        return makePacket<RequestLevelListPacket>();
     }
 };
@@ -1,5 +1,5 @@
 #pragma once
-#include <data/packets/packet.hpp>
+#include <data/packets/pool.hpp>
 #include <data/types/gd.hpp>
 
 /*
@@ -22,8 +22,10 @@ public:
         buf.writeBytes(buffer.getDataRef());
     }
 
-    static std::shared_ptr<RawPacket> create(packetid_t id, bool encrypted, ByteBuffer&& buffer) {
-        return std::make_shared<RawPacket>(id, encrypted, std::move(buffer));
+    GLOBED_PACKET_ENCODED_SIZE { return buffer.size(); }
+
+    static PacketPtr<RawPacket> create(packetid_t id, bool encrypted, ByteBuffer&& buffer) {
+        return makePacket<RawPacket>(id, encrypted, std::move(buffer));
     }
 
     packetid_t id;
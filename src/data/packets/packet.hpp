@@ -1,6 +1,9 @@
 #pragma once
 #include <data/bytebuffer.hpp>
 
+#include <atomic>
+#include <utility>
+
 using packetid_t = uint16_t;
 #define GLOBED_PACKET(id,enc) \
     public: \
@@ -10,7 +13,11 @@ using packetid_t = uint16_t;
     bool getEncrypted() const override { return this->ENCRYPTED; }
 
 #define GLOBED_PACKET_ENCODE void encode(ByteBuffer& buf) const override
-#define GLOBED_PACKET_DECODE void decode(ByteBuffer& buf) override
+#define GLOBED_PACKET_DECODE void decode(ByteReader& buf) override
+#define GLOBED_PACKET_ENCODED_SIZE size_t encodedSize() const override
+
+template <typename T>
+concept HasPacketID = requires { T::PACKET_ID; };
 
 class Packet {
 public:
@@ -20,13 +27,103 @@ public:
         GLOBED_UNIMPL(std::string("Encoding unimplemented for packet ") + std::to_string(this->getPacketId()))
     };
 
-    // Decodes the packet from a bytebuffer
-    virtual void decode(ByteBuffer& buf) {
+    // Decodes the packet from a bytereader
+    virtual void decode(ByteReader& buf) {
         GLOBED_UNIMPL(std::string("Decoding unimplemented for packet ") + std::to_string(this->getPacketId()))
     };
 
+    // Returns the exact size of the encoded packet (without the header), used to preallocate the buffer before encoding.
+    // Packets that have no data don't need to override this.
+    virtual size_t encodedSize() const {
+        return 0;
+    }
+
     virtual packetid_t getPacketId() const = 0;
     virtual bool getEncrypted() const = 0;
+
+private:
+    template <typename T>
+    friend class PacketPtr;
+    template <typename T>
+    friend class PacketPool;
+    friend class PacketInbox;
+
+    std::atomic<uint32_t> refCount = 0;
+    // called instead of `delete` once the last `PacketPtr` is gone, set by `PacketPool`
+    void (*recycle)(Packet*) = nullptr;
+    // next packet in the `PacketInbox` queue
+    Packet* nextInInbox = nullptr;
+};
+
+/*
+* PacketPtr is an intrusively reference counted handle to a packet. Unlike `std::shared_ptr` it needs no separate control block,
+* and when the last handle is dropped, a pooled packet goes back to its `PacketPool` instead of being freed.
+*/
+template <typename T>
+class PacketPtr {
+public:
+    PacketPtr() : ptr(nullptr) {}
+    PacketPtr(std::nullptr_t) : ptr(nullptr) {}
+
+    explicit PacketPtr(T* ptr) : ptr(ptr) {
+        this->retain();
+    }
+
+    PacketPtr(const PacketPtr& other) : ptr(other.ptr) {
+        this->retain();
+    }
+
+    PacketPtr(PacketPtr&& other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+
+    template <typename U> requires std::is_convertible_v<U*, T*>
+    PacketPtr(const PacketPtr<U>& other) : ptr(other.get()) {
+        this->retain();
+    }
+
+    template <typename U> requires std::is_convertible_v<U*, T*>
+    PacketPtr(PacketPtr<U>&& other) noexcept : ptr(other.release()) {}
+
+    PacketPtr& operator=(PacketPtr other) noexcept {
+        std::swap(ptr, other.ptr);
+        return *this;
+    }
+
+    ~PacketPtr() {
+        if (!ptr) return;
+
+        if (ptr->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Packet* packet = ptr;
+            if (packet->recycle) {
+                packet->recycle(packet);
+            } else {
+                delete packet;
+            }
+        }
+    }
+
+    T* get() const { return ptr; }
+    T* operator->() const { return ptr; }
+    T& operator*() const { return *ptr; }
+
+    explicit operator bool() const { return ptr != nullptr; }
+    bool operator==(std::nullptr_t) const { return ptr == nullptr; }
+
+    // Gives up ownership without decrementing the reference count
+    T* release() { return std::exchange(ptr, nullptr); }
+
+    // Takes ownership of a pointer previously returned by `release`, without incrementing the reference count
+    static PacketPtr adopt(T* ptr) {
+        PacketPtr out;
+        out.ptr = ptr;
+        return out;
+    }
+
+private:
+    T* ptr;
+
+    void retain() {
+        if (ptr) ptr->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
 };
 
 class PacketHeader {
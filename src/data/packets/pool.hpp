@@ -0,0 +1,135 @@
+#pragma once
+#include "packet.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Packets that fully overwrite their previous state in `decode`, and so can be decoded into a recycled object as-is.
+// Anything they own (like the capacity of a vector) is kept between uses.
+template <typename T>
+concept DecodesInPlace = requires { requires T::DECODES_IN_PLACE; };
+
+/*
+* PacketPool keeps packets of one type around after they have been sent or handled, so creating a new one
+* in the steady state takes a recycled object instead of allocating.
+*
+* Recycled packets are destroyed right away and only their memory is kept, except for `DecodesInPlace` packets received
+* from the server, which stay constructed. The pool is shared by all threads.
+*/
+template <typename T>
+class PacketPool {
+public:
+    // packets over this amount are freed instead of being recycled
+    static constexpr size_t MAX_CACHED = 32;
+
+    static PacketPool& get() {
+        // never destroyed, as packets might still be alive while static destructors run
+        static PacketPool* instance = new PacketPool;
+        return *instance;
+    }
+
+    // Construct a packet with the given arguments
+    template <typename... Args>
+    PacketPtr<T> acquire(Args&&... args) {
+        auto [ptr, constructed] = this->take();
+
+        if (constructed) {
+            std::destroy_at(ptr);
+        }
+
+        try {
+            std::construct_at(ptr, std::forward<Args>(args)...);
+        } catch (...) {
+            this->deallocate(ptr);
+            throw;
+        }
+
+        ptr->recycle = &PacketPool::recycle;
+        return PacketPtr<T>(ptr);
+    }
+
+    // Returns a default constructed packet, or a recycled one if it can be decoded in place
+    PacketPtr<T> acquireForDecode() {
+        if constexpr (DecodesInPlace<T>) {
+            auto [ptr, constructed] = this->take();
+
+            if (!constructed) {
+                try {
+                    std::construct_at(ptr);
+                } catch (...) {
+                    this->deallocate(ptr);
+                    throw;
+                }
+
+                ptr->recycle = &PacketPool::recycleConstructed;
+            }
+
+            return PacketPtr<T>(ptr);
+        } else {
+            return this->acquire();
+        }
+    }
+
+private:
+    struct Slot {
+        T* ptr;
+        bool constructed;
+    };
+
+    std::mutex mtx;
+    std::vector<Slot> slots;
+
+    PacketPool() {
+        slots.reserve(MAX_CACHED);
+    }
+
+    Slot take() {
+        {
+            std::lock_guard lock(mtx);
+            if (!slots.empty()) {
+                auto slot = slots.back();
+                slots.pop_back();
+                return slot;
+            }
+        }
+
+        return Slot { .ptr = std::allocator<T>().allocate(1), .constructed = false };
+    }
+
+    void put(T* ptr, bool constructed) {
+        {
+            std::lock_guard lock(mtx);
+            if (slots.size() < MAX_CACHED) {
+                slots.push_back(Slot { .ptr = ptr, .constructed = constructed });
+                return;
+            }
+        }
+
+        if (constructed) {
+            std::destroy_at(ptr);
+        }
+
+        this->deallocate(ptr);
+    }
+
+    void deallocate(T* ptr) {
+        std::allocator<T>().deallocate(ptr, 1);
+    }
+
+    static void recycle(Packet* packet) {
+        auto* ptr = static_cast<T*>(packet);
+        std::destroy_at(ptr);
+        get().put(ptr, false);
+    }
+
+    static void recycleConstructed(Packet* packet) {
+        get().put(static_cast<T*>(packet), true);
+    }
+};
+
+// Create a packet, reusing the memory of a previously dropped packet of the same type if possible
+template <typename T, typename... Args>
+PacketPtr<T> makePacket(Args&&... args) {
+    return PacketPool<T>::get().acquire(std::forward<Args>(args)...);
+}
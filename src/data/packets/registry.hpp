@@ -0,0 +1,94 @@
+#pragma once
+#include "pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+// Packets where only the newest one matters, if several arrive before the main thread gets to them, the older ones are dropped.
+template <typename T>
+concept LatestOnly = requires { requires T::LATEST_ONLY; };
+
+/*
+* PacketList is a compile-time list of packet types. For every packet in the list it generates a dense index (its position in the list),
+* and a lookup table from packet ID to that index, so that finding and creating a packet by its ID is just two array accesses.
+*/
+template <HasPacketID... Packets>
+struct PacketList {
+    static constexpr size_t COUNT = sizeof...(Packets);
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    static constexpr packetid_t MIN_ID = std::min({Packets::PACKET_ID...});
+    static constexpr packetid_t MAX_ID = std::max({Packets::PACKET_ID...});
+
+    // Index of the packet type in the list, fails to compile if it isn't in the list
+    template <HasPacketID P>
+    static constexpr size_t indexOf() {
+        constexpr std::array<bool, COUNT> matches = {std::is_same_v<P, Packets>...};
+
+        constexpr size_t index = [&] {
+            for (size_t i = 0; i < COUNT; i++) {
+                if (matches[i]) return i;
+            }
+
+            return NOT_FOUND;
+        }();
+
+        static_assert(index != NOT_FOUND, "packet is not in the packet list");
+        return index;
+    }
+
+    // Index of the packet with this ID, or `NOT_FOUND`
+    static constexpr size_t indexOf(packetid_t id) {
+        if (id < MIN_ID || id > MAX_ID) return NOT_FOUND;
+
+        uint8_t entry = ID_TABLE[id - MIN_ID];
+        return entry == 0 ? NOT_FOUND : entry - 1;
+    }
+
+    // Create a pooled packet by its index, ready to be decoded into
+    static PacketPtr<Packet> create(size_t index) {
+        return FACTORIES[index]();
+    }
+
+    // Whether the packet at this index is `LatestOnly`
+    static constexpr bool isLatestOnly(size_t index) {
+        return LATEST_ONLY[index];
+    }
+
+    // Whether the packet at this index must arrive encrypted
+    static constexpr bool isEncrypted(size_t index) {
+        return ENCRYPTED[index];
+    }
+
+private:
+    static_assert(COUNT < std::numeric_limits<uint8_t>::max(), "too many packets for the lookup table");
+
+    using Factory = PacketPtr<Packet>(*)();
+
+    template <typename P>
+    static PacketPtr<Packet> createPacket() {
+        return PacketPool<P>::get().acquireForDecode();
+    }
+
+    static constexpr std::array<Factory, COUNT> FACTORIES = {&createPacket<Packets>...};
+    static constexpr std::array<bool, COUNT> LATEST_ONLY = {LatestOnly<Packets>...};
+    static constexpr std::array<bool, COUNT> ENCRYPTED = {Packets::ENCRYPTED...};
+
+    // index + 1 for every ID between MIN_ID and MAX_ID, 0 for unused IDs
+    static constexpr auto ID_TABLE = [] {
+        std::array<uint8_t, MAX_ID - MIN_ID + 1> table{};
+        std::array<packetid_t, COUNT> ids = {Packets::PACKET_ID...};
+
+        for (size_t i = 0; i < COUNT; i++) {
+            auto& entry = table[ids[i] - MIN_ID];
+
+            // not a constant expression, so two packets with the same ID fail to compile
+            if (entry != 0) throw "duplicate packet ID in the packet list";
+
+            entry = static_cast<uint8_t>(i + 1);
+        }
+
+        return table;
+    }();
+};
@@ -1,45 +1,102 @@
 #pragma once
 #include <data/packets/packet.hpp>
+#include <data/types/audio.hpp>
 #include <data/types/gd.hpp>
 
 class PlayerProfilesPacket : public Packet {
     GLOBED_PACKET(22000, false)
 
+    static constexpr bool DECODES_IN_PLACE = true;
+
     GLOBED_PACKET_DECODE {
-        players = buf.readValueVector<PlayerAccountData>();
+        buf.readValueVectorInto(players, LengthPrefix::Varint);
     }
 
     std::vector<PlayerAccountData> players;
 };
 
+/*
+* Every entry is either a full snapshot of the player's data, or a delta against the snapshot that was sent in the packet `baseline`,
+* which is the latest packet the client has acknowledged (see `PlayerDataPacket::acknowledged` and `LevelSnapshotHistory`).
+*
+* Each entry starts with a tag byte:
+*   0            - the player has not sent any data yet
+*   1 ..= 72     - full data of that length follows
+*   0x80         - unchanged since the baseline
+*   0x80 | n     - data of length n, XOR'd with the baseline. Followed by a bitmask of ceil(n / 8) bytes (MSB first)
+*                  with a bit set for every byte that changed, and then the XOR'd value of each of those bytes.
+*/
 class LevelDataPacket : public Packet {
     GLOBED_PACKET(22001, false)
 
+    static constexpr uint8_t DELTA_FLAG = 0x80;
+    static constexpr bool DECODES_IN_PLACE = true;
+    // deltas are always against a snapshot the client acknowledged, so skipping packets is fine
+    static constexpr bool LATEST_ONLY = true;
+
+    struct Entry {
+        int accountId;
+        bool isDelta;
+        // full data, or the data XOR'd with the baseline if `isDelta` is true
+        EncodedPlayerData data;
+    };
+
     GLOBED_PACKET_DECODE {
-        players = buf.readValueVector<AssociatedPlayerData>();
+        sequence = buf.readU32();
+        baseline = buf.readU32();
+
+        // every entry is at least an account ID and a tag
+        auto count = buf.readListLength(sizeof(int32_t) + sizeof(uint8_t));
+        entries.clear();
+        entries.reserve(count);
+
+        for (size_t i = 0; i < count; i++) {
+            int accountId = buf.readI32();
+            uint8_t tag = buf.readU8();
+            if (tag == 0) continue;
+
+            auto& entry = entries.emplace_back();
+            entry.accountId = accountId;
+            entry.isDelta = (tag & DELTA_FLAG) != 0;
+
+            size_t length = tag & ~DELTA_FLAG;
+            GLOBED_REQUIRE(length <= PlayerData::MAX_BODY_SIZE, "PlayerData in LevelDataPacket is too long")
+            entry.data.length = static_cast<uint8_t>(length);
+
+            if (!entry.isDelta) {
+                buf.readBytesInto(entry.data.data.data(), length);
+                continue;
+            }
+
+            util::data::bytearray<util::data::bitsToBytes(PlayerData::MAX_BODY_SIZE)> mask;
+            buf.readBytesInto(mask.data(), util::data::bitsToBytes(length));
+
+            for (size_t j = 0; j < length; j++) {
+                if (mask[j / 8] & (0x80 >> (j % 8))) {
+                    entry.data.data[j] = buf.readU8();
+                }
+            }
+        }
     }
 
-    std::vector<AssociatedPlayerData> players;
+    uint32_t sequence;
+    uint32_t baseline; // 0 if every entry is a full snapshot
+    std::vector<Entry> entries;
 };
 
-#if GLOBED_VOICE_SUPPORT
-#include <audio/frame.hpp>
-#endif
-
 class VoiceBroadcastPacket : public Packet {
     GLOBED_PACKET(22010, true)
 
-#if GLOBED_VOICE_SUPPORT
+    // the frame buffer is reused, so a steady stream of voice doesn't allocate
+    static constexpr bool DECODES_IN_PLACE = true;
+
     GLOBED_PACKET_DECODE {
         sender = buf.readI32();
-        frame = buf.readValue<EncodedAudioFrame>();
+        frame.decode(buf);
     }
 
     int sender;
-    EncodedAudioFrame frame;
-#else
-    GLOBED_PACKET_DECODE {}
-#endif // GLOBED_VOICE_SUPPORT
+    ReceivedAudioFrame frame;
 };
 
 class ChatMessageBroadcastPacket : public Packet {
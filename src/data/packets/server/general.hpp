@@ -34,7 +34,7 @@ class RoomPlayerListPacket : public Packet {
 
     GLOBED_PACKET_DECODE {
         roomId = buf.readU32();
-        buf.readValueVectorInto<PlayerRoomPreviewAccountData>(data);
+        buf.readValueVectorInto<PlayerRoomPreviewAccountData>(data, LengthPrefix::Varint);
     }
 
     uint32_t roomId;
@@ -45,7 +45,7 @@ class LevelListPacket : public Packet {
     GLOBED_PACKET(21005, false)
 
     GLOBED_PACKET_DECODE {
-        buf.readValueVectorInto<GlobedLevel>(levels);
+        buf.readValueVectorInto<GlobedLevel>(levels, LengthPrefix::Varint);
     }
 
     std::vector<GlobedLevel> levels;
@@ -0,0 +1,363 @@
+/*
+* Field schemas - declare the list of fields of a structure once, and get the encode/decode/encodedSize/operator== for free.
+*
+* class Foo {
+* public:
+*     int32_t id;
+*     std::string name;
+*
+*     GLOBED_FIELDS(Foo, id, name)
+* };
+*
+* Fields are encoded in the order they are listed in, using the same wire format as the hand-written
+* ByteBuffer methods (writeI32, writeString, writeValue, writeOptionalValue, writeValueVector, ...).
+*
+* If every field has a fixed encoded size, use GLOBED_FIXED_FIELDS instead. That additionally defines `ENCODED_SIZE`
+* and makes `decode` do a single bounds check for the whole structure, followed by unchecked reads.
+*
+* Lists of fixed-size records can also be encoded column by column with `FieldSchema::writeColumnar`,
+* which lets every column be converted with a single bulk `writeArray` call.
+*/
+
+#pragma once
+#include "bytebuffer.hpp"
+
+#include <tuple>
+
+class FieldSchema {
+public:
+    // Write all fields from a tuple of references
+    template <typename Tuple>
+    static void encode(ByteBuffer& buf, const Tuple& fields) {
+        std::apply([&](const auto&... field) {
+            (writeField(buf, field), ...);
+        }, fields);
+    }
+
+    // Read all fields into a tuple of references
+    template <typename Tuple>
+    static void decode(ByteReader& buf, const Tuple& fields) {
+        std::apply([&](auto&... field) {
+            (readField(buf, field), ...);
+        }, fields);
+    }
+
+    // Read all fields into a tuple of references, without bounds checks.
+    // The caller must ensure there is at least `fixedSizeOf<Tuple>()` bytes left.
+    template <typename Tuple>
+    static void decodeUnchecked(ByteReader& buf, const Tuple& fields) {
+        std::apply([&](auto&... field) {
+            (readFieldUnchecked(buf, field), ...);
+        }, fields);
+    }
+
+    // Calculate the encoded size of all fields from a tuple of references
+    template <typename Tuple>
+    static size_t encodedSize(const Tuple& fields) {
+        return std::apply([](const auto&... field) -> size_t {
+            return (static_cast<size_t>(0) + ... + sizeOfField(field));
+        }, fields);
+    }
+
+    // Returns the encoded size of a tuple of fields if all of them have a fixed size, otherwise 0
+    template <typename Tuple>
+    static constexpr size_t fixedSizeOf() {
+        return []<size_t... I>(std::index_sequence<I...>) -> size_t {
+            constexpr size_t sizes[] = { 0, fixedSizeOfField<std::remove_cvref_t<std::tuple_element_t<I, Tuple>>>()... };
+
+            size_t total = 0;
+            for (size_t i = 1; i < sizeof...(I) + 1; i++) {
+                if (sizes[i] == 0) return 0;
+                total += sizes[i];
+            }
+
+            return total;
+        }(std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+    }
+
+    // Returns the encoded size of a single field type, or 0 if it can vary
+    template <typename T>
+    static constexpr size_t fixedSizeOfField() {
+        if constexpr (std::is_same_v<T, bool>) {
+            return 1;
+        } else if constexpr (util::data::IsPrimitive<T>) {
+            return sizeof(T);
+        } else if constexpr (std::is_enum_v<T>) {
+            return sizeof(std::underlying_type_t<T>);
+        } else if constexpr (std::is_same_v<T, cocos2d::CCPoint>) {
+            return sizeof(float) * 2;
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor3B>) {
+            return 3;
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor4B>) {
+            return 4;
+        } else if constexpr (IsArray<T>::value) {
+            return IsArray<T>::size * fixedSizeOfField<typename IsArray<T>::value_type>();
+        } else if constexpr (StaticSize<T>) {
+            return T::ENCODED_SIZE;
+        } else {
+            return 0;
+        }
+    }
+
+    // Returns the smallest possible encoded size of a tuple of fields
+    template <typename Tuple>
+    static constexpr size_t minSizeOf() {
+        return []<size_t... I>(std::index_sequence<I...>) -> size_t {
+            return (static_cast<size_t>(0) + ... + minSizeOfField<std::remove_cvref_t<std::tuple_element_t<I, Tuple>>>());
+        }(std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+    }
+
+    // Returns the smallest possible encoded size of a single field type
+    template <typename T>
+    static constexpr size_t minSizeOfField() {
+        if constexpr (fixedSizeOfField<T>() != 0) {
+            return fixedSizeOfField<T>();
+        } else if constexpr (std::is_same_v<T, std::string> || IsVector<T>::value) {
+            return sizeof(uint32_t);
+        } else if constexpr (IsOptional<T>::value) {
+            return sizeof(bool);
+        } else if constexpr (IsArray<T>::value) {
+            return IsArray<T>::size * minSizeOfField<typename IsArray<T>::value_type>();
+        } else {
+            return minEncodedSize<T>();
+        }
+    }
+
+    // Write a list of records prefixed with 4 bytes indicating the count, column by column:
+    // first the first field of every record, then the second field of every record, and so on.
+    // Records must use GLOBED_FIXED_FIELDS, and all fields must be primitives or points.
+    template <typename T>
+    static void writeColumnar(ByteBuffer& buf, std::span<const T> values) {
+        buf.writeU32(values.size());
+
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (writeColumn<I>(buf, values), ...);
+        }(std::make_index_sequence<fieldCount<T>()>{});
+    }
+
+    // Read a list of records written by `writeColumnar`, replacing the contents of `out`
+    template <typename T>
+    static void readColumnarInto(ByteReader& buf, std::vector<T>& out) {
+        size_t count = buf.readListLength(T::ENCODED_SIZE);
+
+        out.resize(count);
+
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (readColumn<I>(buf, out), ...);
+        }(std::make_index_sequence<fieldCount<T>()>{});
+    }
+
+private:
+    template <typename T>
+    using FieldsOf = decltype(std::declval<T&>()._globedFields());
+
+    template <typename T>
+    static constexpr size_t fieldCount() {
+        static_assert(StaticSize<T>, "columnar encoding requires a type with GLOBED_FIXED_FIELDS");
+        return std::tuple_size_v<FieldsOf<T>>;
+    }
+
+    template <size_t I, typename T>
+    using ColumnType = std::remove_cvref_t<std::tuple_element_t<I, FieldsOf<T>>>;
+
+    template <size_t I, typename T>
+    static void writeColumn(ByteBuffer& buf, std::span<const T> values) {
+        using F = ColumnType<I, T>;
+        static_assert(BulkEncodable<F>, "columnar encoding only supports primitive or point fields");
+
+        std::vector<F> column;
+        column.reserve(values.size());
+        for (const T& value : values) {
+            column.push_back(std::get<I>(value._globedFields()));
+        }
+
+        buf.writeArray<F>(column);
+    }
+
+    template <size_t I, typename T>
+    static void readColumn(ByteReader& buf, std::vector<T>& out) {
+        using F = ColumnType<I, T>;
+        static_assert(BulkEncodable<F>, "columnar encoding only supports primitive or point fields");
+
+        std::vector<F> column(out.size());
+        buf.readArrayInto<F>(column);
+
+        for (size_t i = 0; i < out.size(); i++) {
+            std::get<I>(out[i]._globedFields()) = column[i];
+        }
+    }
+
+    template <typename T> struct IsOptional : std::false_type {};
+    template <typename T> struct IsOptional<std::optional<T>> : std::true_type {};
+
+    template <typename T> struct IsVector : std::false_type {};
+    template <typename T> struct IsVector<std::vector<T>> : std::true_type {};
+
+    template <typename T> struct IsArray : std::false_type {};
+    template <typename T, size_t N> struct IsArray<std::array<T, N>> : std::true_type {
+        using value_type = T;
+        static constexpr size_t size = N;
+    };
+
+    template <typename T>
+    static constexpr bool dependentFalse = false;
+
+    template <typename T>
+    static void writeField(ByteBuffer& buf, const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            buf.writeBool(value);
+        } else if constexpr (util::data::IsPrimitive<T>) {
+            buf.writePrimitive<T>(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            buf.writeEnum(value);
+        } else if constexpr (std::is_same_v<T, cocos2d::CCPoint>) {
+            buf.writePoint(value);
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor3B>) {
+            buf.writeColor3(value);
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor4B>) {
+            buf.writeColor4(value);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            buf.writeString(value);
+        } else if constexpr (IsOptional<T>::value) {
+            buf.writeBool(value.has_value());
+            if (value) {
+                writeField(buf, value.value());
+            }
+        } else if constexpr (IsVector<T>::value) {
+            buf.writeU32(value.size());
+            for (const auto& elem : value) {
+                writeField(buf, elem);
+            }
+        } else if constexpr (IsArray<T>::value && BulkEncodable<typename IsArray<T>::value_type>) {
+            buf.writeArray<typename IsArray<T>::value_type>(value);
+        } else if constexpr (IsArray<T>::value) {
+            for (const auto& elem : value) {
+                writeField(buf, elem);
+            }
+        } else if constexpr (Encodable<T>) {
+            buf.writeValue(value);
+        } else {
+            static_assert(dependentFalse<T>, "unsupported field type in a GLOBED_FIELDS schema");
+        }
+    }
+
+    template <typename T>
+    static void readField(ByteReader& buf, T& out) {
+        if constexpr (std::is_same_v<T, bool>) {
+            out = buf.readBool();
+        } else if constexpr (util::data::IsPrimitive<T>) {
+            out = buf.readPrimitive<T>();
+        } else if constexpr (std::is_enum_v<T>) {
+            out = buf.readEnum<T>();
+        } else if constexpr (std::is_same_v<T, cocos2d::CCPoint>) {
+            out = buf.readPoint();
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor3B>) {
+            out = buf.readColor3();
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor4B>) {
+            out = buf.readColor4();
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            out = buf.readStringView();
+        } else if constexpr (IsOptional<T>::value) {
+            if (buf.readBool()) {
+                readField(buf, out.emplace());
+            } else {
+                out.reset();
+            }
+        } else if constexpr (IsVector<T>::value) {
+            auto length = buf.readListLength(minSizeOfField<typename T::value_type>());
+            out.resize(length);
+            for (auto& elem : out) {
+                readField(buf, elem);
+            }
+        } else if constexpr (IsArray<T>::value && BulkEncodable<typename IsArray<T>::value_type>) {
+            buf.readArrayInto<typename IsArray<T>::value_type>(out);
+        } else if constexpr (IsArray<T>::value) {
+            for (auto& elem : out) {
+                readField(buf, elem);
+            }
+        } else if constexpr (Decodable<T>) {
+            out.decode(buf);
+        } else {
+            static_assert(dependentFalse<T>, "unsupported field type in a GLOBED_FIELDS schema");
+        }
+    }
+
+    // only ever called for fields where `fixedSizeOfField<T>() != 0`
+    template <typename T>
+    static void readFieldUnchecked(ByteReader& buf, T& out) {
+        if constexpr (std::is_same_v<T, bool>) {
+            out = buf.readUnchecked<uint8_t>() != 0;
+        } else if constexpr (util::data::IsPrimitive<T>) {
+            out = buf.readUnchecked<T>();
+        } else if constexpr (std::is_enum_v<T>) {
+            out = static_cast<T>(buf.readUnchecked<std::underlying_type_t<T>>());
+        } else if constexpr (std::is_same_v<T, cocos2d::CCPoint>) {
+            float x = buf.readUnchecked<float>();
+            float y = buf.readUnchecked<float>();
+            out = cocos2d::CCPoint(x, y);
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor3B>) {
+            out.r = buf.readUnchecked<uint8_t>();
+            out.g = buf.readUnchecked<uint8_t>();
+            out.b = buf.readUnchecked<uint8_t>();
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor4B>) {
+            out.r = buf.readUnchecked<uint8_t>();
+            out.g = buf.readUnchecked<uint8_t>();
+            out.b = buf.readUnchecked<uint8_t>();
+            out.a = buf.readUnchecked<uint8_t>();
+        } else if constexpr (IsArray<T>::value && BulkEncodable<typename IsArray<T>::value_type>) {
+            buf.readArrayInto<typename IsArray<T>::value_type>(out);
+        } else if constexpr (IsArray<T>::value) {
+            for (auto& elem : out) {
+                readFieldUnchecked(buf, elem);
+            }
+        } else if constexpr (requires { out.decodeUnchecked(buf); }) {
+            out.decodeUnchecked(buf);
+        } else {
+            // hand-written StaticSize type, just let it do its own bounds checks
+            out.decode(buf);
+        }
+    }
+
+    template <typename T>
+    static size_t sizeOfField(const T& value) {
+        if constexpr (fixedSizeOfField<T>() != 0) {
+            return fixedSizeOfField<T>();
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return ByteBuffer::sizeOfString(value);
+        } else if constexpr (IsOptional<T>::value) {
+            return sizeof(bool) + (value.has_value() ? sizeOfField(value.value()) : 0);
+        } else if constexpr (IsVector<T>::value || IsArray<T>::value) {
+            size_t total = IsVector<T>::value ? sizeof(uint32_t) : 0;
+            for (const auto& elem : value) {
+                total += sizeOfField(elem);
+            }
+
+            return total;
+        } else {
+            return ByteBuffer::sizeOfValue(value);
+        }
+    }
+};
+
+// Generates `encode`, `decode`, `encodedSize`, `MIN_ENCODED_SIZE` and `operator==` from the given list of fields
+#define GLOBED_FIELDS(Type, ...) \
+    static constexpr size_t MIN_ENCODED_SIZE = FieldSchema::minSizeOf<decltype(std::tie(__VA_ARGS__))>(); \
+    auto _globedFields() { return std::tie(__VA_ARGS__); } \
+    auto _globedFields() const { return std::tie(__VA_ARGS__); } \
+    bool operator==(const Type& other) const { return this->_globedFields() == other._globedFields(); } \
+    GLOBED_ENCODE { FieldSchema::encode(buf, this->_globedFields()); } \
+    GLOBED_DECODE { FieldSchema::decode(buf, this->_globedFields()); } \
+    size_t encodedSize() const { return FieldSchema::encodedSize(this->_globedFields()); }
+
+// Same as GLOBED_FIELDS, but every field must have a fixed size. Also defines `ENCODED_SIZE`,
+// and `decode` checks bounds only once for the entire structure.
+#define GLOBED_FIXED_FIELDS(Type, ...) \
+    static constexpr size_t ENCODED_SIZE = FieldSchema::fixedSizeOf<decltype(std::tie(__VA_ARGS__))>(); \
+    static_assert(ENCODED_SIZE != 0, "GLOBED_FIXED_FIELDS used on a type with dynamically sized fields, use GLOBED_FIELDS instead"); \
+    auto _globedFields() { return std::tie(__VA_ARGS__); } \
+    auto _globedFields() const { return std::tie(__VA_ARGS__); } \
+    bool operator==(const Type& other) const { return this->_globedFields() == other._globedFields(); } \
+    GLOBED_ENCODE { FieldSchema::encode(buf, this->_globedFields()); } \
+    GLOBED_DECODE { buf.ensureRemaining(ENCODED_SIZE); this->decodeUnchecked(buf); } \
+    inline void decodeUnchecked(ByteReader& buf) { FieldSchema::decodeUnchecked(buf, this->_globedFields()); } \
+    size_t encodedSize() const { return ENCODED_SIZE; }
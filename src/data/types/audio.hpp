@@ -0,0 +1,59 @@
+#pragma once
+#include <data/bytebuffer.hpp>
+
+#include <array>
+#include <span>
+
+/*
+* ReceivedAudioFrame is an `EncodedAudioFrame` sent by another player, as decoded from a `VoiceBroadcastPacket`.
+* The opus frames are stored back to back in a single buffer that keeps its capacity between decodes,
+* so decoding into a recycled packet doesn't allocate once the buffer has grown to the size of a typical frame.
+*
+* It doesn't depend on opus, so it's decoded the same way with or without voice support.
+*/
+class ReceivedAudioFrame {
+public:
+    // same as `EncodedAudioFrame::VOICE_MAX_FRAMES_IN_AUDIO_FRAME` and `VOICE_MAX_BYTES_IN_FRAME`
+    static constexpr size_t MAX_FRAMES = 10;
+    static constexpr size_t MAX_BYTES_IN_FRAME = 1000;
+
+    size_t size() const {
+        return count;
+    }
+
+    // the encoded opus frame, valid until the next decode
+    std::span<const util::data::byte> operator[](size_t index) const {
+        const auto& range = ranges[index];
+        return std::span(storage.data() + range.offset, range.length);
+    }
+
+    // same format as `EncodedAudioFrame::encode`, every slot is an optional byte array
+    GLOBED_DECODE {
+        storage.clear();
+        count = 0;
+
+        for (size_t i = 0; i < MAX_FRAMES; i++) {
+            if (!buf.readBool()) continue;
+
+            // when it comes to arbitrary allocation, DO NOT trust the sent data
+            size_t length = buf.readU32();
+            GLOBED_REQUIRE(length <= MAX_BYTES_IN_FRAME, fmt::format("Rejecting audio frame, size too large ({})", length))
+
+            size_t offset = storage.size();
+            storage.resize(offset + length);
+            buf.readBytesInto(storage.data() + offset, length);
+
+            ranges[count++] = Range { .offset = offset, .length = length };
+        }
+    }
+
+private:
+    struct Range {
+        size_t offset;
+        size_t length;
+    };
+
+    util::data::bytevector storage;
+    std::array<Range, MAX_FRAMES> ranges;
+    size_t count = 0;
+};
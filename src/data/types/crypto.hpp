@@ -12,6 +12,8 @@ public:
     CryptoPublicKey() {}
     CryptoPublicKey(util::data::bytearray<CryptoBox::KEY_LEN> key) : key(key) {}
 
+    static constexpr size_t ENCODED_SIZE = CryptoBox::KEY_LEN;
+
     GLOBED_ENCODE {
         buf.writeBytes(key);
     }
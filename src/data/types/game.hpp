@@ -1,5 +1,10 @@
 #pragma once
-#include <data/bytebuffer.hpp>
+#include <data/schema.hpp>
+#include <data/bitstream.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 enum class PlayerIconType : uint8_t {
     Unknown = 0,
@@ -17,24 +22,86 @@ enum class PlayerIconType : uint8_t {
 struct SpiderTeleportData {
     cocos2d::CCPoint from, to;
 
-    GLOBED_ENCODE {
-        buf.writePoint(from);
-        buf.writePoint(to);
+    GLOBED_FIXED_FIELDS(SpiderTeleportData, from, to)
+};
+
+/*
+* Fixed-point quantization used by the compact encoding of player data.
+* Positions are stored in 1/32 of a unit, rotations in 1/4096 of a full turn.
+*/
+struct PlayerDataQuantization {
+    static constexpr float POSITION_SCALE = 32.f;
+    static constexpr size_t POSITION_X_BITS = 29; // about +-8.3 million units
+    static constexpr size_t POSITION_Y_BITS = 25; // about +-524 thousand units
+    static constexpr size_t ROTATION_BITS = 12;
+    static constexpr size_t ICON_TYPE_BITS = 4;
+    static constexpr size_t POINT_BITS = POSITION_X_BITS + POSITION_Y_BITS;
+
+    static void writePoint(BitWriter& bits, cocos2d::CCPoint point) {
+        bits.writeSigned(quantizeAxis(point.x, POSITION_X_BITS), POSITION_X_BITS);
+        bits.writeSigned(quantizeAxis(point.y, POSITION_Y_BITS), POSITION_Y_BITS);
     }
 
-    GLOBED_DECODE {
-        from = buf.readPoint();
-        to = buf.readPoint();
+    static cocos2d::CCPoint readPoint(BitReader& bits) {
+        float x = static_cast<float>(bits.readSigned(POSITION_X_BITS)) / POSITION_SCALE;
+        float y = static_cast<float>(bits.readSigned(POSITION_Y_BITS)) / POSITION_SCALE;
+        return ccp(x, y);
+    }
+
+    // rotation is wrapped to [0, 360), so the receiver must interpolate it as an angle
+    static void writeRotation(BitWriter& bits, float rotation) {
+        constexpr float steps = static_cast<float>(1 << ROTATION_BITS);
+
+        float wrapped = std::fmod(std::isfinite(rotation) ? rotation : 0.f, 360.f);
+        if (wrapped < 0.f) wrapped += 360.f;
+
+        auto value = static_cast<uint32_t>(std::lround(wrapped / 360.f * steps)) & ((1u << ROTATION_BITS) - 1);
+        bits.writeUnsigned(value, ROTATION_BITS);
+    }
+
+    static float readRotation(BitReader& bits) {
+        constexpr float steps = static_cast<float>(1 << ROTATION_BITS);
+        return static_cast<float>(bits.readUnsigned(ROTATION_BITS)) * 360.f / steps;
+    }
+
+    // [0, 1] -> u16
+    static uint16_t quantizeFraction(float value) {
+        if (!(value > 0.f)) return 0;
+        if (value >= 1.f) return 0xffff;
+        return static_cast<uint16_t>(std::lround(value * 65535.f));
+    }
+
+    static float dequantizeFraction(uint16_t value) {
+        return static_cast<float>(value) / 65535.f;
+    }
+
+private:
+    // values out of range are clamped rather than rejected, so a player flying off somewhere far doesn't stop sending data
+    static int64_t quantizeAxis(float value, size_t bitCount) {
+        const int64_t limit = (int64_t(1) << (bitCount - 1)) - 1;
+        if (!std::isfinite(value)) return 0;
+
+        double scaled = std::round(static_cast<double>(value) * POSITION_SCALE);
+        return static_cast<int64_t>(std::clamp(scaled, static_cast<double>(-limit), static_cast<double>(limit)));
     }
 };
 
 struct SpecificIconData {
-    GLOBED_ENCODE {
-        buf.writePoint(position);
-        buf.writeF32(rotation);
+    // size of the compact encoding without spider teleport data, in bits
+    static constexpr size_t COMPACT_BITS = PlayerDataQuantization::POINT_BITS + PlayerDataQuantization::ROTATION_BITS
+        + PlayerDataQuantization::ICON_TYPE_BITS + 8;
+    static constexpr size_t COMPACT_TELEPORT_BITS = PlayerDataQuantization::POINT_BITS * 2;
+
+    bool operator==(const SpecificIconData&) const = default;
+
+    // Compact encoding, only ever used as a part of `PlayerData`. Whether `spiderTeleportData` is present
+    // is stored in the `PlayerData` header, so it must be passed back to `decodeCompact`.
+    void encodeCompact(BitWriter& bits) const {
+        PlayerDataQuantization::writePoint(bits, position);
+        PlayerDataQuantization::writeRotation(bits, rotation);
 
-        buf.writeEnum(iconType);
-        buf.writeBits(BitBuffer<16>(
+        bits.writeEnum(iconType, PlayerDataQuantization::ICON_TYPE_BITS);
+        bits.writeBits(
             isVisible,
             isLookingLeft,
             isUpsideDown,
@@ -43,22 +110,25 @@ struct SpecificIconData {
             isGrounded,
             isStationary,
             isFalling
-        ));
+        );
 
-        buf.writeOptionalValue(spiderTeleportData);
+        if (spiderTeleportData) {
+            PlayerDataQuantization::writePoint(bits, spiderTeleportData->from);
+            PlayerDataQuantization::writePoint(bits, spiderTeleportData->to);
+        }
     }
 
-    GLOBED_DECODE {
-        position = buf.readPoint();
-        rotation = buf.readF32();
+    void decodeCompact(BitReader& bits, bool hasTeleport) {
+        position = PlayerDataQuantization::readPoint(bits);
+        rotation = PlayerDataQuantization::readRotation(bits);
 
-        iconType = buf.readEnum<PlayerIconType>();
+        iconType = bits.readEnum<PlayerIconType>(PlayerDataQuantization::ICON_TYPE_BITS);
         GLOBED_REQUIRE(iconType >= PlayerIconType::Unknown && iconType <= PlayerIconType::Swing, "invalid PlayerIconType value encountered when decoding SpecificIconData")
         if (iconType == PlayerIconType::Unknown) {
             iconType = PlayerIconType::Cube;
         }
 
-        buf.readBits<16>().readBitsInto(
+        bits.readBitsInto(
             isVisible,
             isLookingLeft,
             isUpsideDown,
@@ -69,7 +139,16 @@ struct SpecificIconData {
             isFalling
         );
 
-        spiderTeleportData = buf.readOptionalValue<SpiderTeleportData>();
+        spiderTeleportData.reset();
+        if (hasTeleport) {
+            auto from = PlayerDataQuantization::readPoint(bits);
+            auto to = PlayerDataQuantization::readPoint(bits);
+            spiderTeleportData = SpiderTeleportData { .from = from, .to = to };
+        }
+    }
+
+    size_t compactBits() const {
+        return COMPACT_BITS + (spiderTeleportData.has_value() ? COMPACT_TELEPORT_BITS : 0);
     }
 
     void copyFlagsFrom(const SpecificIconData& other) {
@@ -100,49 +179,183 @@ struct SpecificIconData {
     std::optional<SpiderTeleportData> spiderTeleportData;
 };
 
+/*
+* PlayerData is sent in a compact form, prefixed with a single byte indicating its length:
+*
+* bits (flushed to whole bytes):
+*   header - isDualMode, p1 teleport, p2 teleport, has lastDeathTimestamp, isDead, isPaused, isPracticing
+*   player1 (see SpecificIconData::encodeCompact)
+*   player2, only in dual mode
+* f32 timestamp
+* varuint localBest
+* varint attempts
+* f32 lastDeathTimestamp, only if present
+* u16 currentPercentage (fixed-point fraction)
+*
+* The server does not look inside of it, it just stores the latest one for every player and forwards it to others.
+* A length of 0 means the player has not sent any data yet.
+*/
 struct PlayerData {
+    static constexpr size_t HEADER_BITS = 7;
+    // must not exceed the server's MAX_PLAYER_DATA_SIZE
+    static constexpr size_t MAX_BODY_SIZE = 72;
+    // length prefix, header with a single player and no optional fields, 1-byte varints
+    static constexpr size_t MIN_ENCODED_SIZE = sizeof(uint8_t) + util::data::bitsToBytes(HEADER_BITS + SpecificIconData::COMPACT_BITS)
+        + sizeof(float) + 1 + 1 + sizeof(uint16_t);
+
+    bool operator==(const PlayerData&) const = default;
+
+    size_t encodedSize() const {
+        return sizeof(uint8_t) + this->bodySize();
+    }
+
     GLOBED_ENCODE {
-        buf.writeF32(timestamp);
-        buf.writeU32(localBest);
-        buf.writeI32(attempts);
+        size_t bodySize = this->bodySize();
+        GLOBED_REQUIRE(bodySize <= MAX_BODY_SIZE, "encoded PlayerData is too large")
 
-        buf.writeValue(player1);
-        buf.writeValue(player2);
+        buf.writeU8(static_cast<uint8_t>(bodySize));
 
-        buf.writeF32(lastDeathTimestamp);
+        {
+            BitWriter bits(buf);
+            bits.writeBits(
+                isDualMode,
+                player1.spiderTeleportData.has_value(),
+                isDualMode && player2.spiderTeleportData.has_value(),
+                lastDeathTimestamp.has_value(),
+                isDead,
+                isPaused,
+                isPracticing
+            );
 
-        buf.writeF32(currentPercentage);
+            player1.encodeCompact(bits);
+            if (isDualMode) {
+                player2.encodeCompact(bits);
+            }
 
-        buf.writeBits(BitBuffer<8>(isDead, isPaused, isPracticing));
+            bits.flush();
+        }
+
+        buf.writeF32(timestamp);
+        buf.writeVarUint(localBest);
+        buf.writeVarInt(attempts);
+
+        if (lastDeathTimestamp) {
+            buf.writeF32(lastDeathTimestamp.value());
+        }
+
+        buf.writeU16(PlayerDataQuantization::quantizeFraction(currentPercentage));
     }
 
     GLOBED_DECODE {
-        timestamp = buf.readF32();
-        localBest = buf.readU32();
-        attempts = buf.readI32();
+        size_t length = buf.readU8();
+        GLOBED_REQUIRE(length != 0, "PlayerData is empty")
+
+        this->decodeBody(buf, length);
+    }
+
+    // Decode the data after the length prefix. Always leaves `buf` right after the end of the data, even if there are trailing bytes.
+    void decodeBody(ByteReader& buf, size_t length) {
+        buf.ensureRemaining(length);
+        size_t end = buf.getPosition() + length;
 
-        player1 = buf.readValue<SpecificIconData>();
-        player2 = buf.readValue<SpecificIconData>();
+        bool hasP1Teleport, hasP2Teleport, hasLastDeath;
 
-        lastDeathTimestamp = buf.readF32();
+        {
+            BitReader bits(buf);
+            bits.readBitsInto(isDualMode, hasP1Teleport, hasP2Teleport, hasLastDeath, isDead, isPaused, isPracticing);
 
-        currentPercentage = buf.readF32();
+            player1.decodeCompact(bits, hasP1Teleport);
 
-        buf.readBits<8>().readBitsInto(isDead, isPaused, isPracticing);
+            if (isDualMode) {
+                player2.decodeCompact(bits, hasP2Teleport);
+            } else {
+                // the second player is invisible when not in dual mode, no point in sending it
+                player2 = player1;
+                player2.isVisible = false;
+                player2.spiderTeleportData.reset();
+            }
+        }
+
+        timestamp = buf.readF32();
+        localBest = static_cast<uint32_t>(buf.readVarUint());
+        attempts = static_cast<int32_t>(buf.readVarInt());
+
+        lastDeathTimestamp.reset();
+        if (hasLastDeath) {
+            lastDeathTimestamp = buf.readF32();
+        }
+
+        currentPercentage = PlayerDataQuantization::dequantizeFraction(buf.readU16());
+
+        GLOBED_REQUIRE(buf.getPosition() <= end, "PlayerData is longer than its length prefix")
+        buf.setPosition(end);
     }
 
     float timestamp;
     uint32_t localBest;
     int32_t attempts;
 
+    bool isDualMode;
     SpecificIconData player1;
     SpecificIconData player2;
 
-    float lastDeathTimestamp;
+    // only sent for a short while after it changes, see GlobedPlayLayer::gatherPlayerData
+    std::optional<float> lastDeathTimestamp;
 
     float currentPercentage;
 
     bool isDead;
     bool isPaused;
     bool isPracticing;
-};
\ No newline at end of file
+
+private:
+    size_t bodySize() const {
+        size_t bits = HEADER_BITS + player1.compactBits() + (isDualMode ? player2.compactBits() : 0);
+
+        return BitWriter::bytesForBits(bits)
+            + sizeof(float)
+            + ByteBuffer::sizeOfVarUint(localBest)
+            + ByteBuffer::sizeOfVarInt(attempts)
+            + (lastDeathTimestamp.has_value() ? sizeof(float) : 0)
+            + sizeof(uint16_t);
+    }
+};
+
+// the biggest possible PlayerData (dual mode, both players teleporting, 5-byte varints) has to fit
+static_assert(
+    util::data::bitsToBytes(PlayerData::HEADER_BITS + 2 * (SpecificIconData::COMPACT_BITS + SpecificIconData::COMPACT_TELEPORT_BITS))
+        + sizeof(float) * 2 + 5 + 5 + sizeof(uint16_t) <= PlayerData::MAX_BODY_SIZE
+);
+
+/*
+* PlayerData in its encoded form, without the length prefix. This is what the server stores and forwards,
+* and what `LevelDataPacket` deltas are computed against. Bytes past `length` are always zero.
+*/
+struct EncodedPlayerData {
+    std::array<util::data::byte, PlayerData::MAX_BODY_SIZE> data{};
+    uint8_t length = 0;
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    PlayerData decode() const {
+        ByteReader reader(data.data(), length);
+
+        PlayerData out;
+        out.decodeBody(reader, length);
+        return out;
+    }
+
+    // Reconstruct the data from a baseline and a delta (see `LevelDataPacket`). A delta with length 0 means the data is unchanged.
+    static EncodedPlayerData applyDelta(const EncodedPlayerData& baseline, const EncodedPlayerData& delta) {
+        EncodedPlayerData out;
+        out.length = delta.empty() ? baseline.length : delta.length;
+
+        for (size_t i = 0; i < out.length; i++) {
+            out.data[i] = baseline.data[i] ^ delta.data[i];
+        }
+
+        return out;
+    }
+};
@@ -3,7 +3,7 @@
 */
 
 #pragma once
-#include <data/bytebuffer.hpp>
+#include <data/schema.hpp>
 #include "game.hpp"
 
 class PlayerIconData {
@@ -17,41 +17,9 @@ public:
 
     PlayerIconData() {}
 
-    bool operator==(const PlayerIconData&) const = default;
-
-    GLOBED_ENCODE {
-        buf.writeI16(cube);
-        buf.writeI16(ship);
-        buf.writeI16(ball);
-        buf.writeI16(ufo);
-        buf.writeI16(wave);
-        buf.writeI16(robot);
-        buf.writeI16(spider);
-        buf.writeI16(swing);
-        buf.writeI16(jetpack);
-        buf.writeI16(deathEffect);
-        buf.writeI16(color1);
-        buf.writeI16(color2);
-        buf.writeI16(glowColor);
-    }
-
-    GLOBED_DECODE {
-        cube = buf.readI16();
-        ship = buf.readI16();
-        ball = buf.readI16();
-        ufo = buf.readI16();
-        wave = buf.readI16();
-        robot = buf.readI16();
-        spider = buf.readI16();
-        swing = buf.readI16();
-        jetpack = buf.readI16();
-        deathEffect = buf.readI16();
-        color1 = buf.readI16();
-        color2 = buf.readI16();
-        glowColor = buf.readI16();
-    }
-
     int16_t cube, ship, ball, ufo, wave, robot, spider, swing, jetpack, deathEffect, color1, color2, glowColor;
+
+    GLOBED_FIXED_FIELDS(PlayerIconData, cube, ship, ball, ufo, wave, robot, spider, swing, jetpack, deathEffect, color1, color2, glowColor)
 };
 
 inline const PlayerIconData PlayerIconData::DEFAULT_ICONS = PlayerIconData(
@@ -63,17 +31,9 @@ public:
     SpecialUserData(cocos2d::ccColor3B nameColor) : nameColor(nameColor) {}
     SpecialUserData() {}
 
-    bool operator==(const SpecialUserData&) const = default;
-
-    GLOBED_ENCODE {
-        buf.writeColor3(nameColor);
-    }
-
-    GLOBED_DECODE {
-        nameColor = buf.readColor3();
-    }
-
     cocos2d::ccColor3B nameColor;
+
+    GLOBED_FIXED_FIELDS(SpecialUserData, nameColor)
 };
 
 class PlayerAccountData {
@@ -85,26 +45,12 @@ public:
 
     PlayerAccountData() {}
 
-    bool operator==(const PlayerAccountData&) const = default;
-
-    GLOBED_ENCODE {
-        buf.writeI32(id);
-        buf.writeString(name);
-        buf.writeValue(icons);
-        buf.writeOptionalValue(specialUserData);
-    }
-
-    GLOBED_DECODE {
-        id = buf.readI32();
-        name = buf.readString();
-        icons = buf.readValue<PlayerIconData>();
-        specialUserData = buf.readOptionalValue<SpecialUserData>();
-    }
-
     int32_t id;
     std::string name;
     PlayerIconData icons;
     std::optional<SpecialUserData> specialUserData;
+
+    GLOBED_FIELDS(PlayerAccountData, id, name, icons, specialUserData)
 };
 
 inline const PlayerAccountData PlayerAccountData::DEFAULT_DATA = PlayerAccountData(
@@ -119,27 +65,11 @@ public:
         : id(id), name(name), cube(cube), color1(color1), color2(color2), glowColor(glowColor) {}
     PlayerPreviewAccountData() {}
 
-    GLOBED_ENCODE {
-        buf.writeI32(id);
-        buf.writeString(name);
-        buf.writeI16(cube);
-        buf.writeI16(color1);
-        buf.writeI16(color2);
-        buf.writeI16(glowColor);
-    }
-
-    GLOBED_DECODE {
-        id = buf.readI32();
-        name = buf.readString();
-        cube = buf.readI16();
-        color1 = buf.readI16();
-        color2 = buf.readI16();
-        glowColor = buf.readI16();
-    }
-
     int32_t id;
     std::string name;
     int16_t cube, color1, color2, glowColor;
+
+    GLOBED_FIELDS(PlayerPreviewAccountData, id, name, cube, color1, color2, glowColor)
 };
 
 class PlayerRoomPreviewAccountData {
@@ -148,30 +78,12 @@ public:
         : id(id), name(name), cube(cube), color1(color1), color2(color2), glowColor(glowColor), levelId(levelId) {}
     PlayerRoomPreviewAccountData() {}
 
-    GLOBED_ENCODE {
-        buf.writeI32(id);
-        buf.writeString(name);
-        buf.writeI16(cube);
-        buf.writeI16(color1);
-        buf.writeI16(color2);
-        buf.writeI16(glowColor);
-        buf.writeI32(levelId);
-    }
-
-    GLOBED_DECODE {
-        id = buf.readI32();
-        name = buf.readString();
-        cube = buf.readI16();
-        color1 = buf.readI16();
-        color2 = buf.readI16();
-        glowColor = buf.readI16();
-        levelId = buf.readI32();
-    }
-
     int32_t id;
     std::string name;
     int16_t cube, color1, color2, glowColor;
     int32_t levelId;
+
+    GLOBED_FIELDS(PlayerRoomPreviewAccountData, id, name, cube, color1, color2, glowColor, levelId)
 };
 
 class AssociatedPlayerData {
@@ -179,16 +91,8 @@ public:
     AssociatedPlayerData(int accountId, PlayerData data) : accountId(accountId), data(data) {}
     AssociatedPlayerData() {}
 
-    GLOBED_ENCODE {
-        buf.writeI32(accountId);
-        buf.writeValue(data);
-    }
-
-    GLOBED_DECODE {
-        accountId = buf.readI32();
-        data = buf.readValue<PlayerData>();
-    }
-
     int accountId;
     PlayerData data;
+
+    GLOBED_FIELDS(AssociatedPlayerData, accountId, data)
 };
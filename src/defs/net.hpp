@@ -4,6 +4,8 @@
 /*
 * GLOBED_SOCKET_POLL - poll function
 * GLOBED_SOCKET_POLLFD - pollfd structure
+* GLOBED_HAS_MMSG - recvmmsg and sendmmsg are available (Linux and Android)
+* GLOBED_HAS_EPOLL - epoll and eventfd are available (Linux and Android)
 */
 
 #ifdef GEODE_IS_WINDOWS
@@ -30,4 +32,9 @@
 # include <netdb.h> // struct addrinfo
 # include <cerrno>
 
+# ifdef __linux__
+#  define GLOBED_HAS_MMSG 1
+#  define GLOBED_HAS_EPOLL 1
+# endif
+
 #endif
@@ -6,13 +6,14 @@
 /*
 * platform macros
 * GLOBED_IS_UNIX - unix-like system
+* GLOBED_HEADLESS - defined when building outside of Geode (see bench/), the host is treated as a generic platform
 
 * GLOBED_PLATFORM_STRING_PLATFORM - string in format like "Mac", "Android", "Windows"
 * GLOBED_PLATFORM_STRING_ARCH - string in format like "x86", "x64", "armv7", "arm64"
 * GLOBED_PLATFORM_STRING - those two above combined into one, i.e. "Windows x86"
 */
 
-#if defined(GEODE_IS_MACOS) || defined(GEODE_IS_ANDROID)
+#if defined(GEODE_IS_MACOS) || defined(GEODE_IS_ANDROID) || (defined(GLOBED_HEADLESS) && !defined(_WIN32))
 # define GLOBED_IS_UNIX 1
 #endif
 
@@ -29,6 +30,9 @@
 # else
 #  define GLOBED_PLATFORM_STRING_ARCH "armeabi-v7a"
 # endif
+#elif defined(GLOBED_HEADLESS)
+# define GLOBED_PLATFORM_STRING_PLATFORM "Headless"
+# define GLOBED_PLATFORM_STRING_ARCH "native"
 #endif
 
 #define GLOBED_PLATFORM_STRING GLOBED_PLATFORM_STRING_PLATFORM " " GLOBED_PLATFORM_STRING_ARCH
@@ -50,6 +54,10 @@
 # define GLOBED_HAS_FMOD GLOBED_FMOD_ANDROID
 # define GLOBED_HAS_DRPC GLOBED_DRPC_ANDROID
 # define GLOBED_HAS_KEYBINDS 0
+#elif defined(GLOBED_HEADLESS)
+# define GLOBED_HAS_FMOD 0
+# define GLOBED_HAS_DRPC 0
+# define GLOBED_HAS_KEYBINDS 0
 #else
 # error "what"
 #endif
@@ -65,4 +73,21 @@
 # define GLOBED_VOICE_SUPPORT 0
 #endif
 
+/* SIMD:
+* GLOBED_SSE2 - 0 or 1, whether SSE2 intrinsics can be used
+* GLOBED_NEON - 0 or 1, whether NEON intrinsics can be used
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define GLOBED_SSE2 1
+#else
+# define GLOBED_SSE2 0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define GLOBED_NEON 1
+#else
+# define GLOBED_NEON 0
+#endif
+
 constexpr bool GLOBED_LITTLE_ENDIAN = std::endian::native == std::endian::little;
\ No newline at end of file
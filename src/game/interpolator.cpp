@@ -1,7 +1,11 @@
 #include "interpolator.hpp"
 
+#ifdef GLOBED_DEBUG_INTERPOLATION
 # include "lerp_logger.hpp"
-#include <hooks/play_layer.hpp>
+#endif
+#ifndef GLOBED_HEADLESS
+# include <hooks/play_layer.hpp>
+#endif
 #include <util/math.hpp>
 #include <util/debug.hpp>
 #include <util/format.hpp>
@@ -21,14 +25,19 @@ void PlayerInterpolator::removePlayer(int playerId) {
     players.erase(playerId);
 }
 
+bool PlayerInterpolator::hasPlayer(int playerId) {
+    return players.contains(playerId);
+}
+
 void PlayerInterpolator::updatePlayer(int playerId, const PlayerData& data, float updateCounter) {
     auto& player = players.at(playerId);
     player.updateCounter = updateCounter;
     player.pendingRealFrame = true;
     player.totalFrames++;
 
-    if (!util::math::equal(player.lastDeathTimestamp, data.lastDeathTimestamp)) {
-        player.lastDeathTimestamp = data.lastDeathTimestamp;
+    // the death timestamp is only sent for a short while after it changes
+    if (data.lastDeathTimestamp && !util::math::equal(player.lastDeathTimestamp, data.lastDeathTimestamp.value())) {
+        player.lastDeathTimestamp = data.lastDeathTimestamp.value();
         if (player.totalFrames > 1) {
             player.pendingDeath = true;
         }
@@ -37,7 +46,9 @@ void PlayerInterpolator::updatePlayer(int playerId, const PlayerData& data, floa
     player.pendingP1Teleport = data.player1.spiderTeleportData;
     player.pendingP2Teleport = data.player2.spiderTeleportData;
 
+#ifdef GLOBED_DEBUG_INTERPOLATION
     LerpLogger::get().logRealFrame(playerId, this->getLocalTs(), data.timestamp, data.player1);
+#endif
 
     if (settings.realtime) {
         player.interpolatedState = data;
@@ -68,7 +79,8 @@ static inline void lerpSpecific(
     } else {
         out.position = older.position.lerp(newer.position, lerpRatio);
     }
-    out.rotation = std::lerp(older.rotation, newer.rotation, lerpRatio);
+    // rotation is sent wrapped to [0, 360), so it must be interpolated through the shortest path
+    out.rotation = util::math::lerpAngle(older.rotation, newer.rotation, lerpRatio);
 }
 
 static inline void lerpPlayer(
@@ -98,7 +110,9 @@ void PlayerInterpolator::tick(float dt) {
         // why the fuck does a static non-changing number work better than an actual calculation
         float fakeFrameDelta = settings.expectedDelta;
         if (realFrameDelta == 0.f) {
+#ifdef GLOBED_DEBUG_INTERPOLATION
             LerpLogger::get().logLerpSkip(playerId, this->getLocalTs(), player.timeCounter, player.interpolatedState.player1);
+#endif
             continue;
         }
 
@@ -106,7 +120,9 @@ void PlayerInterpolator::tick(float dt) {
 
         lerpPlayer(player.olderFrame.visual, player.newerFrame.visual, player.interpolatedState, lerpRatio);
 
+#ifdef GLOBED_DEBUG_INTERPOLATION
         LerpLogger::get().logLerpOperation(playerId, this->getLocalTs(), player.timeCounter, player.interpolatedState.player1);
+#endif
 
         player.timeCounter += dt;
     }
@@ -138,8 +154,13 @@ bool PlayerInterpolator::isPlayerStale(int playerId, float lastServerPacket) {
 }
 
 float PlayerInterpolator::getLocalTs() {
+#ifdef GLOBED_HEADLESS
+    // there is no play layer outside of the game, see bench/
+    return 0.f;
+#else
     auto* gpl = static_cast<GlobedPlayLayer*>(PlayLayer::get());
     return gpl->m_fields->timeCounter;
+#endif
 }
 
 PlayerInterpolator::LerpFrame::LerpFrame() {
@@ -2,6 +2,7 @@
 #include <defs.hpp>
 
 #include <data/types/game.hpp>
+#include <data/schema.hpp>
 
 class LerpLogger : public SingletonBase<LerpLogger> {
 public:
@@ -25,22 +26,18 @@ private:
     PlayerLogData makeLogData(const SpecificIconData& data, float localts, float timeCounter);
 
     struct PlayerLogData {
-        GLOBED_ENCODE {
-            buf.writeF32(localTimestamp);
-            buf.writeF32(timestamp);
-            buf.writePoint(position);
-            buf.writeF32(rotation);
-        }
-
         float localTimestamp;
         float timestamp;
         cocos2d::CCPoint position;
         float rotation;
+
+        GLOBED_FIXED_FIELDS(PlayerLogData, localTimestamp, timestamp, position, rotation)
     };
 
+    // frame lists are written in columnar form, so they can be converted in bulk (see llgvis/src/structs.rs)
     struct PlayerLog {
         GLOBED_ENCODE {
-            buf.writeValueVector(realFrames);
+            FieldSchema::writeColumnar<PlayerLogData>(buf, realFrames);
 
             buf.writeU32(realExtrapolatedFrames.size());
             for (const auto& [real, extp] : realExtrapolatedFrames) {
@@ -48,8 +45,8 @@ private:
                 buf.writeValue(extp);
             }
 
-            buf.writeValueVector(lerpedFrames);
-            buf.writeValueVector(lerpSkippedFrames);
+            FieldSchema::writeColumnar<PlayerLogData>(buf, lerpedFrames);
+            FieldSchema::writeColumnar<PlayerLogData>(buf, lerpSkippedFrames);
         }
 
         std::vector<PlayerLogData> realFrames;
@@ -0,0 +1,66 @@
+#include "snapshot_history.hpp"
+
+void LevelSnapshotHistory::apply(const LevelDataPacket& packet, std::vector<AssociatedPlayerData>& out) {
+    out.clear();
+
+    const Snapshot* baseline = packet.baseline == 0 ? nullptr : this->find(packet.baseline);
+
+    pending.sequence = packet.sequence;
+    pending.players.clear();
+    bool complete = true;
+
+    for (const auto& entry : packet.entries) {
+        EncodedPlayerData data;
+
+        if (entry.isDelta) {
+            const EncodedPlayerData* base = baseline ? findPlayer(*baseline, entry.accountId) : nullptr;
+            if (!base) {
+                complete = false;
+                continue;
+            }
+
+            data = EncodedPlayerData::applyDelta(*base, entry.data);
+        } else {
+            data = entry.data;
+        }
+
+        if (data.empty()) continue;
+
+        // the raw data is kept even if it fails to decode, as the server will still send deltas against it
+        pending.players.emplace_back(entry.accountId, data);
+
+        try {
+            out.emplace_back(entry.accountId, data.decode());
+        } catch (const std::exception&) {}
+    }
+
+    // if anything is missing, this snapshot can't be used as a baseline
+    if (!complete) return;
+
+    std::sort(pending.players.begin(), pending.players.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    std::swap(snapshots[packet.sequence % CAPACITY], pending);
+
+    if (packet.sequence > acknowledged) {
+        acknowledged = packet.sequence;
+    }
+}
+
+uint32_t LevelSnapshotHistory::getAcknowledged() const {
+    return acknowledged;
+}
+
+const LevelSnapshotHistory::Snapshot* LevelSnapshotHistory::find(uint32_t sequence) const {
+    auto& snapshot = snapshots[sequence % CAPACITY];
+    return snapshot.sequence == sequence ? &snapshot : nullptr;
+}
+
+const EncodedPlayerData* LevelSnapshotHistory::findPlayer(const Snapshot& snapshot, int accountId) {
+    auto it = std::lower_bound(snapshot.players.begin(), snapshot.players.end(), accountId, [](const auto& entry, int id) {
+        return entry.first < id;
+    });
+
+    return (it != snapshot.players.end() && it->first == accountId) ? &it->second : nullptr;
+}
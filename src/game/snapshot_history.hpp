@@ -0,0 +1,34 @@
+#pragma once
+#include <defs.hpp>
+
+#include <data/packets/server/game.hpp>
+
+/*
+* LevelSnapshotHistory keeps the player data from the last few `LevelDataPacket`s, so that the deltas in new packets can be applied.
+* Only snapshots where every entry could be reconstructed are stored and acknowledged back to the server.
+*/
+class LevelSnapshotHistory {
+public:
+    // must be at least as big as the history on the server, otherwise deltas against older snapshots would be lost
+    static constexpr size_t CAPACITY = 16;
+
+    // Reconstruct the full player data from the packet into `out`. Entries that fail to decode, or depend on a baseline
+    // that is no longer known, are skipped.
+    void apply(const LevelDataPacket& packet, std::vector<AssociatedPlayerData>& out);
+
+    // Sequence number of the latest stored snapshot, 0 if there is none
+    uint32_t getAcknowledged() const;
+
+private:
+    struct Snapshot {
+        uint32_t sequence = 0;
+        std::vector<std::pair<int, EncodedPlayerData>> players; // sorted by account ID
+    };
+
+    std::array<Snapshot, CAPACITY> snapshots;
+    Snapshot pending; // built separately and swapped in, so the baseline can't be overwritten while it's in use
+    uint32_t acknowledged = 0;
+
+    const Snapshot* find(uint32_t sequence) const;
+    static const EncodedPlayerData* findPlayer(const Snapshot& snapshot, int accountId);
+};
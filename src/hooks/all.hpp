@@ -6,4 +6,5 @@
 #include "menu_layer.hpp"
 #include "pause_layer.hpp"
 #include "play_layer.hpp"
-#include "player_object.hpp"
\ No newline at end of file
+#include "player_object.hpp"
+#include "scheduler.hpp"
\ No newline at end of file
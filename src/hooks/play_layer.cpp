@@ -19,6 +19,8 @@ using namespace geode::prelude;
 
 // how many units before the voice disappears
 constexpr float PROXIMITY_VOICE_LIMIT = 1250.f;
+// how many player data packets after a death will include the death timestamp
+constexpr uint32_t DEATH_TIMESTAMP_REPEAT = 10;
 
 float adjustLerpTimeDelta(float dt) {
     // i fucking hate this i cannot do this anymore i want to die
@@ -200,7 +202,10 @@ void GlobedPlayLayer::setupPacketListeners() {
     nm.addListener<LevelDataPacket>([this](LevelDataPacket* packet){
         this->m_fields->lastServerUpdate = this->m_fields->timeCounter;
 
-        for (const auto& player : packet->players) {
+        auto& players = this->m_fields->receivedPlayers;
+        this->m_fields->snapshotHistory.apply(*packet, players);
+
+        for (const auto& player : players) {
             if (!this->m_fields->players.contains(player.accountId)) {
                 // new player joined
                 this->handlePlayerJoin(player.accountId);
@@ -310,7 +315,7 @@ void GlobedPlayLayer::selSendPlayerData(float) {
     if (self->m_fields->players.empty() && self->m_fields->totalSentPackets % 30 != 15) return;
 
     auto data = self->gatherPlayerData();
-    NetworkManager::get().send(PlayerDataPacket::create(data));
+    NetworkManager::get().sendLatest<PlayerDataPacket>(PlayerDataPacket::create(self->m_fields->snapshotHistory.getAcknowledged(), data));
 }
 
 // selPeriodicalUpdate - runs 4 times a second, does various stuff
@@ -354,12 +359,12 @@ void GlobedPlayLayer::selPeriodicalUpdate(float) {
             if (data.has_value()) {
                 // if the profile data already exists in cache, use it
                 remotePlayer->updateAccountData(data.value(), true);
-            } else if (remotePlayer->getDefaultTicks() >= 12) {
-                // if it has been 3 seconds and we still don't have them in cache, request again
+            } else if (remotePlayer->getDefaultTicks() >= 20) {
+                // the request in `handlePlayerJoin` is reliable, but the server has nothing to send back if it doesn't know the player yet,
+                // so if it has been 5 seconds and we still don't have them in cache, request again
                 remotePlayer->setDefaultTicks(0);
                 NetworkManager::get().send(RequestPlayerProfilesPacket::create(playerId));
             } else {
-                // if it has been less than 3 seconds, just increment the tick counter
                 remotePlayer->incDefaultTicks();
             }
         } else if (data.has_value()) {
@@ -503,10 +508,18 @@ PlayerData GlobedPlayLayer::gatherPlayerData() {
     if (isDead && !m_fields->isCurrentlyDead) {
         m_fields->isCurrentlyDead = true;
         m_fields->lastDeathTimestamp = m_fields->timeCounter;
+        m_fields->deathTimestampSendsLeft = DEATH_TIMESTAMP_REPEAT;
     } else if (!isDead) {
         m_fields->isCurrentlyDead = false;
     }
 
+    // the death timestamp is only included for a few packets after a death, that's enough to survive some packet loss
+    std::optional<float> lastDeathTimestamp;
+    if (m_fields->deathTimestampSendsLeft > 0) {
+        m_fields->deathTimestampSendsLeft--;
+        lastDeathTimestamp = m_fields->lastDeathTimestamp;
+    }
+
     uint32_t localBest;
     if (m_level->isPlatformer()) {
         localBest = static_cast<uint32_t>(m_level->m_bestTime);
@@ -519,10 +532,12 @@ PlayerData GlobedPlayLayer::gatherPlayerData() {
         .localBest = localBest,
         .attempts = m_level->m_attempts,
 
+        // the second player is only visible in dual mode
+        .isDualMode = m_player2->isVisible(),
         .player1 = this->gatherSpecificIconData(m_player1),
-        .player2 = this->gatherSpecificIconData(m_player2), // TODO detect isDualMode
+        .player2 = this->gatherSpecificIconData(m_player2),
 
-        .lastDeathTimestamp = m_fields->lastDeathTimestamp,
+        .lastDeathTimestamp = lastDeathTimestamp,
 
         .currentPercentage = this->getCurrentPercent() / 100.f,
 
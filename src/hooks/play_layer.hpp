@@ -5,6 +5,7 @@
 
 #include <game/interpolator.hpp>
 #include <game/player_store.hpp>
+#include <game/snapshot_history.hpp>
 #include <net/network_manager.hpp>
 #include <ui/game/player/remote_player.hpp>
 #include <ui/game/overlay/overlay.hpp>
@@ -25,10 +26,13 @@ class $modify(GlobedPlayLayer, PlayLayer) {
     float lastServerUpdate = 0.f;
     std::shared_ptr<PlayerInterpolator> interpolator;
     std::shared_ptr<PlayerStore> playerStore;
+    LevelSnapshotHistory snapshotHistory;
+    std::vector<AssociatedPlayerData> receivedPlayers; // reused between LevelDataPackets
 
     bool isCurrentlyDead = false;
     std::optional<SpiderTeleportData> spiderTp1, spiderTp2;
     float lastDeathTimestamp = 0.f;
+    uint32_t deathTimestampSendsLeft = 0;
 
     // ui elements
     GlobedOverlay* overlay = nullptr;
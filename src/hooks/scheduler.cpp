@@ -0,0 +1,8 @@
+#include "scheduler.hpp"
+#include <net/network_manager.hpp>
+
+void GlobedScheduler::update(float dt) {
+    // handle the packets before anything else runs this frame, so they are seen by every scheduled update
+    NetworkManager::get().dispatchInbox();
+    CCScheduler::update(dt);
+}
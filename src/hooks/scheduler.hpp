@@ -0,0 +1,7 @@
+#pragma once
+#include <defs.hpp>
+#include <Geode/modify/CCScheduler.hpp>
+
+class $modify(GlobedScheduler, cocos2d::CCScheduler) {
+    void update(float dt);
+};
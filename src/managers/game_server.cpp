@@ -185,7 +185,10 @@ uint32_t GameServerManager::startPing(const std::string_view serverId) {
     auto pingId = util::rng::Random::get().generate<uint32_t>();
 
     auto data = _data.lock();
-    auto& gsdata = data->servers.at(std::string(serverId));
+    auto it = data->servers.find(serverId);
+    GLOBED_REQUIRE(it != data->servers.end(), fmt::format("pinging an unknown game server: {}", serverId))
+
+    auto& gsdata = it->second;
 
     if (gsdata.pendingPings.size() > 50) {
         log::warn("over 50 pending pings for the game server {}, clearing", serverId);
@@ -216,6 +219,44 @@ void GameServerManager::finishPing(uint32_t pingId, uint32_t playerCount) {
     }
 }
 
+void GameServerManager::expirePings(util::time::millis timeout) {
+    auto now = util::time::now();
+
+    auto data = _data.lock();
+
+    for (auto& [_, server] : data->servers) {
+        size_t expired = std::erase_if(server.pendingPings, [&](const auto& ping) {
+            return now - ping.second > timeout;
+        });
+
+        if (expired > 0) {
+            server.server.ping = -1;
+        }
+    }
+}
+
+std::optional<sockaddr_storage> GameServerManager::getResolvedAddress(const std::string_view serverId) {
+    auto data = _data.lock();
+
+    auto it = data->servers.find(serverId);
+    if (it == data->servers.end() || util::time::now() >= it->second.resolvedUntil) {
+        return std::nullopt;
+    }
+
+    return it->second.resolvedAddress;
+}
+
+void GameServerManager::setResolvedAddress(const std::string_view serverId, const sockaddr_storage& address, util::time::time_point validUntil) {
+    auto data = _data.lock();
+
+    // the server might have been removed while its hostname was being resolved
+    auto it = data->servers.find(serverId);
+    if (it == data->servers.end()) return;
+
+    it->second.resolvedAddress = address;
+    it->second.resolvedUntil = validUntil;
+}
+
 void GameServerManager::startKeepalive() {
     std::string active = _data.lock()->active;
 
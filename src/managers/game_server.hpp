@@ -1,5 +1,6 @@
 #pragma once
 #include <defs.hpp>
+#include <defs/net.hpp>
 
 #include <unordered_map>
 
@@ -71,6 +72,12 @@ public:
 
     uint32_t startPing(const std::string_view serverId);
     void finishPing(uint32_t pingId, uint32_t playerCount);
+    // Forgets pings that have gone unanswered for longer than `timeout`, the ping of their server becomes unknown again
+    void expirePings(util::time::millis timeout);
+
+    // The address the server was last resolved to for pinging, nullopt if it hasn't been yet or it has expired
+    std::optional<sockaddr_storage> getResolvedAddress(const std::string_view serverId);
+    void setResolvedAddress(const std::string_view serverId, const sockaddr_storage& address, util::time::time_point validUntil);
 
     void startKeepalive();
     void finishKeepalive(uint32_t playerCount);
@@ -80,10 +87,22 @@ protected:
     struct GameServerData {
         GameServer server;
         std::unordered_map<uint32_t, util::time::time_point> pendingPings;
+        // kept so that the address isn't parsed or looked up again on every ping sweep
+        std::optional<sockaddr_storage> resolvedAddress;
+        util::time::time_point resolvedUntil;
+    };
+
+    // lets `servers` be searched with a string_view, the ping functions are called for every server on every sweep
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const {
+            return std::hash<std::string_view>{}(str);
+        }
     };
 
     struct InnerData {
-        std::unordered_map<std::string, GameServerData> servers;
+        std::unordered_map<std::string, GameServerData, StringHash, std::equal_to<>> servers;
         std::string active; // current game server ID
         uint32_t activePingId;
         std::string cachedServerResponse;
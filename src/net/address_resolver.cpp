@@ -0,0 +1,135 @@
+#include "address_resolver.hpp"
+
+#include <util/net.hpp>
+
+using namespace geode::prelude;
+using namespace util::time;
+
+AddressResolver::AddressResolver() {
+    thread.setLoopFunction(&AddressResolver::threadFunc);
+    thread.setName("Address Resolver Thread");
+    thread.start(this);
+}
+
+AddressResolver::~AddressResolver() {
+    thread.stop();
+    requests.wake();
+    thread.join();
+}
+
+std::optional<Result<sockaddr_storage>> AddressResolver::lookup(const std::string_view host, unsigned short port, util::time::time_point* validUntil) {
+    if (auto address = util::net::parseAddress(host, port)) {
+        if (validUntil) *validUntil = util::time::time_point::max();
+        return Ok(*address);
+    }
+
+    auto cached = cache.lock();
+
+    auto entry = findFresh(*cached, host);
+    if (!entry) return std::nullopt;
+
+    if (validUntil) *validUntil = entry->expiresAt;
+
+    if (entry->addresses.empty()) {
+        return Err(entry->error);
+    }
+
+    // only the first one, without copying the list
+    auto address = entry->addresses.front();
+    util::net::setPort(address, port);
+
+    return Ok(address);
+}
+
+std::optional<Result<AddressResolver::AddressList>> AddressResolver::lookupAll(const std::string_view host, unsigned short port) {
+    if (auto address = util::net::parseAddress(host, port)) {
+        return Ok(AddressList{*address});
+    }
+
+    auto cached = cache.lock();
+
+    auto entry = findFresh(*cached, host);
+    if (!entry) return std::nullopt;
+
+    if (entry->addresses.empty()) {
+        return Err(entry->error);
+    }
+
+    auto addresses = entry->addresses;
+    for (auto& address : addresses) {
+        util::net::setPort(address, port);
+    }
+
+    return Ok(std::move(addresses));
+}
+
+void AddressResolver::resolve(const std::string_view host, unsigned short port, Callback callback) {
+    if (auto result = this->lookupAll(host, port)) {
+        callback(std::move(*result));
+        return;
+    }
+
+    requests.push(Request {
+        .host = std::string(host),
+        .port = port,
+        .callback = std::move(callback),
+    });
+}
+
+void AddressResolver::clearCache() {
+    cache.lock()->clear();
+}
+
+void AddressResolver::threadFunc() {
+    requests.waitForMessages();
+
+    for (auto& request : requests.popAll()) {
+        // the same host could have been resolved for an earlier request in the meantime
+        auto cached = this->lookupAll(request.host, request.port);
+        auto result = cached ? std::move(*cached) : this->resolveUncached(request.host, request.port);
+
+        try {
+            request.callback(std::move(result));
+        } catch (const std::exception& e) {
+            log::warn("address resolver callback for {} threw: {}", request.host, e.what());
+        }
+    }
+}
+
+Result<AddressResolver::AddressList> AddressResolver::resolveUncached(const std::string_view host, unsigned short port) {
+    auto result = util::net::getaddrinfo(host);
+
+    if (result.isErr()) {
+        auto error = result.unwrapErr();
+        log::warn("failed to resolve {}: {}", host, error);
+
+        cache.lock()->insert_or_assign(std::string(host), CacheEntry {
+            .error = error,
+            .expiresAt = now() + FAILURE_TTL,
+        });
+
+        return Err(error);
+    }
+
+    auto addresses = result.unwrap();
+
+    cache.lock()->insert_or_assign(std::string(host), CacheEntry {
+        .addresses = addresses,
+        .expiresAt = now() + CACHE_TTL,
+    });
+
+    for (auto& address : addresses) {
+        util::net::setPort(address, port);
+    }
+
+    return Ok(std::move(addresses));
+}
+
+const AddressResolver::CacheEntry* AddressResolver::findFresh(const Cache& cache, const std::string_view host) {
+    auto it = cache.find(host);
+    if (it == cache.end() || now() >= it->second.expiresAt) {
+        return nullptr;
+    }
+
+    return &it->second;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <defs.hpp>
+#include <defs/net.hpp>
+#include <util/sync.hpp>
+#include <util/time.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+* AddressResolver turns hostnames into socket addresses on its own thread, so that nothing else ever blocks on a DNS lookup.
+* Results are cached by host for `CACHE_TTL`, failures for `FAILURE_TTL`, so that a server with a broken hostname isn't looked up again on every ping.
+* IP addresses are never looked up, and are never cached either since parsing them is cheaper than the lookup.
+*
+* A hostname can resolve to several addresses, IPv6 and IPv4 ones mixed, in the order the system prefers them (RFC 6724).
+* `lookup` gives the first one, `lookupAll` and `resolve` give all of them so that the caller can try more than one.
+*/
+class AddressResolver : public SingletonBase<AddressResolver> {
+protected:
+    friend class SingletonBase;
+    AddressResolver();
+    ~AddressResolver();
+
+public:
+    // getaddrinfo doesn't tell the TTL of the records, so every result is kept for the same time
+    static constexpr util::time::seconds CACHE_TTL = util::time::seconds(300);
+    static constexpr util::time::seconds FAILURE_TTL = util::time::seconds(10);
+
+    // never empty if resolving succeeded
+    using AddressList = std::vector<sockaddr_storage>;
+
+    // Called on the resolver thread, or right away on the calling thread if the result is already known
+    using Callback = std::function<void(Result<AddressList>)>;
+
+    // The preferred address of an IP or of a hostname that is in the cache, without blocking. nullopt means `resolve` has to be used.
+    // If `validUntil` is given, it's set to when the result stops being valid, which is never for an IP.
+    std::optional<Result<sockaddr_storage>> lookup(const std::string_view host, unsigned short port, util::time::time_point* validUntil = nullptr);
+    // Like `lookup`, but returns every address of the host
+    std::optional<Result<AddressList>> lookupAll(const std::string_view host, unsigned short port);
+
+    // Resolves the host in the background, unless `lookup` already knows the result
+    void resolve(const std::string_view host, unsigned short port, Callback callback);
+
+    void clearCache();
+
+private:
+    struct CacheEntry {
+        // the port is always 0, it's set to the requested one on every lookup. Empty if resolving failed.
+        AddressList addresses;
+        std::string error;
+        util::time::time_point expiresAt;
+    };
+
+    struct Request {
+        std::string host;
+        unsigned short port;
+        Callback callback;
+    };
+
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    using Cache = std::unordered_map<std::string, CacheEntry, StringHash, std::equal_to<>>;
+
+    util::sync::WrappingMutex<Cache> cache;
+    util::sync::SmartMessageQueue<Request> requests;
+    util::sync::SmartThread<AddressResolver*> thread;
+
+    void threadFunc();
+    // nullptr if the host isn't cached or has expired
+    static const CacheEntry* findFresh(const Cache& cache, const std::string_view host);
+    // looks the host up and caches the result, blocking
+    Result<AddressList> resolveUncached(const std::string_view host, unsigned short port);
+};
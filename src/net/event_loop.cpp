@@ -0,0 +1,244 @@
+#include "event_loop.hpp"
+
+#include <util/net.hpp>
+
+#ifdef GLOBED_HAS_EPOLL
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+#elif defined(GLOBED_IS_UNIX)
+# include <fcntl.h>
+#endif
+
+#include <climits>
+
+using namespace util::time;
+
+namespace {
+    // what the epoll events carry to tell the two descriptors apart
+    constexpr uint32_t WAKE_TAG = 0;
+    constexpr uint32_t SOCKET_TAG = 1;
+
+    // a signal ended the wait early, which isn't an error
+    bool interrupted() {
+#ifdef GLOBED_IS_UNIX
+        return errno == EINTR;
+#else
+        return false;
+#endif
+    }
+
+    int timeoutMillis(std::optional<time_point> deadline) {
+        if (!deadline) return -1;
+
+        auto remaining = *deadline - now();
+        if (remaining <= remaining.zero()) return 0;
+
+        // rounded up, waking up a little late is fine but waking up early would mean another wait right after
+        auto ms = chrono::ceil<millis>(remaining).count();
+        return static_cast<int>(std::min<int64_t>(ms, INT_MAX));
+    }
+}
+
+EventLoop::EventLoop() {
+#ifdef GLOBED_HAS_EPOLL
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) util::net::throwLastError();
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd == -1) util::net::throwLastError();
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = WAKE_TAG;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) == -1) util::net::throwLastError();
+#elif defined(GEODE_IS_WINDOWS)
+    wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    GLOBED_REQUIRE(wakeSocket != INVALID_SOCKET, "failed to create the wakeup socket")
+
+    memset(&wakeAddress, 0, sizeof(wakeAddress));
+    wakeAddress.sin_family = AF_INET;
+    wakeAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    wakeAddress.sin_port = 0;
+
+    int addrLen = sizeof(wakeAddress);
+    if (bind(wakeSocket, reinterpret_cast<sockaddr*>(&wakeAddress), sizeof(wakeAddress)) != 0
+        || getsockname(wakeSocket, reinterpret_cast<sockaddr*>(&wakeAddress), &addrLen) != 0) {
+        util::net::throwLastError();
+    }
+
+    u_long nonBlocking = 1;
+    ioctlsocket(wakeSocket, FIONBIO, &nonBlocking);
+#else
+    if (::pipe(wakePipe) == -1) util::net::throwLastError();
+
+    for (int fd : wakePipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+#ifdef GLOBED_HAS_EPOLL
+    ::close(wakeFd);
+    ::close(epollFd);
+#elif defined(GEODE_IS_WINDOWS)
+    ::closesocket(wakeSocket);
+#else
+    ::close(wakePipe[0]);
+    ::close(wakePipe[1]);
+#endif
+}
+
+void EventLoop::watch(socket_t socket) {
+    watched = socket;
+
+#ifdef GLOBED_HAS_EPOLL
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = SOCKET_TAG;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) == -1) util::net::throwLastError();
+    socketEnabled = true;
+#endif
+}
+
+Result<EventLoop::Events> EventLoop::wait(std::optional<time_point> until, bool idle) {
+    auto deadline = idle ? std::nullopt : until;
+
+    if (!idle) {
+        std::lock_guard lock(timerMtx);
+
+        for (const auto& timer : timers) {
+            if (timer && (!deadline || *timer < *deadline)) {
+                deadline = timer;
+            }
+        }
+    }
+
+    int timeout = timeoutMillis(deadline);
+
+    Events events;
+    bool woken = false;
+
+#ifdef GLOBED_HAS_EPOLL
+    // level triggered, so a socket with unread data would end every wait while idle, take it out of the set instead
+    if (socketEnabled == idle) {
+        epoll_event event = {};
+        event.events = idle ? 0 : EPOLLIN;
+        event.data.u32 = SOCKET_TAG;
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_MOD, watched, &event) == -1) {
+            return Err(util::net::lastErrorString());
+        }
+
+        socketEnabled = !idle;
+    }
+
+    std::array<epoll_event, 2> ready;
+    int count = epoll_wait(epollFd, ready.data(), ready.size(), timeout);
+
+    if (count == -1 && !interrupted()) {
+        return Err(util::net::lastErrorString());
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (ready[i].data.u32 == WAKE_TAG) woken = true;
+        else events.readable = true;
+    }
+#else
+    GLOBED_SOCKET_POLLFD fds[2];
+# ifdef GEODE_IS_WINDOWS
+    fds[0].fd = wakeSocket;
+# else
+    fds[0].fd = wakePipe[0];
+# endif
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = watched;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    int count = GLOBED_SOCKET_POLL(fds, idle ? 1 : 2, timeout);
+
+    if (count == -1 && !interrupted()) {
+        return Err(util::net::lastErrorString());
+    }
+
+    woken = (fds[0].revents & POLLIN) != 0;
+    events.readable = !idle && (fds[1].revents & (POLLIN | POLLERR)) != 0;
+#endif
+
+    if (woken) {
+        // cleared before draining, a `wake` that comes in between signals again and ends the next wait instead of getting lost
+        wakePending = false;
+        this->drainWakeup();
+    }
+
+    if (!idle) {
+        std::lock_guard lock(timerMtx);
+        auto currentTime = now();
+
+        for (size_t i = 0; i < timers.size(); i++) {
+            if (timers[i] && *timers[i] <= currentTime) {
+                timers[i].reset();
+                events.expiredTimers |= 1u << i;
+            }
+        }
+    }
+
+    return Ok(events);
+}
+
+void EventLoop::wake() {
+    if (wakePending.exchange(true)) return;
+
+#ifdef GLOBED_HAS_EPOLL
+    uint64_t one = 1;
+    (void) ::write(wakeFd, &one, sizeof(one));
+#elif defined(GEODE_IS_WINDOWS)
+    char byte = 0;
+    sendto(wakeSocket, &byte, 1, 0, reinterpret_cast<const sockaddr*>(&wakeAddress), sizeof(wakeAddress));
+#else
+    char byte = 0;
+    (void) ::write(wakePipe[1], &byte, 1);
+#endif
+}
+
+void EventLoop::schedule(size_t timer, time_point when) {
+    GLOBED_REQUIRE(timer < MAX_TIMERS, "invalid timer index")
+
+    bool sooner;
+
+    {
+        std::lock_guard lock(timerMtx);
+        sooner = !timers[timer] || when < *timers[timer];
+        timers[timer] = when;
+    }
+
+    // the loop could be sleeping past the new deadline
+    if (sooner) {
+        this->wake();
+    }
+}
+
+void EventLoop::cancel(size_t timer) {
+    GLOBED_REQUIRE(timer < MAX_TIMERS, "invalid timer index")
+
+    std::lock_guard lock(timerMtx);
+    timers[timer].reset();
+}
+
+void EventLoop::drainWakeup() {
+#ifdef GLOBED_HAS_EPOLL
+    uint64_t value;
+    (void) ::read(wakeFd, &value, sizeof(value));
+#elif defined(GEODE_IS_WINDOWS)
+    char buf[64];
+    while (recv(wakeSocket, buf, sizeof(buf), 0) > 0) {}
+#else
+    char buf[64];
+    while (::read(wakePipe[0], buf, sizeof(buf)) > 0) {}
+#endif
+}
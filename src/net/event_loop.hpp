@@ -0,0 +1,81 @@
+#pragma once
+#include <defs.hpp>
+#include <defs/net.hpp>
+#include <util/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+/*
+* EventLoop is what the network thread sleeps in. A wait ends as soon as the socket has something to read, a timer expires,
+* or another thread calls `wake` (for example because it queued a packet), so nothing ever has to wait out a polling interval.
+*
+* It's built on epoll and an eventfd on Linux and Android, poll and a pipe on other unix systems, and WSAPoll and a loopback socket on Windows.
+*
+* Timers are identified by a small index (an enum on the caller's side) and can be scheduled from any thread.
+* There is only ever a handful of them, so they are a fixed table, with no allocations and nothing to clean up.
+*/
+class EventLoop {
+public:
+#ifdef GEODE_IS_WINDOWS
+    using socket_t = SOCKET;
+#else
+    using socket_t = int;
+#endif
+
+    static constexpr size_t MAX_TIMERS = 8;
+
+    struct Events {
+        bool readable = false;
+        // Bit N is set if timer N expired. An expired timer stays unscheduled until `schedule` is called for it again.
+        uint32_t expiredTimers = 0;
+    };
+
+    // Throws if the wakeup mechanism can't be created
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Sets the socket to wait for. Must be called before the first `wait`.
+    void watch(socket_t socket);
+
+    // Waits until the socket is readable, a timer expires, `wake` is called, or `until` passes.
+    // When idle, only `wake` ends the wait, the socket and the timers are left alone until the next wait that isn't.
+    Result<Events> wait(std::optional<util::time::time_point> until, bool idle = false);
+
+    // Makes the current or the next `wait` return. Can be called from any thread, and calling it many times before the wait returns costs one system call.
+    void wake();
+
+    // Can be called from any thread, replaces the previous deadline of the timer
+    void schedule(size_t timer, util::time::time_point when);
+    void cancel(size_t timer);
+
+private:
+    socket_t watched{};
+
+#ifdef GLOBED_HAS_EPOLL
+    int epollFd = -1;
+    int wakeFd = -1;
+    // whether the socket is in the epoll set with EPOLLIN, it's taken out while idle
+    bool socketEnabled = false;
+#elif defined(GEODE_IS_WINDOWS)
+    // bound to a loopback address, `wake` sends a datagram to it
+    socket_t wakeSocket;
+    sockaddr_in wakeAddress;
+#else
+    int wakePipe[2] = {-1, -1};
+#endif
+
+    // set by `wake` and cleared by `wait`, so that only the first `wake` in between has to signal
+    std::atomic_bool wakePending = false;
+
+    std::mutex timerMtx;
+    std::array<std::optional<util::time::time_point>, MAX_TIMERS> timers;
+
+    // consumes the signal that `wake` sent
+    void drainWakeup();
+};
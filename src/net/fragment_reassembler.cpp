@@ -0,0 +1,159 @@
+#include "fragment_reassembler.hpp"
+
+#include <cstring>
+
+using namespace util::time;
+using util::data::byte;
+
+namespace {
+    // fragments are sent back to back, so if none arrived for this long, the missing ones were lost
+    constexpr micros REQUEST_DELAY = millis(50);
+    // the server forgets fragmented datagrams after about this long, and stops resending them after 3 requests
+    constexpr micros TIMEOUT = millis(2000);
+    constexpr uint32_t MAX_REQUESTS = 3;
+
+    constexpr size_t MAX_COMPLETED = 16;
+
+    uint64_t allFragments(uint16_t count) {
+        return count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+    }
+}
+
+std::optional<std::vector<byte>> FragmentReassembler::add(const byte* data, size_t length) {
+    ByteReader buf(data, length);
+    uint32_t messageId = buf.readU32();
+    uint16_t index = buf.readU16();
+    uint16_t count = buf.readU16();
+
+    const byte* fragment = data + FragmentPacket::HEADER_SIZE;
+    size_t fragmentLength = length - FragmentPacket::HEADER_SIZE;
+
+    GLOBED_REQUIRE(count > 1 && count <= FragmentPacket::MAX_FRAGMENTS && index < count, "invalid fragment header")
+    GLOBED_REQUIRE(
+        index == count - 1 ? fragmentLength <= FragmentPacket::MAX_DATA_SIZE : fragmentLength == FragmentPacket::MAX_DATA_SIZE,
+        "invalid fragment size"
+    )
+
+    std::lock_guard lock(mtx);
+
+    auto currentTime = now();
+    this->dropExpired(currentTime);
+
+    if (this->isCompleted(messageId)) {
+        return std::nullopt;
+    }
+
+    auto it = pending.find(messageId);
+
+    if (it == pending.end()) {
+        size_t capacity = count * FragmentPacket::MAX_DATA_SIZE;
+
+        while (!pending.empty() && (pending.size() >= MAX_PENDING || pendingBytes + capacity > MAX_PENDING_BYTES)) {
+            auto oldest = std::min_element(pending.begin(), pending.end(), [](const auto& a, const auto& b) {
+                return a.second.firstFragment < b.second.firstFragment;
+            });
+
+            this->drop(oldest);
+        }
+
+        it = pending.emplace(messageId, Message {
+            .count = count,
+            .data = std::vector<byte>(capacity),
+            .firstFragment = currentTime,
+        }).first;
+
+        pendingBytes += capacity;
+    }
+
+    auto& message = it->second;
+    GLOBED_REQUIRE(message.count == count, "fragment count does not match the previous fragments")
+
+    message.lastActivity = currentTime;
+
+    uint64_t bit = uint64_t(1) << index;
+    if (message.received & bit) {
+        return std::nullopt;
+    }
+
+    message.received |= bit;
+    std::memcpy(message.data.data() + index * FragmentPacket::MAX_DATA_SIZE, fragment, fragmentLength);
+
+    if (index == count - 1) {
+        message.length = index * FragmentPacket::MAX_DATA_SIZE + fragmentLength;
+    }
+
+    if (message.received != allFragments(count)) {
+        return std::nullopt;
+    }
+
+    auto datagram = std::move(message.data);
+    datagram.resize(message.length);
+    this->drop(it);
+
+    completed.push_back(messageId);
+    if (completed.size() > MAX_COMPLETED) {
+        completed.pop_front();
+    }
+
+    return datagram;
+}
+
+void FragmentReassembler::pollRequests(std::vector<PacketPtr<Packet>>& out) {
+    std::lock_guard lock(mtx);
+
+    auto currentTime = now();
+    this->dropExpired(currentTime);
+
+    for (auto& [messageId, message] : pending) {
+        if (message.requests >= MAX_REQUESTS || currentTime - message.lastActivity < REQUEST_DELAY) continue;
+
+        message.requests++;
+        message.lastActivity = currentTime;
+        out.push_back(FragmentRequestPacket::create(messageId, allFragments(message.count) & ~message.received));
+    }
+}
+
+std::optional<micros> FragmentReassembler::untilRequest() {
+    std::lock_guard lock(mtx);
+
+    auto currentTime = now();
+    std::optional<micros> soonest;
+
+    for (const auto& [_, message] : pending) {
+        if (message.requests >= MAX_REQUESTS) continue;
+
+        auto until = std::max(as<micros>(message.lastActivity + REQUEST_DELAY - currentTime), micros(0));
+        soonest = soonest ? std::min(*soonest, until) : until;
+    }
+
+    return soonest;
+}
+
+void FragmentReassembler::reset() {
+    std::lock_guard lock(mtx);
+
+    pending.clear();
+    pendingBytes = 0;
+    completed.clear();
+}
+
+void FragmentReassembler::drop(std::map<uint32_t, Message>::iterator it) {
+    pendingBytes -= it->second.count * FragmentPacket::MAX_DATA_SIZE;
+    pending.erase(it);
+}
+
+void FragmentReassembler::dropExpired(time_point now) {
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (now - it->second.firstFragment > TIMEOUT) {
+            auto next = std::next(it);
+            this->drop(it);
+            it = next;
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool FragmentReassembler::isCompleted(uint32_t messageId) {
+    return std::find(completed.begin(), completed.end(), messageId) != completed.end();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <data/packets/client/connection.hpp>
+#include <util/time.hpp>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/*
+* FragmentReassembler puts datagrams that the server had to split into `FragmentPacket`s back together.
+* It's used by `GameSocket`, which then handles the reassembled datagram like any other.
+*
+* When an incomplete datagram gets no new fragments for a bit, the missing ones are requested again with a `FragmentRequestPacket`.
+* Datagrams that still aren't complete after a timeout are dropped, and so is the oldest one if too many are incomplete at once.
+*
+* Fragments are added from the receiving thread, while requests are made on the sending thread.
+*/
+class FragmentReassembler {
+public:
+    // incomplete datagrams over these limits drop the oldest one
+    static constexpr size_t MAX_PENDING = 8;
+    static constexpr size_t MAX_PENDING_BYTES = 256 * 1024;
+
+    // Add a fragment (everything after the packet header). Returns the whole datagram once all its fragments have arrived.
+    std::optional<std::vector<util::data::byte>> add(const util::data::byte* data, size_t length);
+
+    // Appends a `FragmentRequestPacket` for every incomplete datagram that stopped receiving fragments to `out`
+    void pollRequests(std::vector<PacketPtr<Packet>>& out);
+
+    // Time until the next request has to be made, nullopt if no datagram is incomplete
+    std::optional<util::time::micros> untilRequest();
+
+    // Forget all state, for a new connection
+    void reset();
+
+private:
+    struct Message {
+        uint16_t count;
+        uint64_t received = 0;
+        // the size is only known once the last fragment arrives
+        size_t length = 0;
+        std::vector<util::data::byte> data;
+        util::time::time_point firstFragment;
+        util::time::time_point lastActivity;
+        uint32_t requests = 0;
+    };
+
+    std::mutex mtx;
+    std::map<uint32_t, Message> pending;
+    size_t pendingBytes = 0;
+
+    // recently completed message IDs, so fragments that were resent after the datagram was complete are ignored
+    std::deque<uint32_t> completed;
+
+    void drop(std::map<uint32_t, Message>::iterator it);
+    void dropExpired(util::time::time_point now);
+    bool isCompleted(uint32_t messageId);
+};
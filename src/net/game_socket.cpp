@@ -1,91 +1,351 @@
 #include "game_socket.hpp"
+#include "packet_capture.hpp"
 
 #include <data/bytebuffer.hpp>
 #include <data/packets/all.hpp>
+#include <util/compression.hpp>
 #include <util/debug.hpp>
 
-const size_t BUF_SIZE = 65536;
-
 using namespace util::data;
 using namespace util::debug;
 
-GameSocket::GameSocket() {
-    buffer = new byte[BUF_SIZE];
+GameSocket::GameSocket() : recvBuffer(RECV_BATCH_SIZE * MAX_DATAGRAM_SIZE) {
+    for (size_t i = 0; i < RECV_BATCH_SIZE; i++) {
+        recvSlots[i] = IncomingDatagram {
+            .data = recvBuffer.data() + i * MAX_DATAGRAM_SIZE,
+            .capacity = MAX_DATAGRAM_SIZE,
+        };
+    }
 }
 
-GameSocket::~GameSocket() {
-    delete[] buffer;
-}
+void GameSocket::recvPackets(std::vector<IncomingPacket>& out) {
+    out.clear();
+
+    std::optional<std::string> firstError;
+    size_t received;
+
+    // if every slot got filled, there could be more datagrams waiting
+    do {
+        received = this->receiveBatch(recvSlots);
+
+        for (size_t i = 0; i < received; i++) {
+            auto& slot = recvSlots[i];
+
+            try {
+                GLOBED_REQUIRE(slot.length < slot.capacity, "received a datagram that is too big")
 
-GameSocket::IncomingPacket GameSocket::recvPacket() {
-    auto recvres = this->receive(reinterpret_cast<char*>(buffer), BUF_SIZE);
-    int received = recvres.result;
+                // read directly from the receive buffer, no copying is done
+                this->decodeDatagram(slot.data, slot.length, slot.fromServer, false, out);
+            } catch (const std::exception& e) {
+                if (!firstError) firstError = e.what();
+            }
+        }
+    } while (received == recvSlots.size());
 
-    GLOBED_REQUIRE(received > 0, "failed to receive data from a socket")
+    if (firstError) {
+        throw std::runtime_error(*firstError);
+    }
+}
 
-    GLOBED_REQUIRE(received >= PacketHeader::SIZE, "packet is missing a header")
+void GameSocket::decodeDatagram(byte* data, size_t length, bool fromServer, bool reassembled, std::vector<IncomingPacket>& out) {
+    GLOBED_REQUIRE(length >= PacketHeader::SIZE, "packet is missing a header")
 
-    ByteBuffer buf(reinterpret_cast<byte*>(buffer), received);
+    ByteReader headerReader(data, length);
 
     // read header
-    auto header = buf.readValue<PacketHeader>();
+    auto header = headerReader.readValue<PacketHeader>();
 
     // packet size without the header
-    size_t messageLength = received - PacketHeader::SIZE;
+    size_t messageLength = length - PacketHeader::SIZE;
 
 #ifdef GLOBED_DEBUG_PACKETS
-    PacketLogger::get().record(header.id, header.encrypted, false, received);
+    PacketLogger::get().record(header.id, header.encrypted, false, length);
 #endif
 
-    auto packet = matchPacket(header.id);
+    if (header.id == FragmentPacket::SERVER_PACKET_ID) {
+        GLOBED_REQUIRE(!reassembled, "reassembled datagram is a fragment itself")
 
-    GLOBED_REQUIRE(packet.get() != nullptr, std::string("invalid server-side packet: ") + std::to_string(header.id))
+        // anyone could send a fragment, and it would get mixed into a datagram of the server
+        if (!fromServer) return;
 
-    if (packet->getEncrypted() && !header.encrypted) {
-        GLOBED_REQUIRE(false, "server sent a cleartext packet when expected an encrypted one")
+        if (auto datagram = fragments.add(data + PacketHeader::SIZE, messageLength)) {
+            this->decodeDatagram(datagram->data(), datagram->size(), fromServer, true, out);
+        }
+
+        return;
     }
 
     if (header.encrypted) {
         GLOBED_REQUIRE(box.get() != nullptr, "attempted to decrypt a packet when no cryptobox is initialized")
-        bytevector& bufvec = buf.getDataRef();
 
-        messageLength = box->decryptInPlace(bufvec.data() + PacketHeader::SIZE, messageLength);
-        buf.resize(messageLength + PacketHeader::SIZE);
+        messageLength = box->decryptInPlace(data + PacketHeader::SIZE, messageLength);
+    }
+
+    const byte* message = data + PacketHeader::SIZE;
+
+    if (header.id != BundlePacket::SERVER_PACKET_ID) {
+        this->decodePacket(header.id, message, messageLength, header.encrypted, fromServer, out);
+        return;
     }
 
+    ByteReader bundleReader(message, messageLength);
+
+    while (bundleReader.remaining() > 0) {
+        packetid_t id = bundleReader.readU16();
+        size_t length = bundleReader.readU16();
+        GLOBED_REQUIRE(length <= bundleReader.remaining(), "bundled packet is longer than the bundle")
+
+        size_t start = bundleReader.getPosition();
+        this->decodePacket(id, message + start, length, header.encrypted, fromServer, out);
+        bundleReader.setPosition(start + length);
+    }
+}
+
+void GameSocket::decodePacket(packetid_t id, const byte* data, size_t length, bool encrypted, bool fromServer, std::vector<IncomingPacket>& out) {
+    // only the server can change the state of the reliable channel, a stray datagram could otherwise
+    // ack away packets the server never got, or use up sequence numbers so that the real packets are dropped as duplicates
+    if (!fromServer && (id == ReliablePacket::SERVER_PACKET_ID || id == ReliableAckPacket::SERVER_PACKET_ID)) {
+        return;
+    }
+
+    if (id == ReliablePacket::SERVER_PACKET_ID) {
+        this->decodeReliablePacket(data, length, encrypted, fromServer, out);
+        return;
+    }
+
+    if (id == ReliableAckPacket::SERVER_PACKET_ID) {
+        ByteReader buf(data, length);
+        uint32_t ack = buf.readU32();
+        uint32_t ackBits = buf.readU32();
+
+        reliable.acknowledge(ack, ackBits);
+        return;
+    }
+
+    if (id == CompressedPacket::SERVER_PACKET_ID) {
+        this->decodeCompressedPacket(data, length, encrypted, fromServer, out);
+        return;
+    }
+
+    PacketCapture::get().record(id, data, length, encrypted, false);
+
+    auto packet = matchPacket(id);
+
+    GLOBED_REQUIRE(packet.get() != nullptr, std::string("invalid server-side packet: ") + std::to_string(id))
+
+    if (packet->getEncrypted() && !encrypted) {
+        GLOBED_REQUIRE(false, "server sent a cleartext packet when expected an encrypted one")
+    }
+
+    ByteReader buf(data, length);
+
     try {
         packet->decode(buf);
     } catch (const std::exception& e) {
-        auto msg = fmt::format("Decoding packet ID {} failed: {}", header.id, e.what());
+        auto msg = fmt::format("Decoding packet ID {} failed: {}", id, e.what());
         throw std::runtime_error(msg);
     }
 
-    return IncomingPacket {
-        .packet = packet,
-        .fromServer = recvres.fromServer
+    out.push_back(IncomingPacket {
+        .packet = std::move(packet),
+        .fromServer = fromServer
+    });
+}
+
+void GameSocket::decodeReliablePacket(const byte* data, size_t length, bool encrypted, bool fromServer, std::vector<IncomingPacket>& out) {
+    ByteReader buf(data, length);
+    uint32_t sequence = buf.readU32();
+    uint32_t ack = buf.readU32();
+    uint32_t ackBits = buf.readU32();
+    packetid_t id = buf.readU16();
+
+    GLOBED_REQUIRE(
+        id != ReliablePacket::SERVER_PACKET_ID && id != ReliableAckPacket::SERVER_PACKET_ID && id != BundlePacket::SERVER_PACKET_ID,
+        "server sent a nested reliable packet"
+    )
+
+    const byte* packetData = data + ReliablePacket::HEADER_SIZE;
+    size_t packetLength = length - ReliablePacket::HEADER_SIZE;
+
+    // a packet that would be rejected anyway must not take up its sequence number
+    this->validateReliableContents(id, packetData, packetLength, encrypted);
+
+    reliable.acknowledge(ack, ackBits);
+
+    reliable.deliver(sequence, id, packetData, packetLength, encrypted, [&](packetid_t id, const byte* data, size_t length, bool encrypted) {
+        this->decodePacket(id, data, length, encrypted, fromServer, out);
+    });
+}
+
+void GameSocket::validateReliableContents(packetid_t id, const byte* data, size_t length, bool encrypted) {
+    if (id == CompressedPacket::SERVER_PACKET_ID) {
+        ByteReader buf(data, length);
+        id = buf.readU16();
+    }
+
+    size_t index = ServerPackets::indexOf(id);
+
+    GLOBED_REQUIRE(index != ServerPackets::NOT_FOUND, std::string("invalid server-side packet: ") + std::to_string(id))
+    GLOBED_REQUIRE(encrypted || !ServerPackets::isEncrypted(index), "server sent a cleartext packet when expected an encrypted one")
+}
+
+void GameSocket::decodeCompressedPacket(const byte* data, size_t length, bool encrypted, bool fromServer, std::vector<IncomingPacket>& out) {
+    ByteReader buf(data, length);
+    packetid_t id = buf.readU16();
+    size_t rawLength = buf.readU32();
+
+    GLOBED_REQUIRE(
+        id != CompressedPacket::SERVER_PACKET_ID && id != ReliablePacket::SERVER_PACKET_ID && id != BundlePacket::SERVER_PACKET_ID,
+        "server sent a nested compressed packet"
+    )
+    GLOBED_REQUIRE(rawLength <= CompressedPacket::MAX_RAW_SIZE, "compressed packet is too big")
+
+    // these are rare and big, so they get their own buffer
+    bytevector raw(rawLength);
+    util::compression::decompress(data + CompressedPacket::HEADER_SIZE, length - CompressedPacket::HEADER_SIZE, raw.data(), rawLength);
+
+    this->decodePacket(id, raw.data(), rawLength, encrypted, fromServer, out);
+}
+
+void GameSocket::sendPacket(PacketPtr<Packet> packet) {
+    this->sendPacket(packet.get());
+}
+
+void GameSocket::sendPackets(std::span<const PacketPtr<Packet>> packets) {
+    // the first packet in the bundle, if nothing else gets added it's sent on its own without the extra header
+    Packet* first = nullptr;
+
+    auto flush = [&] {
+        if (bundle.count == 1) {
+            this->queueDatagram(first);
+        } else if (bundle.count > 1) {
+            this->queueDatagram(&bundle);
+        }
+
+        bundle.clear();
     };
+
+    outgoing.clear();
+    queuedDatagrams = 0;
+
+    for (const auto& packet : packets) {
+        PacketCapture::get().recordOutgoing(*packet);
+        outgoing.push_back(ReliableChannel::isReliable(packet->getPacketId()) ? reliable.wrap(packet) : packet);
+    }
+
+    reliable.pollRetransmits(outgoing);
+    fragments.pollRequests(outgoing);
+
+    // the ack is carried by the reliable packets if there are any, otherwise it has to be sent on its own
+    if (auto ack = reliable.makeAck()) {
+        outgoing.push_back(std::move(ack));
+    }
+
+    bundle.clear();
+
+    for (const auto& packet : outgoing) {
+        size_t entrySize = BundlePacket::ENTRY_HEADER_SIZE + packet->encodedSize();
+
+        // the handshake has to be readable before the server knows our key, so it is never put in an encrypted bundle
+        if (entrySize > BundlePacket::MAX_ENTRIES_SIZE || packet->getPacketId() == CryptoHandshakeStartPacket::PACKET_ID) {
+            flush();
+            this->queueDatagram(packet.get());
+            continue;
+        }
+
+        if (bundle.entries.size() + entrySize > BundlePacket::MAX_ENTRIES_SIZE) {
+            flush();
+        }
+
+        if (bundle.count == 0) {
+            first = packet.get();
+        }
+
+        bundle.push(*packet);
+    }
+
+    flush();
+    outgoing.clear();
+
+    this->flushDatagrams();
+}
+
+void GameSocket::sendPacketsTo(std::span<const PacketPtr<Packet>> packets, std::span<const sockaddr_storage> destinations) {
+    GLOBED_REQUIRE(packets.size() == destinations.size(), "every packet needs a destination")
+
+    queuedDatagrams = 0;
+
+    for (size_t i = 0; i < packets.size(); i++) {
+        PacketCapture::get().recordOutgoing(*packets[i]);
+        this->queueDatagram(packets[i].get(), &destinations[i]);
+    }
+
+    this->flushDatagrams();
+}
+
+void GameSocket::queueDatagram(Packet* packet, const sockaddr_storage* destination) {
+    if (queuedDatagrams == sendQueue.size()) {
+        sendQueue.emplace_back();
+    }
+
+    auto& datagram = sendQueue[queuedDatagrams++];
+    datagram.destination = destination;
+    this->serializePacket(packet, datagram.buffer);
+
+#ifdef GLOBED_DEBUG_PACKETS
+    PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, datagram.buffer.size());
+#endif
+}
+
+void GameSocket::flushDatagrams() {
+    sendBatchList.clear();
+
+    for (size_t i = 0; i < queuedDatagrams; i++) {
+        auto& datagram = sendQueue[i];
+
+        sendBatchList.push_back(OutgoingDatagram {
+            .data = datagram.buffer.getDataRef().data(),
+            .length = datagram.buffer.size(),
+            .destination = datagram.destination,
+        });
+    }
+
+    queuedDatagrams = 0;
+
+    this->sendBatch(sendBatchList);
 }
 
-void GameSocket::sendPacket(std::shared_ptr<Packet> packet) {
-    auto buf = this->serializePacket(packet.get());
+void GameSocket::sendPacket(Packet* packet) {
+    PacketCapture::get().recordOutgoing(*packet);
+
+    auto buf = sendBuffer.lock();
+    this->serializePacket(packet, *buf);
 
 #ifdef GLOBED_DEBUG_PACKETS
-    PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, buf.size());
+    PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, buf->size());
 #endif
 
     GLOBED_REQUIRE(
-        this->send(reinterpret_cast<char*>(buf.getDataRef().data()), buf.size()) == buf.size(),
+        this->send(reinterpret_cast<char*>(buf->getDataRef().data()), buf->size()) == buf->size(),
         "failed to send the entire buffer"
     )
 }
 
-ByteBuffer GameSocket::serializePacket(Packet* packet) {
-    ByteBuffer buf;
+void GameSocket::serializePacket(Packet* packet, ByteBuffer& buf) {
+    buf.clear();
+
     PacketHeader header = {
         .id = packet->getPacketId(),
         .encrypted = packet->getEncrypted()
     };
 
+    size_t expectedSize = PacketHeader::SIZE + packet->encodedSize();
+    if (header.encrypted) {
+        expectedSize += CryptoBox::PREFIX_LEN;
+    }
+
+    buf.reserve(expectedSize);
+
     buf.writeValue(header);
 
     packet->encode(buf);
@@ -98,19 +358,20 @@ ByteBuffer GameSocket::serializePacket(Packet* packet) {
         buf.grow(CryptoBox::PREFIX_LEN);
         box->encryptInPlace(buf.getDataRef().data() + PacketHeader::SIZE, packetSize);
     }
-
-    return buf;
 }
 
-void GameSocket::sendPacketTo(std::shared_ptr<Packet> packet, const std::string_view address, unsigned short port) {
-    auto buf = this->serializePacket(packet.get());
+void GameSocket::sendPacketTo(PacketPtr<Packet> packet, const sockaddr_storage& destination) {
+    PacketCapture::get().recordOutgoing(*packet);
+
+    auto buf = sendBuffer.lock();
+    this->serializePacket(packet.get(), *buf);
 
 #ifdef GLOBED_DEBUG_PACKETS
-    PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, buf.size());
+    PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, buf->size());
 #endif
 
     GLOBED_REQUIRE(
-        this->sendTo(reinterpret_cast<char*>(buf.getDataRef().data()), buf.size(), address, port) == buf.size(),
+        this->sendTo(reinterpret_cast<char*>(buf->getDataRef().data()), buf->size(), destination) == buf->size(),
         "failed to send the entire buffer"
     )
 }
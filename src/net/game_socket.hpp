@@ -1,25 +1,46 @@
 #pragma once
 #include "udp_socket.hpp"
+#include "fragment_reassembler.hpp"
+#include "reliable_channel.hpp"
 
-#include <data/packets/packet.hpp>
+#include <data/packets/client/connection.hpp>
 #include <crypto/box.hpp>
 
+#include <span>
+
 class GameSocket : public UdpSocket {
 public:
     struct IncomingPacket {
-        std::shared_ptr<Packet> packet;
+        PacketPtr<Packet> packet;
         // see socket.hpp RecvResult for more info about this bool
         bool fromServer;
     };
 
+    // The server fragments anything bigger than a `FragmentPacket`, so its datagrams easily fit in this. Bigger ones are dropped.
+    static constexpr size_t MAX_DATAGRAM_SIZE = 4096;
+    // how many datagrams are received at once
+    static constexpr size_t RECV_BATCH_SIZE = 16;
+
     GameSocket();
-    ~GameSocket();
 
-    IncomingPacket recvPacket();
-    void sendPacket(std::shared_ptr<Packet> packet);
-    void sendPacketTo(std::shared_ptr<Packet> packet, const std::string_view address, unsigned short port);
+    // Receives every datagram that has arrived and decodes every packet in them into `out`, which is cleared beforehand.
+    // A bundle from the server results in multiple packets, and a fragment in none until the whole datagram has arrived. Reliable packets are delivered in order,
+    // so a reliable packet can also result in the packets that were waiting for it, or in none at all.
+    // If a datagram fails to decode, the rest are still decoded into `out` and the first error is thrown at the end.
+    void recvPackets(std::vector<IncomingPacket>& out);
+    void sendPacket(PacketPtr<Packet> packet);
+    // Sends all packets in order, bundling as many of them as fit into a single datagram. Reliable packets are wrapped,
+    // and packets on the reliable channel that have to be sent again, a pending ack and requests for missing fragments
+    // are sent along with them. All datagrams are sent with one `sendBatch`.
+    void sendPackets(std::span<const PacketPtr<Packet>> packets);
+    void sendPacketTo(PacketPtr<Packet> packet, const sockaddr_storage& destination);
+    // Sends every packet to its own address (see `AddressResolver`) with one `sendBatch`, for pinging all servers at once.
+    // Must be called from the same thread as `sendPackets`.
+    void sendPacketsTo(std::span<const PacketPtr<Packet>> packets, std::span<const sockaddr_storage> destinations);
 
-    ByteBuffer serializePacket(Packet* packet);
+    // Serializes (and encrypts if needed) the packet into `buf`. The buffer is cleared beforehand,
+    // and space for the whole packet is reserved up front, so it is reallocated at most once.
+    void serializePacket(Packet* packet, ByteBuffer& buf);
 
     void cleanupBox();
     void createBox();
@@ -28,5 +49,37 @@ private:
     friend class NetworkManager;
 
     std::unique_ptr<CryptoBox> box;
-    util::data::byte* buffer;
+
+    // RECV_BATCH_SIZE slots of MAX_DATAGRAM_SIZE bytes each
+    util::data::bytevector recvBuffer;
+    std::array<IncomingDatagram, RECV_BATCH_SIZE> recvSlots;
+
+    ReliableChannel reliable;
+    FragmentReassembler fragments;
+
+    struct QueuedDatagram {
+        ByteBuffer buffer;
+        const sockaddr_storage* destination;
+    };
+
+    // only used by the thread calling `sendPackets`
+    BundlePacket bundle;
+    std::vector<PacketPtr<Packet>> outgoing;
+    // the buffers are kept between calls, only the first `queuedDatagrams` are waiting to be sent
+    std::vector<QueuedDatagram> sendQueue;
+    size_t queuedDatagrams = 0;
+    std::vector<OutgoingDatagram> sendBatchList;
+
+    void sendPacket(Packet* packet);
+    void queueDatagram(Packet* packet, const sockaddr_storage* destination = nullptr);
+    void flushDatagrams();
+    void decodeDatagram(util::data::byte* data, size_t length, bool fromServer, bool reassembled, std::vector<IncomingPacket>& out);
+    void decodePacket(packetid_t id, const util::data::byte* data, size_t length, bool encrypted, bool fromServer, std::vector<IncomingPacket>& out);
+    void decodeReliablePacket(const util::data::byte* data, size_t length, bool encrypted, bool fromServer, std::vector<IncomingPacket>& out);
+    void decodeCompressedPacket(const util::data::byte* data, size_t length, bool encrypted, bool fromServer, std::vector<IncomingPacket>& out);
+    // Throws if the packet inside a `ReliablePacket` would fail the checks in `decodePacket`
+    void validateReliableContents(packetid_t id, const util::data::byte* data, size_t length, bool encrypted);
+
+    // reused for every outgoing packet, so that in the steady state sending does no allocations
+    util::sync::WrappingMutex<ByteBuffer> sendBuffer;
 };
\ No newline at end of file
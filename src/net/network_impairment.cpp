@@ -0,0 +1,360 @@
+#include "network_impairment.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+#include <util/format.hpp>
+
+using namespace geode::prelude;
+using namespace util::time;
+using util::data::byte;
+
+namespace {
+    std::optional<float> parseProbability(std::string_view value) {
+        std::string str(value);
+        char* end = nullptr;
+        float result = std::strtof(str.c_str(), &end);
+
+        if (str.empty() || end != str.c_str() + str.size() || !(result >= 0.f && result <= 1.f)) {
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    std::optional<millis> parseMillis(std::string_view value) {
+        auto result = util::format::parse<uint32_t>(value);
+        if (!result) return std::nullopt;
+
+        return millis(*result);
+    }
+
+    std::string_view distributionName(JitterDistribution dist) {
+        switch (dist) {
+            case JitterDistribution::Uniform: return "uniform";
+            case JitterDistribution::Normal: return "normal";
+            case JitterDistribution::Pareto: return "pareto";
+        }
+
+        return "unknown";
+    }
+
+    // how heavy the tail of the pareto distribution is, lower means more big spikes
+    constexpr double PARETO_SHAPE = 2.5;
+}
+
+Result<ImpairmentConfig> ImpairmentConfig::parse(std::string_view spec) {
+    ImpairmentConfig config;
+
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        auto pair = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+
+        if (pair.empty()) continue;
+
+        size_t eq = pair.find('=');
+        if (eq == std::string_view::npos) {
+            return Err(fmt::format("expected key=value, got '{}'", pair));
+        }
+
+        auto key = pair.substr(0, eq);
+        auto value = pair.substr(eq + 1);
+
+        auto setProbability = [&](float& field) {
+            auto parsed = parseProbability(value);
+            if (parsed) field = *parsed;
+            return parsed.has_value();
+        };
+
+        auto setMillis = [&](millis& field) {
+            auto parsed = parseMillis(value);
+            if (parsed) field = *parsed;
+            return parsed.has_value();
+        };
+
+        bool valid;
+
+        if (key == "latency") {
+            valid = setMillis(config.latency);
+        } else if (key == "jitter") {
+            valid = setMillis(config.jitter);
+        } else if (key == "jitter_dist") {
+            valid = true;
+            if (value == "uniform") config.jitterDistribution = JitterDistribution::Uniform;
+            else if (value == "normal") config.jitterDistribution = JitterDistribution::Normal;
+            else if (value == "pareto") config.jitterDistribution = JitterDistribution::Pareto;
+            else valid = false;
+        } else if (key == "loss") {
+            valid = setProbability(config.loss);
+        } else if (key == "burst_loss") {
+            valid = setProbability(config.burstLoss);
+        } else if (key == "burst_start") {
+            valid = setProbability(config.burstStart);
+        } else if (key == "burst_end") {
+            valid = setProbability(config.burstEnd);
+        } else if (key == "duplicate") {
+            valid = setProbability(config.duplicate);
+        } else if (key == "reorder") {
+            valid = setProbability(config.reorder);
+        } else if (key == "reorder_delay") {
+            valid = setMillis(config.reorderDelay);
+        } else if (key == "bandwidth") {
+            auto parsed = util::format::parse<uint32_t>(value);
+            valid = parsed.has_value();
+            if (parsed) config.bandwidthKbps = *parsed;
+        } else if (key == "queue_delay") {
+            valid = setMillis(config.maxQueueDelay);
+        } else if (key == "seed") {
+            auto parsed = util::format::parse<uint64_t>(value);
+            valid = parsed.has_value();
+            if (parsed) config.seed = *parsed;
+        } else {
+            return Err(fmt::format("unknown key '{}'", key));
+        }
+
+        if (!valid) {
+            return Err(fmt::format("invalid value for '{}': '{}'", key, value));
+        }
+    }
+
+    return Ok(config);
+}
+
+std::string ImpairmentConfig::toString() const {
+    return fmt::format(
+        "latency {}ms, jitter {}ms ({}), loss {} (bursts: {} to start, {} to end, {} loss), duplicate {}, reorder {} by {}ms, bandwidth {}",
+        latency.count(), jitter.count(), distributionName(jitterDistribution),
+        loss, burstStart, burstEnd, burstLoss,
+        duplicate, reorder, reorderDelay.count(),
+        bandwidthKbps == 0 ? std::string("unlimited") : fmt::format("{}kbit/s (max {}ms queue)", bandwidthKbps, maxQueueDelay.count())
+    );
+}
+
+ImpairedLink::ImpairedLink(const ImpairmentConfig& config, uint64_t seed) : config(config), rng(seed) {}
+
+void ImpairedLink::submit(const byte* data, size_t length, time_point now) {
+    stats.submitted++;
+
+    // gilbert-elliott: switch states first, then drop with the chance of the state we are in
+    badState = badState ? !this->chance(config.burstEnd) : this->chance(config.burstStart);
+
+    if (this->chance(badState ? config.burstLoss : config.loss)) {
+        stats.dropped++;
+        return;
+    }
+
+    // the datagram gets through the bottleneck after everything that was sent before it
+    time_point departure = now;
+
+    if (config.bandwidthKbps > 0) {
+        time_point start = std::max(now, linkFree);
+
+        if (start - now > config.maxQueueDelay) {
+            stats.dropped++;
+            return;
+        }
+
+        auto transmitTime = micros(length * 8 * 1000 / config.bandwidthKbps);
+        linkFree = start + transmitTime;
+        departure = linkFree;
+    }
+
+    auto due = departure + this->sampleDelay();
+
+    if (this->chance(config.reorder)) {
+        stats.reordered++;
+        due += config.reorderDelay;
+    }
+
+    this->hold(data, length, due);
+
+    if (this->chance(config.duplicate)) {
+        stats.duplicated++;
+        this->hold(data, length, departure + this->sampleDelay());
+    }
+}
+
+std::optional<time_point> ImpairedLink::nextDue() const {
+    if (held.empty()) return std::nullopt;
+
+    return held.top().due;
+}
+
+bool ImpairedLink::popDue(util::data::bytevector& out, time_point now) {
+    if (held.empty() || held.top().due > now) {
+        return false;
+    }
+
+    // the top can't be moved out of a priority queue without a const_cast, but it's removed right after
+    out = std::move(const_cast<Held&>(held.top()).data);
+    held.pop();
+
+    return true;
+}
+
+void ImpairedLink::clear() {
+    held = {};
+    badState = false;
+    linkFree = {};
+}
+
+const ImpairedLink::Stats& ImpairedLink::getStats() const {
+    return stats;
+}
+
+bool ImpairedLink::chance(float probability) {
+    if (probability <= 0.f) return false;
+
+    return std::uniform_real_distribution<float>(0.f, 1.f)(rng) < probability;
+}
+
+micros ImpairedLink::sampleDelay() {
+    double latency = as<micros>(config.latency).count();
+    double jitter = as<micros>(config.jitter).count();
+    double delay = latency;
+
+    if (jitter > 0.0) {
+        switch (config.jitterDistribution) {
+            case JitterDistribution::Uniform: {
+                delay += std::uniform_real_distribution<double>(-jitter, jitter)(rng);
+            } break;
+            case JitterDistribution::Normal: {
+                delay += std::normal_distribution<double>(0.0, jitter)(rng);
+            } break;
+            case JitterDistribution::Pareto: {
+                // scaled so that the average of what's added is `jitter`
+                double scale = jitter * (PARETO_SHAPE - 1.0);
+                double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+                delay += scale / std::pow(1.0 - u, 1.0 / PARETO_SHAPE) - scale;
+            } break;
+        }
+    }
+
+    return micros(static_cast<int64_t>(std::max(delay, 0.0)));
+}
+
+void ImpairedLink::hold(const byte* data, size_t length, time_point due) {
+    held.push(Held {
+        .due = due,
+        .order = nextOrder++,
+        .data = util::data::bytevector(data, data + length),
+    });
+}
+
+NetworkImpairment::NetworkImpairment(const ImpairmentConfig& config, SendFunction send)
+    : outgoing(config, config.seed == 0 ? std::random_device{}() : config.seed),
+      incoming(config, config.seed == 0 ? std::random_device{}() : config.seed + 1),
+      sendFunction(std::move(send))
+{
+    thread.setLoopFunction(&NetworkImpairment::threadFunc);
+    thread.setName("Network Impairment Thread");
+    thread.start(this);
+}
+
+NetworkImpairment::~NetworkImpairment() {
+    thread.stop();
+    cvar.notify_all();
+    thread.join();
+
+    auto logStats = [](std::string_view direction, const ImpairedLink::Stats& stats) {
+        log::info(
+            "impairment ({}): {} packets, {} dropped, {} duplicated, {} reordered",
+            direction, stats.submitted, stats.dropped, stats.duplicated, stats.reordered
+        );
+    };
+
+    logStats("outgoing", outgoing.getStats());
+    logStats("incoming", incoming.getStats());
+}
+
+std::optional<ImpairmentConfig> NetworkImpairment::configFromEnvironment() {
+    const char* spec = std::getenv("GLOBED_NET_IMPAIRMENT");
+    if (!spec || !*spec) return std::nullopt;
+
+    auto result = ImpairmentConfig::parse(spec);
+    if (result.isErr()) {
+        log::warn("ignoring GLOBED_NET_IMPAIRMENT, {}", result.unwrapErr());
+        return std::nullopt;
+    }
+
+    return result.unwrap();
+}
+
+void NetworkImpairment::send(const byte* data, size_t length) {
+    std::unique_lock lock(mtx);
+
+    auto before = outgoing.nextDue();
+    outgoing.submit(data, length);
+
+    // only wake the thread if it now has to send something sooner than it was going to
+    auto after = outgoing.nextDue();
+    if (after && (!before || *after < *before)) {
+        lock.unlock();
+        cvar.notify_one();
+    }
+}
+
+void NetworkImpairment::received(const byte* data, size_t length, bool fromServer) {
+    std::lock_guard lock(mtx);
+
+    if (fromServer) {
+        incoming.submit(data, length);
+    } else {
+        unimpaired.emplace_back(data, data + length);
+    }
+}
+
+std::optional<time_point> NetworkImpairment::nextIncoming() const {
+    std::lock_guard lock(mtx);
+
+    if (!unimpaired.empty()) return now();
+
+    return incoming.nextDue();
+}
+
+bool NetworkImpairment::popIncoming(util::data::bytevector& out, bool& fromServer) {
+    std::lock_guard lock(mtx);
+
+    if (!unimpaired.empty()) {
+        out = std::move(unimpaired.front());
+        unimpaired.pop_front();
+        fromServer = false;
+        return true;
+    }
+
+    fromServer = true;
+    return incoming.popDue(out);
+}
+
+void NetworkImpairment::clear() {
+    std::lock_guard lock(mtx);
+
+    outgoing.clear();
+    incoming.clear();
+    unimpaired.clear();
+}
+
+void NetworkImpairment::threadFunc() {
+    util::data::bytevector datagram;
+
+    {
+        std::unique_lock lock(mtx);
+
+        // wake up now and then even when idle, so that stopping the thread doesn't depend on a notification
+        auto wakeAt = now() + millis(100);
+        if (auto due = outgoing.nextDue()) {
+            wakeAt = std::min(wakeAt, *due);
+        }
+
+        cvar.wait_until(lock, wakeAt);
+
+        if (!outgoing.popDue(datagram)) return;
+    }
+
+    try {
+        sendFunction(datagram.data(), datagram.size());
+    } catch (const std::exception& e) {
+        log::warn("impairment thread failed to send a packet: {}", e.what());
+    }
+}
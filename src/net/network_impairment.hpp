@@ -0,0 +1,153 @@
+#pragma once
+#include <defs.hpp>
+#include <util/data.hpp>
+#include <util/sync.hpp>
+#include <util/time.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
+
+enum class JitterDistribution {
+    Uniform, // anywhere between -jitter and +jitter
+    Normal,  // jitter is the standard deviation
+    Pareto,  // only ever adds delay, mostly a little but sometimes a lot (like bad wifi). jitter is the average added delay.
+};
+
+// How bad the simulated connection is. The same settings apply to both directions, so the round trip gets the delays twice.
+struct ImpairmentConfig {
+    util::time::millis latency{0};
+    util::time::millis jitter{0};
+    JitterDistribution jitterDistribution = JitterDistribution::Normal;
+
+    // Packet loss follows the Gilbert-Elliott model, the link is either in a good or a bad state
+    // and drops packets with `loss` or `burstLoss` chance respectively. Both are 0 to 1.
+    float loss = 0.f;
+    float burstLoss = 0.f;
+    // chance per packet to go from the good state to the bad state, and back
+    float burstStart = 0.f;
+    float burstEnd = 0.25f;
+
+    // chance for a packet to be sent twice
+    float duplicate = 0.f;
+    // chance for a packet to be held back for an extra `reorderDelay`, so the ones after it arrive first
+    float reorder = 0.f;
+    util::time::millis reorderDelay{20};
+
+    // 0 means unlimited. Packets that would wait longer than `maxQueueDelay` to get through the bottleneck are dropped.
+    uint32_t bandwidthKbps = 0;
+    util::time::millis maxQueueDelay{200};
+
+    // 0 picks a random seed, anything else makes the same traffic get the same treatment every run
+    uint64_t seed = 0;
+
+    // Parses comma separated `key=value` pairs, for example `latency=80,jitter=20,loss=0.02`.
+    // Keys are the fields above in snake case (`jitter_dist` for the distribution, `bandwidth` in kbit/s), times are in milliseconds.
+    static Result<ImpairmentConfig> parse(std::string_view spec);
+
+    std::string toString() const;
+};
+
+/*
+* ImpairedLink is one direction of a simulated connection. It decides what happens to every datagram
+* and holds on to the ones that get through until they are due.
+*/
+class ImpairedLink {
+public:
+    struct Stats {
+        uint64_t submitted = 0;
+        uint64_t dropped = 0;
+        uint64_t duplicated = 0;
+        uint64_t reordered = 0;
+    };
+
+    ImpairedLink(const ImpairmentConfig& config, uint64_t seed);
+
+    void submit(const util::data::byte* data, size_t length, util::time::time_point now = util::time::now());
+
+    // When the next datagram is due, nullopt if none are held
+    std::optional<util::time::time_point> nextDue() const;
+
+    // Moves the next datagram into `out` if it's due, returns false if none are
+    bool popDue(util::data::bytevector& out, util::time::time_point now = util::time::now());
+
+    void clear();
+    const Stats& getStats() const;
+
+private:
+    struct Held {
+        util::time::time_point due;
+        uint64_t order; // keeps datagrams due at the same time in the order they were sent
+        util::data::bytevector data;
+
+        bool operator>(const Held& other) const {
+            return due != other.due ? due > other.due : order > other.order;
+        }
+    };
+
+    ImpairmentConfig config;
+    std::mt19937_64 rng;
+    std::priority_queue<Held, std::vector<Held>, std::greater<>> held;
+    uint64_t nextOrder = 0;
+
+    bool badState = false;
+    // when the bottleneck finishes sending everything before
+    util::time::time_point linkFree;
+
+    Stats stats;
+
+    bool chance(float probability);
+    util::time::micros sampleDelay();
+    void hold(const util::data::byte* data, size_t length, util::time::time_point due);
+};
+
+/*
+* NetworkImpairment makes the connection to the game server behave like a bad one, for testing against a local server.
+* `UdpSocket` hands it every datagram it sends to and receives from the server. Outgoing datagrams are sent
+* by a separate thread once they are due, and incoming ones are given back by `popIncoming`.
+*
+* It's enabled by setting the GLOBED_NET_IMPAIRMENT environment variable to a config, see `ImpairmentConfig::parse`:
+*   GLOBED_NET_IMPAIRMENT="latency=60,jitter=15,jitter_dist=pareto,loss=0.01,burst_start=0.02,burst_loss=0.5,bandwidth=512"
+*/
+class NetworkImpairment {
+public:
+    // actually sends a datagram to the server, called from the impairment thread
+    using SendFunction = std::function<void(const util::data::byte* data, size_t length)>;
+
+    NetworkImpairment(const ImpairmentConfig& config, SendFunction send);
+    ~NetworkImpairment();
+
+    NetworkImpairment(const NetworkImpairment&) = delete;
+    NetworkImpairment& operator=(const NetworkImpairment&) = delete;
+
+    // The config from GLOBED_NET_IMPAIRMENT, nullopt if it's unset or invalid
+    static std::optional<ImpairmentConfig> configFromEnvironment();
+
+    void send(const util::data::byte* data, size_t length);
+
+    // Datagrams not from the server are given back right away, without any impairment
+    void received(const util::data::byte* data, size_t length, bool fromServer);
+    std::optional<util::time::time_point> nextIncoming() const;
+    bool popIncoming(util::data::bytevector& out, bool& fromServer);
+
+    // Drops everything that is still held, for when the connection is closed
+    void clear();
+
+private:
+    ImpairedLink outgoing;
+    ImpairedLink incoming;
+    std::deque<util::data::bytevector> unimpaired;
+
+    SendFunction sendFunction;
+
+    // the links are used by the sending, receiving and impairment threads, and cleared from whichever one disconnects
+    mutable std::mutex mtx;
+    std::condition_variable cvar;
+    util::sync::SmartThread<NetworkImpairment*> thread;
+
+    void threadFunc();
+};
@@ -4,8 +4,11 @@
 #include <managers/error_queues.hpp>
 #include <managers/account.hpp>
 #include <managers/profile_cache.hpp>
+#include <net/address_resolver.hpp>
+#include <net/packet_capture.hpp>
 #include <util/net.hpp>
 #include <util/debug.hpp>
+#include <util/rng.hpp>
 
 using namespace geode::prelude;
 using namespace util::data;
@@ -15,6 +18,8 @@ NetworkManager::NetworkManager() {
 
     if (!gameSocket.create()) util::net::throwLastError();
 
+    PacketCapture::get().startFromEnvironment(PROTOCOL_VERSION);
+
     // add builtin listeners for connection related packets
 
     addBuiltinListener<CryptoHandshakeResponsePacket>([this](auto packet) {
@@ -50,6 +55,9 @@ NetworkManager::NetworkManager() {
         log::info("Successfully logged into the server!");
         connectedTps = packet->tps;
         _loggedin = true;
+
+        // the first one right away, then every `KEEPALIVE_INTERVAL`
+        this->scheduleTimer(NetworkTimer::Keepalive, util::time::now());
     });
 
     addBuiltinListener<LoginFailedPacket>([this](auto packet) {
@@ -85,15 +93,13 @@ NetworkManager::NetworkManager() {
         ErrorQueues::get().success("Successfully authorized");
     });
 
-    // boot up the threads
+    // boot up the thread
 
-    threadMain.setLoopFunction(&NetworkManager::threadMainFunc);
-    threadMain.setName("Network (out) Thread");
-    threadMain.start(this);
+    eventLoop.watch(gameSocket.socket_);
 
-    threadRecv.setLoopFunction(&NetworkManager::threadRecvFunc);
-    threadRecv.setName("Network (in) Thread");
-    threadRecv.start(this);
+    thread.setLoopFunction(&NetworkManager::threadFunc);
+    thread.setName("Network Thread");
+    thread.start(this);
 }
 
 NetworkManager::~NetworkManager() {
@@ -101,10 +107,12 @@ NetworkManager::~NetworkManager() {
 
     // clear listeners
     this->removeAllListeners();
-    builtinListeners.lock()->clear();
+    builtinListeners.lock()->fill({});
 
-    threadMain.stopAndWait();
-    threadRecv.stopAndWait();
+    // the thread only checks whether it was stopped when it wakes up
+    thread.stop();
+    eventLoop.wake();
+    thread.join();
 
     if (this->connected()) {
         log::debug("disconnecting from the server..");
@@ -121,7 +129,7 @@ NetworkManager::~NetworkManager() {
 }
 
 Result<> NetworkManager::connect(const std::string_view addr, unsigned short port, bool standalone) {
-    if (this->connected() && !this->handshaken()) {
+    if ((this->connected() && !this->handshaken()) || _connecting) {
         return Err("already trying to connect, please wait");
     }
 
@@ -131,21 +139,159 @@ Result<> NetworkManager::connect(const std::string_view addr, unsigned short por
 
     _connectingStandalone = standalone;
 
-    lastReceivedPacket = util::time::now();
-
     if (!standalone) {
         GLOBED_REQUIRE_SAFE(!GlobedAccountManager::get().authToken.lock()->empty(), "attempting to connect with no authtoken set in account manager")
     }
 
-    GLOBED_UNWRAP(gameSocket.connect(addr, port));
+    uint32_t attempt = connectAttempt.load() + 1;
+    connectAttempt = attempt;
+
+    auto& resolver = AddressResolver::get();
+
+    // IP addresses and recently resolved hostnames don't need a lookup
+    if (auto cached = resolver.lookupAll(addr, port)) {
+        auto result = std::move(*cached);
+        GLOBED_UNWRAP_INTO(result, auto addresses);
+        return this->connectToCandidates(attempt, addresses);
+    }
+
+    _connecting = true;
+
+    resolver.resolve(addr, port, [this, attempt](Result<AddressResolver::AddressList> result) {
+        // finish on the main thread, like when the address is known right away
+        Loader::get()->queueInMainThread([this, attempt, result = std::move(result)] {
+            this->finishResolving(attempt, result);
+        });
+    });
+
+    return Ok();
+}
+
+Result<> NetworkManager::connectToCandidates(uint32_t attempt, const AddressResolver::AddressList& addresses) {
+    // the first address of each family, the one the system prefers goes first
+    std::vector<sockaddr_storage> candidates;
+
+    for (const auto& address : addresses) {
+        if (address.ss_family == AF_INET6 && !gameSocket.supportsIPv6()) continue;
+
+        bool seen = std::any_of(candidates.begin(), candidates.end(), [&](const auto& c) { return c.ss_family == address.ss_family; });
+        if (!seen) candidates.push_back(address);
+    }
+
+    if (candidates.empty()) {
+        return Err("the server only has IPv6 addresses, but IPv6 is not available on this system");
+    }
+
+    if (candidates.size() == 1) {
+        return this->connectTo(candidates.front());
+    }
+
+    // happy eyeballs (RFC 8305): ping the server over both IPv6 and IPv4 and connect over whichever answers first,
+    // so that a broken or slow path (like IPv4 through a carrier grade NAT, or a misconfigured IPv6 network) isn't the one used
+    auto r = race.lock();
+    r->attempt = attempt;
+    r->candidates.clear();
+
+    for (const auto& address : candidates) {
+        auto pingId = util::rng::Random::get().generate<uint32_t>();
+
+        try {
+            gameSocket.sendPacketTo(PingPacket::create(pingId), address);
+            r->candidates.emplace_back(pingId, address);
+        } catch (const std::exception& e) {
+            log::debug("not trying {}: {}", util::net::formatAddress(address), e.what());
+        }
+    }
+
+    if (r->candidates.empty()) {
+        r->attempt = 0;
+        return Err("failed to send a packet to any of the server's addresses");
+    }
+
+    r.unlock();
+
+    _connecting = true;
+    this->scheduleTimer(NetworkTimer::ConnectRace, util::time::now() + RACE_TIMEOUT);
+
+    return Ok();
+}
+
+Result<> NetworkManager::connectTo(const sockaddr_storage& address) {
+    lastReceivedPacket = util::time::now();
+
+    try {
+        gameSocket.connect(address);
+    } catch (const std::exception& e) {
+        return Err(e.what());
+    }
+
+    log::debug("connecting to {}", util::net::formatAddress(address));
+
     gameSocket.createBox();
 
     auto packet = CryptoHandshakeStartPacket::create(PROTOCOL_VERSION, CryptoPublicKey(gameSocket.box->extractPublicKey()));
     this->send(packet);
 
+    this->scheduleTimer(NetworkTimer::ConnectionCheck, lastReceivedPacket + HANDSHAKE_TIMEOUT);
+
     return Ok();
 }
 
+void NetworkManager::finishResolving(uint32_t attempt, Result<AddressResolver::AddressList> result) {
+    // cancelled by `disconnect` while resolving
+    if (attempt != connectAttempt.load()) return;
+
+    _connecting = false;
+
+    Result<> connected = result.isOk() ? this->connectToCandidates(attempt, result.unwrap()) : Err(result.unwrapErr());
+
+    if (connected.isErr()) {
+        this->failConnecting(connected.unwrapErr());
+    }
+}
+
+bool NetworkManager::finishRace(std::optional<uint32_t> pingId) {
+    auto r = race.lock();
+    if (r->attempt == 0) return false;
+
+    // nobody answered in time, go with the preferred address and let the handshake time out if it's really dead
+    auto winner = r->candidates.begin();
+
+    if (pingId) {
+        winner = std::find_if(r->candidates.begin(), r->candidates.end(), [&](const auto& c) { return c.first == *pingId; });
+        if (winner == r->candidates.end()) return false;
+    }
+
+    auto address = winner->second;
+    uint32_t attempt = r->attempt;
+
+    r->attempt = 0;
+    r->candidates.clear();
+    r.unlock();
+
+    this->cancelTimer(NetworkTimer::ConnectRace);
+
+    Loader::get()->queueInMainThread([this, attempt, address] {
+        // cancelled by `disconnect` while racing
+        if (attempt != connectAttempt.load()) return;
+
+        _connecting = false;
+
+        auto result = this->connectTo(address);
+        if (result.isErr()) {
+            this->failConnecting(result.unwrapErr());
+        }
+    });
+
+    return true;
+}
+
+void NetworkManager::failConnecting(const std::string& message) {
+    ErrorQueues::get().error(fmt::format("Failed to connect to the server: <cy>{}</c>", message));
+    _connectingStandalone = false;
+    GameServerManager::get().clearActive();
+}
+
 Result<> NetworkManager::connectWithView(const GameServer& gsview) {
     auto result = this->connect(gsview.address.ip, gsview.address.port);
     if (result.isOk()) {
@@ -176,6 +322,15 @@ Result<> NetworkManager::connectStandalone() {
 }
 
 void NetworkManager::disconnect(bool quiet, bool noclear) {
+    // a hostname that is still being resolved or an address race that hasn't finished is forgotten about
+    if (_connecting) {
+        connectAttempt = connectAttempt.load() + 1;
+        _connecting = false;
+
+        race.lock()->attempt = 0;
+        this->cancelTimer(NetworkTimer::ConnectRace);
+    }
+
     if (!this->connected()) {
         return;
     }
@@ -190,8 +345,21 @@ void NetworkManager::disconnect(bool quiet, bool noclear) {
     _connectingStandalone = false;
     _adminAuthorized = false;
 
+    this->cancelTimer(NetworkTimer::Keepalive);
+    this->cancelTimer(NetworkTimer::ConnectionCheck);
+
     gameSocket.disconnect();
     gameSocket.cleanupBox();
+    gameSocket.reliable.reset();
+    gameSocket.fragments.reset();
+
+    // don't send stale state to the next server
+    for (auto& mailbox : mailboxes) {
+        mailbox.take();
+    }
+
+    this->logSendStats();
+    sendScheduler.clear();
 
     // GameServerManager could have been destructed before NetworkManager, so this could be UB. Additionally will break autoconnect.
     if (!noclear) {
@@ -199,106 +367,190 @@ void NetworkManager::disconnect(bool quiet, bool noclear) {
     }
 }
 
-void NetworkManager::send(std::shared_ptr<Packet> packet) {
+void NetworkManager::send(PacketPtr<Packet> packet) {
     GLOBED_REQUIRE(this->connected(), "tried to send a packet while disconnected")
-    packetQueue.push(std::move(packet));
+    sendScheduler.push(std::move(packet));
+    eventLoop.wake();
 }
 
-void NetworkManager::addListener(packetid_t id, PacketCallback&& callback) {
-    (*listeners.lock())[id] = std::move(callback);
+void NetworkManager::removeAllListeners() {
+    listeners.lock()->fill({});
 }
 
-void NetworkManager::removeListener(packetid_t id) {
-    listeners.lock()->erase(id);
-}
+void NetworkManager::dispatchInbox() {
+    auto now = util::time::systemNow();
 
-void NetworkManager::removeAllListeners() {
-    listeners.lock()->clear();
+    inbox.drain([&](Packet* packet, size_t index) {
+        // copy the listener out and unlock, so that it can add or remove listeners itself
+        auto listener = (*listeners.lock())[index];
+
+        if (listener) {
+            listener(packet);
+        } else if (now > (*suppressed.lock())[index]) {
+            ErrorQueues::get().debugWarn(fmt::format("Unhandled packet: {}", packet->getPacketId()));
+        }
+    });
 }
 
 // tasks
 
 void NetworkManager::taskPingServers() {
     taskQueue.push(NetworkThreadTask::PingServers);
+    eventLoop.wake();
 }
 
-// threads
+// thread
 
-void NetworkManager::threadMainFunc() {
-    if (_suspended) {
-        std::this_thread::sleep_for(util::time::millis(250));
+void NetworkManager::threadFunc() {
+    bool suspended = _suspended;
+
+    // while suspended, nothing but `resume` (or the destructor) ends the wait
+    auto result = eventLoop.wait(suspended ? std::nullopt : this->nextDeadline(), suspended);
+    if (result.isErr()) {
+        ErrorQueues::get().debugWarn(fmt::format("waiting for network events failed: {}", result.unwrapErr()));
         return;
     }
 
-    this->maybeSendKeepalive();
-
-    if (!packetQueue.waitForMessages(util::time::millis(250))) {
-        // check for tasks
-        if (taskQueue.empty()) return;
+    if (suspended) return;
 
-        for (const auto& task : taskQueue.popAll()) {
-            if (task == NetworkThreadTask::PingServers) {
-                auto& sm = GameServerManager::get();
-                auto activeServer = sm.getActiveId();
+    auto events = result.unwrap();
 
-                for (auto& [serverId, server] : sm.getAllServers()) {
-                    if (serverId == activeServer) continue;
+    auto held = gameSocket.nextHeldDatagram();
+    if (events.readable || (held && *held <= util::time::now())) {
+        this->receive();
+    }
 
-                    try {
-                        auto pingId = sm.startPing(serverId);
-                        gameSocket.sendPacketTo(PingPacket::create(pingId), server.address.ip, server.address.port);
-                    } catch (const std::exception& e) {
-                        ErrorQueues::get().warn(e.what());
-                    }
-                }
-            }
+    for (size_t i = 0; i < EventLoop::MAX_TIMERS; i++) {
+        if (events.expiredTimers & (1u << i)) {
+            this->handleTimer(static_cast<NetworkTimer>(i));
         }
     }
 
-    auto messages = packetQueue.popAll();
+    this->runTasks();
 
-    for (auto packet : messages) {
-        try {
-            gameSocket.sendPacket(packet);
-        } catch (const std::exception& e) {
-            ErrorQueues::get().error(e.what());
-        }
+    // also sends acks for reliable packets that were just received, and requests for missing fragments
+    this->flush();
+}
+
+void NetworkManager::receive() {
+    // drains everything that has arrived, and a datagram that fails doesn't take the packets from the others with it
+    try {
+        gameSocket.recvPackets(incoming);
+    } catch (const std::exception& e) {
+        ErrorQueues::get().debugWarn(fmt::format("failed to receive a packet: {}", e.what()));
+    }
+
+    for (auto& packet : incoming) {
+        this->handleIncoming(packet);
     }
+
+    incoming.clear();
 }
 
-void NetworkManager::threadRecvFunc() {
-    if (_suspended) {
-        std::this_thread::sleep_for(util::time::millis(250));
-        return;
+void NetworkManager::handleTimer(NetworkTimer timer) {
+    switch (timer) {
+        case NetworkTimer::Keepalive: {
+            if (!_loggedin) break;
+
+            this->sendKeepalive();
+            this->scheduleTimer(NetworkTimer::Keepalive, util::time::now() + KEEPALIVE_INTERVAL);
+        } break;
+        case NetworkTimer::ConnectionCheck: {
+            this->maybeDisconnectIfDead();
+
+            // check again when the server would have been silent for too long, if nothing arrives until then
+            if (this->connected()) {
+                auto limit = this->handshaken() ? util::time::millis(DISCONNECT_AFTER) : util::time::millis(HANDSHAKE_TIMEOUT);
+                this->scheduleTimer(NetworkTimer::ConnectionCheck, lastReceivedPacket + limit);
+            }
+        } break;
+        case NetworkTimer::PingTimeout: {
+            GameServerManager::get().expirePings(PING_TIMEOUT);
+        } break;
+        case NetworkTimer::ConnectRace: {
+            this->finishRace(std::nullopt);
+        } break;
     }
+}
 
-    auto result = gameSocket.poll(1000);
-    if (result.isErr()) {
-        ErrorQueues::get().debugWarn(fmt::format("poll failed: {}", result.unwrapErr()));
-        return;
+void NetworkManager::runTasks() {
+    if (taskQueue.empty()) return;
+
+    for (const auto& task : taskQueue.popAll()) {
+        if (task == NetworkThreadTask::PingServers) {
+            this->pingServers();
+        }
     }
+}
 
-    if (!result.unwrap()) {
-        this->maybeDisconnectIfDead();
-        return;
+void NetworkManager::flush() {
+    for (auto& mailbox : mailboxes) {
+        if (auto packet = mailbox.take()) {
+            sendScheduler.push(std::move(packet));
+        }
     }
 
-    GameSocket::IncomingPacket packet;
+    sendScheduler.popReady(outgoing);
 
     try {
-        packet = gameSocket.recvPacket();
+        gameSocket.sendPackets(outgoing);
     } catch (const std::exception& e) {
-        ErrorQueues::get().debugWarn(fmt::format("failed to receive a packet: {}", e.what()));
-        return;
+        ErrorQueues::get().error(e.what());
+    }
+
+    // keeps the capacity, but doesn't hold on to the packets until the next wake
+    outgoing.clear();
+}
+
+std::optional<util::time::time_point> NetworkManager::nextDeadline() {
+    auto now = util::time::now();
+    std::optional<util::time::time_point> deadline;
+
+    auto consider = [&](std::optional<util::time::time_point> when) {
+        if (when && (!deadline || *when < *deadline)) {
+            deadline = when;
+        }
+    };
+
+    // resending reliable packets that haven't been acknowledged, and requesting missing fragments
+    if (auto retransmit = gameSocket.reliable.untilRetransmit()) {
+        consider(now + *retransmit);
     }
 
+    if (auto request = gameSocket.fragments.untilRequest()) {
+        consider(now + *request);
+    }
+
+    // a paced packet that can go out once its class has enough tokens
+    if (auto ready = sendScheduler.untilReady()) {
+        consider(now + *ready);
+    }
+
+    // a datagram held back by a simulated bad connection
+    consider(gameSocket.nextHeldDatagram());
+
+    return deadline;
+}
+
+void NetworkManager::scheduleTimer(NetworkTimer timer, util::time::time_point when) {
+    eventLoop.schedule(static_cast<size_t>(timer), when);
+}
+
+void NetworkManager::cancelTimer(NetworkTimer timer) {
+    eventLoop.cancel(static_cast<size_t>(timer));
+}
+
+void NetworkManager::handleIncoming(GameSocket::IncomingPacket& packet) {
     packetid_t packetId = packet.packet->getPacketId();
 
     if (packetId == PingResponsePacket::PACKET_ID) {
-        this->handlePingResponse(packet.packet);
+        this->handlePingResponse(static_cast<PingResponsePacket*>(packet.packet.get()));
         return;
     }
 
+    // recvPackets only returns packets that are in the list
+    size_t index = ServerPackets::indexOf(packetId);
+
     // if it's not a ping packet, and it's NOT from the currently connected server, we reject it
     if (!packet.fromServer) {
         return;
@@ -307,45 +559,109 @@ void NetworkManager::threadRecvFunc() {
     lastReceivedPacket = util::time::now();
 
     auto builtin = builtinListeners.lock();
-    if (builtin->contains(packetId)) {
-        (*builtin)[packetId](packet.packet);
+    if (const auto& listener = (*builtin)[index]) {
+        listener(packet.packet.get());
         return;
     }
 
-    // this is scary
-    Loader::get()->queueInMainThread([this, packetId, packet]() {
-        auto listeners_ = this->listeners.lock();
-        if (!listeners_->contains(packetId)) {
-            auto suppressed_ = suppressed.lock();
+    builtin.unlock();
+
+    inbox.push(std::move(packet.packet), index);
+}
+
+void NetworkManager::handlePingResponse(PingResponsePacket* packet) {
+    // the answer to one of the pings racing the server's addresses
+    if (this->finishRace(packet->id)) return;
 
-            if (suppressed_->contains(packetId) && util::time::systemNow() > suppressed_->at(packetId)) {
-                suppressed_->erase(packetId);
+    GameServerManager::get().finishPing(packet->id, packet->playerCount);
+}
+
+void NetworkManager::sendKeepalive() {
+    this->send(KeepalivePacket::create());
+    GameServerManager::get().startKeepalive();
+}
+
+void NetworkManager::pingServers() {
+    auto& sm = GameServerManager::get();
+    auto& resolver = AddressResolver::get();
+    auto activeServer = sm.getActiveId();
+
+    pings.clear();
+    pingDestinations.clear();
+
+    for (auto& [serverId, server] : sm.getAllServers()) {
+        if (serverId == activeServer) continue;
+
+        auto address = sm.getResolvedAddress(serverId);
+
+        if (!address) {
+            util::time::time_point validUntil;
+            auto result = resolver.lookup(server.address.ip, server.address.port, &validUntil);
+
+            // a hostname that hasn't been resolved yet
+            if (!result) {
+                this->resolveForPing(serverId, server.address);
+                continue;
             }
 
-            if (!suppressed_->contains(packetId)) {
-                ErrorQueues::get().debugWarn(fmt::format("Unhandled packet: {}", packetId));
+            if (result->isErr()) {
+                ErrorQueues::get().debugWarn(fmt::format("not pinging {}: {}", serverId, result->unwrapErr()));
+                continue;
             }
-        } else {
-            // xd
-            (*listeners_)[packetId](packet.packet);
+
+            address = result->unwrap();
+            sm.setResolvedAddress(serverId, *address, validUntil);
         }
-    });
-}
 
-void NetworkManager::handlePingResponse(std::shared_ptr<Packet> packet) {
-    if (PingResponsePacket* pingr = dynamic_cast<PingResponsePacket*>(packet.get())) {
-        GameServerManager::get().finishPing(pingr->id, pingr->playerCount);
+        // would make the whole batch fail to send
+        if (address->ss_family == AF_INET6 && !gameSocket.supportsIPv6()) continue;
+
+        pings.push_back(PingPacket::create(sm.startPing(serverId)));
+        pingDestinations.push_back(*address);
+    }
+
+    // every server at once, instead of a system call for each
+    try {
+        gameSocket.sendPacketsTo(pings, pingDestinations);
+    } catch (const std::exception& e) {
+        ErrorQueues::get().warn(e.what());
     }
+
+    // servers that don't answer in time go back to showing an unknown ping
+    this->scheduleTimer(NetworkTimer::PingTimeout, util::time::now() + PING_TIMEOUT);
 }
 
-void NetworkManager::maybeSendKeepalive() {
-    if (_loggedin) {
-        auto now = util::time::now();
-        if ((now - lastKeepalive) > KEEPALIVE_INTERVAL) {
-            lastKeepalive = now;
-            this->send(KeepalivePacket::create());
-            GameServerManager::get().startKeepalive();
+void NetworkManager::resolveForPing(const std::string& serverId, const GameServerAddress& address) {
+    // already being resolved for an earlier sweep
+    if (!pingResolves.lock()->pending.insert(serverId).second) return;
+
+    // the callback can run right away on this thread, so the lock can't be held here
+    AddressResolver::get().resolve(address.ip, address.port, [this, serverId](auto result) {
+        auto resolves = pingResolves.lock();
+        resolves->pending.erase(serverId);
+        resolves->resolvedAny |= result.isOk();
+
+        // one more sweep once every hostname is done, it picks the addresses up from the resolver's cache
+        if (resolves->pending.empty() && resolves->resolvedAny) {
+            resolves->resolvedAny = false;
+            resolves.unlock();
+
+            this->taskPingServers();
         }
+    });
+}
+
+void NetworkManager::logSendStats() {
+    constexpr std::array<std::string_view, SendScheduler::CLASS_COUNT> names = {"control", "realtime", "voice", "bulk"};
+
+    for (size_t i = 0; i < SendScheduler::CLASS_COUNT; i++) {
+        auto stats = sendScheduler.getStats(static_cast<PacketPriority>(i));
+        if (stats.sentPackets == 0) continue;
+
+        log::info(
+            "send queue ({}): {} packets, {} bytes, waited {}us on average and {}us at most",
+            names[i], stats.sentPackets, stats.sentBytes, stats.averageWait.count(), stats.maxWait.count()
+        );
     }
 }
 
@@ -356,7 +672,7 @@ void NetworkManager::maybeDisconnectIfDead() {
     auto elapsed = util::time::now() - lastReceivedPacket;
 
     // if we haven't had a handshake response in 5 seconds, assume the server is dead
-    if (!this->handshaken() && elapsed > util::time::seconds(5)) {
+    if (!this->handshaken() && elapsed > HANDSHAKE_TIMEOUT) {
         ErrorQueues::get().error("Failed to connect to the server. No response was received after 5 seconds.");
         this->disconnect(true);
     } else if (elapsed > DISCONNECT_AFTER) {
@@ -369,10 +685,6 @@ void NetworkManager::maybeDisconnectIfDead() {
     }
 }
 
-void NetworkManager::addBuiltinListener(packetid_t id, PacketCallback&& callback) {
-    (*builtinListeners.lock())[id] = std::move(callback);
-}
-
 bool NetworkManager::connected() {
     return gameSocket.connected;
 }
@@ -395,8 +707,10 @@ bool NetworkManager::standalone() {
 
 void NetworkManager::suspend() {
     _suspended = true;
+    eventLoop.wake();
 }
 
 void NetworkManager::resume() {
     _suspended = false;
+    eventLoop.wake();
 }
\ No newline at end of file
@@ -1,9 +1,16 @@
 #pragma once
+#include "address_resolver.hpp"
+#include "event_loop.hpp"
 #include "game_socket.hpp"
+#include "packet_inbox.hpp"
+#include "packet_listener.hpp"
+#include "packet_mailbox.hpp"
+#include "send_scheduler.hpp"
 
-#include <functional>
-#include <unordered_map>
 #include <thread>
+#include <unordered_set>
+
+#include <data/packets/all.hpp>
 
 #include <managers/game_server.hpp>
 #include <managers/central_server.hpp>
@@ -17,9 +24,6 @@ enum class NetworkThreadTask {
     PingServers
 };
 
-template <typename T>
-concept HasPacketID = requires { T::PACKET_ID; };
-
 // This class is fully thread safe..? hell do i know..
 class NetworkManager : public SingletonBase<NetworkManager> {
 protected:
@@ -28,17 +32,14 @@ protected:
     ~NetworkManager();
 
 public:
-    using PacketCallback = std::function<void(std::shared_ptr<Packet>)>;
-
-    template <HasPacketID Pty>
-    using PacketCallbackSpecific = std::function<void(Pty*)>;
-
-    static constexpr uint16_t PROTOCOL_VERSION = 1;
+    static constexpr uint16_t PROTOCOL_VERSION = 2;
     static constexpr util::data::byte SERVER_MAGIC[10] = {0xda, 0xee, 'g', 'l', 'o', 'b', 'e', 'd', 0xda, 0xee};
 
     AtomicU32 connectedTps; // if `authenticated() == true`, this is the TPS of the current server, otherwise undefined.
 
-    // Connect to a server
+    // Connect to a server. A hostname that isn't cached is resolved in the background first (see `AddressResolver`),
+    // and if the server has both IPv6 and IPv4 addresses, both are pinged and the one that answers first is used.
+    // Errors that happen after this returns are reported through `ErrorQueues` instead of the result.
     Result<> connect(const std::string_view addr, unsigned short port, bool standalone = false);
     // Safer version of `connect`, sets the active game server in `GameServerManager` on success, doesn't throw on exception on error
     Result<> connectWithView(const GameServer& gsview);
@@ -50,33 +51,44 @@ public:
     void disconnect(bool quiet = false, bool noclear = false);
 
     // Sends a packet to the currently established connection. Throws if disconnected.
-    void send(std::shared_ptr<Packet> packet);
+    // The packet is queued by its `PacketPriority` (see `SendScheduler::classify`) and may be held back if its class is paced.
+    void send(PacketPtr<Packet> packet);
 
-    // Adds a packet listener and calls your callback function when a packet with `id` is received.
-    // If there already was a callback with this packet ID, it gets replaced.
-    // All callbacks are ran in the main (GD) thread.
-    void addListener(packetid_t id, PacketCallback&& callback);
+    // Packets with periodic state that can be sent with `sendLatest`
+    using MailboxPackets = PacketList<PlayerDataPacket>;
 
-    // Same as addListener(packetid_t, PacketCallback) but hacky syntax xd
+    // Like `send`, but for periodic state that is only useful while fresh. If the previous packet of this type
+    // hasn't been sent yet, it is replaced by this one instead of both being sent. Throws if disconnected.
     template <HasPacketID Pty>
-    void addListener(PacketCallbackSpecific<Pty>&& callback) {
-        this->addListener(Pty::PACKET_ID, [callback](std::shared_ptr<Packet> pkt) {
-            callback(static_cast<Pty*>(pkt.get()));
-        });
+    void sendLatest(PacketPtr<Packet> packet) {
+        GLOBED_REQUIRE(this->connected(), "tried to send a packet while disconnected")
+        GLOBED_REQUIRE(packet->getPacketId() == Pty::PACKET_ID, "packet type does not match the mailbox")
+
+        mailboxes[MailboxPackets::indexOf<Pty>()].put(std::move(packet));
+        eventLoop.wake();
     }
 
-    // Removes a listener by packet ID.
-    void removeListener(packetid_t id);
+    // Adds a packet listener and calls your callback function with a `Pty*` when that packet is received.
+    // If there already was a callback for this packet, it gets replaced. See `PacketListener` for what the callback can capture.
+    // All callbacks are ran in the main (GD) thread.
+    template <HasPacketID Pty, typename F>
+    void addListener(F&& callback) {
+        (*listeners.lock())[ServerPackets::indexOf<Pty>()] = PacketListener::create<Pty>(std::forward<F>(callback));
+    }
 
-    // Same as removeListener(packetid_t) but hacky syntax once again
-    template <HasPacketID T>
+    // Removes the listener for this packet.
+    template <HasPacketID Pty>
     void removeListener() {
-        this->removeListener(T::PACKET_ID);
+        (*listeners.lock())[ServerPackets::indexOf<Pty>()].reset();
     }
 
     // Removes all listeners.
     void removeAllListeners();
 
+    // Calls the listeners for every packet received since the last call. Must be called from the main thread,
+    // this is done once per frame by the `CCScheduler` hook.
+    void dispatchInbox();
+
     // queues task for pinging servers
     void taskPingServers();
 
@@ -98,31 +110,81 @@ public:
     void suspend();
     void resume();
 
-    template <HasPacketID Packet, typename Rep, typename Period>
+    template <HasPacketID Pty, typename Rep, typename Period>
     void suppressUnhandledFor(util::time::duration<Rep, Period> duration) {
         auto endPoint = util::time::systemNow() + duration;
-        (*suppressed.lock())[Packet::PACKET_ID] = endPoint;
+        (*suppressed.lock())[ServerPackets::indexOf<Pty>()] = endPoint;
     }
 
 private:
     static constexpr chrono::seconds KEEPALIVE_INTERVAL = chrono::seconds(5);
     static constexpr chrono::seconds DISCONNECT_AFTER = chrono::seconds(15);
+    static constexpr chrono::seconds HANDSHAKE_TIMEOUT = chrono::seconds(5);
+    // how long to wait for the servers to respond to a ping sweep before their pings are shown as unknown
+    static constexpr chrono::seconds PING_TIMEOUT = chrono::seconds(5);
+    // how long to wait for any of a server's addresses to answer before connecting to the preferred one anyway
+    static constexpr chrono::milliseconds RACE_TIMEOUT = chrono::milliseconds(1000);
+
+    // indices of the timers in `eventLoop`
+    enum class NetworkTimer : size_t {
+        Keepalive,
+        ConnectionCheck,
+        PingTimeout,
+        ConnectRace,
+    };
 
     GameSocket gameSocket;
 
-    SmartMessageQueue<std::shared_ptr<Packet>> packetQueue;
+    SendScheduler sendScheduler;
+    // latest unsent packet of every type in `MailboxPackets`, handed to `sendScheduler` right before sending
+    std::array<PacketMailbox, MailboxPackets::COUNT> mailboxes;
+    // received packets waiting for the main thread
+    PacketInbox inbox;
     SmartMessageQueue<NetworkThreadTask> taskQueue;
 
-    WrappingMutex<std::unordered_map<packetid_t, PacketCallback>> listeners;
-    WrappingMutex<std::unordered_map<packetid_t, util::time::system_time_point>> suppressed;
+    // indexed by `ServerPackets::indexOf`
+    using ListenerSlots = std::array<PacketListener, ServerPackets::COUNT>;
+
+    WrappingMutex<ListenerSlots> listeners;
+    // until when a warning shouldn't be shown if the packet has no listener
+    WrappingMutex<std::array<util::time::system_time_point, ServerPackets::COUNT>> suppressed;
 
-    // threads
+    // thread
 
-    void threadMainFunc();
-    void threadRecvFunc();
+    // Everything network related happens on this thread. It sleeps in `eventLoop` until a datagram arrives, a timer expires,
+    // a packet is queued, or a reliable packet has to be resent, and handles everything that's due each time it wakes up.
+    void threadFunc();
+    void receive();
+    void handleTimer(NetworkTimer timer);
+    void runTasks();
+    void flush();
+    void handleIncoming(GameSocket::IncomingPacket& packet);
+    // the earliest of the deadlines that aren't timers, nullopt if there is nothing to wait for
+    std::optional<util::time::time_point> nextDeadline();
 
-    SmartThread<NetworkManager*> threadMain;
-    SmartThread<NetworkManager*> threadRecv;
+    void scheduleTimer(NetworkTimer timer, util::time::time_point when);
+    void cancelTimer(NetworkTimer timer);
+
+    EventLoop eventLoop;
+
+    // packets from the last received datagrams, only used by the network thread
+    std::vector<GameSocket::IncomingPacket> incoming;
+    // packets that are due to be sent, only used by the network thread
+    std::vector<PacketPtr<Packet>> outgoing;
+    // kept between ping sweeps, only used by the network thread
+    std::vector<PacketPtr<Packet>> pings;
+    std::vector<sockaddr_storage> pingDestinations;
+
+    struct PingResolves {
+        // servers whose hostname is being resolved for a ping sweep
+        std::unordered_set<std::string> pending;
+        bool resolvedAny = false;
+    };
+
+    // touched by the resolver thread too
+    WrappingMutex<PingResolves> pingResolves;
+
+    SmartThread<NetworkManager*> thread;
 
     // misc
 
@@ -131,23 +193,45 @@ private:
     AtomicBool _adminAuthorized = false;
     AtomicBool _connectingStandalone = false;
     AtomicBool _suspended = false;
+    // resolving the address or racing the candidates, before `connected` becomes true
+    AtomicBool _connecting = false;
 
-    util::time::time_point lastKeepalive;
-    util::time::time_point lastReceivedPacket;
+    // changed by every `connect` and `disconnect`, so that a hostname resolved or a race won too late knows it's no longer wanted
+    AtomicU32 connectAttempt = 0;
 
-    void handlePingResponse(std::shared_ptr<Packet> packet);
-    void maybeSendKeepalive();
-    void maybeDisconnectIfDead();
+    struct ConnectRace {
+        // the `connectAttempt` the race is for, 0 if there is no race
+        uint32_t attempt = 0;
+        // the ID of the ping sent to each address, the preferred address first
+        std::vector<std::pair<uint32_t, sockaddr_storage>> candidates;
+    };
 
-    // Builtin listeners have priority above the others.
-    WrappingMutex<std::unordered_map<packetid_t, PacketCallback>> builtinListeners;
+    WrappingMutex<ConnectRace> race;
 
-    void addBuiltinListener(packetid_t id, PacketCallback&& callback);
+    util::time::time_point lastReceivedPacket;
 
-    template <HasPacketID Pty>
-    void addBuiltinListener(PacketCallbackSpecific<Pty>&& callback) {
-        this->addBuiltinListener(Pty::PACKET_ID, [callback = std::move(callback)](std::shared_ptr<Packet> pkt) {
-            callback(static_cast<Pty*>(pkt.get()));
-        });
+    // Connects right away if there is only one address to try, otherwise starts a race between them
+    Result<> connectToCandidates(uint32_t attempt, const AddressResolver::AddressList& addresses);
+    Result<> connectTo(const sockaddr_storage& address);
+    void finishResolving(uint32_t attempt, Result<AddressResolver::AddressList> result);
+    // Ends the race with the address that got the ping `pingId`, or with the preferred one if nullopt. Returns false if it's not a ping from the race.
+    bool finishRace(std::optional<uint32_t> pingId);
+    void failConnecting(const std::string& message);
+
+    void handlePingResponse(PingResponsePacket* packet);
+    void sendKeepalive();
+    void maybeDisconnectIfDead();
+    // Logs how much every `PacketPriority` sent and how long it had to wait, for the connection that is ending
+    void logSendStats();
+    void pingServers();
+    // Resolves the hostname of a server in the background, and asks for another sweep when the last pending one is done
+    void resolveForPing(const std::string& serverId, const GameServerAddress& address);
+
+    // Builtin listeners have priority above the others, and are ran on the network thread.
+    WrappingMutex<ListenerSlots> builtinListeners;
+
+    template <HasPacketID Pty, typename F>
+    void addBuiltinListener(F&& callback) {
+        (*builtinListeners.lock())[ServerPackets::indexOf<Pty>()] = PacketListener::create<Pty>(std::forward<F>(callback));
     }
 };
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "packet_capture.hpp"
+
+#include <data/packets/client/connection.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace geode::prelude;
+using namespace util::time;
+using util::data::byte;
+
+PacketCapture::PacketCapture() {}
+
+PacketCapture::~PacketCapture() {
+    this->stop();
+}
+
+Result<> PacketCapture::start(const std::string& path, uint16_t protocol) {
+    this->stop();
+
+    std::lock_guard lock(mtx);
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return Err(fmt::format("failed to open {} for writing", path));
+    }
+
+    startTime = now();
+    recordCount = 0;
+
+    pending.clear();
+    pending.writeBytes(capture::MAGIC, sizeof(capture::MAGIC));
+    pending.writeU16(capture::FORMAT_VERSION);
+    pending.writeU16(protocol);
+    pending.writeU64(as<micros>(systemNow().time_since_epoch()).count());
+
+    active = true;
+
+    log::info("capturing packets into {}", path);
+    log::warn("packet captures contain everything sent to and from the server in plaintext, only the login token is left out");
+
+    return Ok();
+}
+
+void PacketCapture::startFromEnvironment(uint16_t protocol) {
+    const char* path = std::getenv("GLOBED_CAPTURE");
+    if (!path || !*path) return;
+
+    auto result = this->start(path, protocol);
+    if (result.isErr()) {
+        log::warn("not capturing packets, {}", result.unwrapErr());
+    }
+}
+
+void PacketCapture::stop() {
+    std::lock_guard lock(mtx);
+
+    if (!active) return;
+    active = false;
+
+    this->flush();
+    file.close();
+
+    log::info("packet capture finished, {} packets", recordCount);
+}
+
+void PacketCapture::write(packetid_t id, const byte* data, size_t length, bool encrypted, bool outgoing) {
+    std::lock_guard lock(mtx);
+
+    // could have been stopped while waiting for the lock
+    if (!active) return;
+
+    this->append(id, data, length, encrypted, outgoing);
+}
+
+void PacketCapture::writeOutgoing(const Packet& packet) {
+    std::lock_guard lock(mtx);
+
+    if (!active) return;
+
+    scratch.clear();
+
+    if (packet.getPacketId() == LoginPacket::PACKET_ID) {
+        // same length, so the capture still has the real packet size
+        const auto& login = static_cast<const LoginPacket&>(packet);
+        LoginPacket redacted(login.accountId, login.name, std::string(login.token.size(), '*'), login.icons);
+        redacted.encode(scratch);
+    } else {
+        packet.encode(scratch);
+    }
+
+    this->append(packet.getPacketId(), scratch.getDataRef().data(), scratch.size(), packet.getEncrypted(), true);
+}
+
+void PacketCapture::append(packetid_t id, const byte* data, size_t length, bool encrypted, bool outgoing) {
+    uint8_t flags = (outgoing ? CaptureRecord::FLAG_OUTGOING : 0) | (encrypted ? CaptureRecord::FLAG_ENCRYPTED : 0);
+
+    pending.writeU64(as<micros>(now() - startTime).count());
+    pending.writeU8(flags);
+    pending.writeU16(id);
+    pending.writeU32(length);
+    pending.writeBytes(data, length);
+
+    recordCount++;
+
+    if (pending.size() >= FLUSH_THRESHOLD) {
+        this->flush();
+    }
+}
+
+void PacketCapture::flush() {
+    const auto& data = pending.getDataRef();
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    pending.clear();
+
+    if (!file) {
+        log::warn("failed to write to the packet capture, stopping it");
+        active = false;
+        file.close();
+    }
+}
+
+Result<CaptureReader> CaptureReader::open(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return Err(fmt::format("failed to open {}", path));
+    }
+
+    CaptureReader reader;
+    reader.data.resize(file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(reader.data.data()), reader.data.size());
+
+    if (!file) {
+        return Err(fmt::format("failed to read {}", path));
+    }
+
+    if (reader.data.size() < capture::HEADER_SIZE || std::memcmp(reader.data.data(), capture::MAGIC, sizeof(capture::MAGIC)) != 0) {
+        return Err("not a packet capture");
+    }
+
+    ByteReader header(reader.data.data() + sizeof(capture::MAGIC), capture::HEADER_SIZE - sizeof(capture::MAGIC));
+
+    uint16_t version = header.readU16();
+    if (version != capture::FORMAT_VERSION) {
+        return Err(fmt::format("unsupported capture format version {}", version));
+    }
+
+    reader.protocol = header.readU16();
+    reader.startTime = system_time_point(as<system_time_point::duration>(micros(header.readU64())));
+
+    return Ok(std::move(reader));
+}
+
+uint16_t CaptureReader::getProtocol() const {
+    return protocol;
+}
+
+system_time_point CaptureReader::getStartTime() const {
+    return startTime;
+}
+
+std::optional<CaptureRecord> CaptureReader::next() {
+    if (position == data.size()) return std::nullopt;
+
+    ByteReader buf(data.data() + position, data.size() - position);
+
+    CaptureRecord record;
+    record.timestamp = micros(buf.readU64());
+
+    uint8_t flags = buf.readU8();
+    record.outgoing = (flags & CaptureRecord::FLAG_OUTGOING) != 0;
+    record.encrypted = (flags & CaptureRecord::FLAG_ENCRYPTED) != 0;
+
+    record.id = buf.readU16();
+
+    size_t length = buf.readU32();
+    GLOBED_REQUIRE(length <= buf.remaining(), "packet capture is truncated")
+
+    const byte* payload = data.data() + position + buf.getPosition();
+    record.payload = std::span(payload, length);
+
+    position += capture::RECORD_HEADER_SIZE + length;
+
+    return record;
+}
+
+void CaptureReader::rewind() {
+    position = capture::HEADER_SIZE;
+}
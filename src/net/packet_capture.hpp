@@ -0,0 +1,119 @@
+#pragma once
+#include <defs.hpp>
+#include <data/bytebuffer.hpp>
+#include <data/packets/packet.hpp>
+#include <util/time.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+/*
+* A capture file starts with a header:
+*   MAGIC (8 bytes), u16 FORMAT_VERSION, u16 protocol version, u64 unix time in microseconds when the capture started
+* followed by one record per packet until the end of the file:
+*   u64 microseconds since the start, u8 flags (see CaptureRecord), u16 packet ID, u32 payload length, payload
+*
+* Everything is big endian like the rest of the protocol. Payloads are what `Packet::encode` writes and `Packet::decode` reads,
+* never encrypted, compressed, fragmented or wrapped in a reliable packet.
+*/
+namespace capture {
+    constexpr util::data::byte MAGIC[8] = {'G', 'L', 'B', 'D', 'C', 'A', 'P', 0x00};
+    constexpr uint16_t FORMAT_VERSION = 1;
+    constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 2 + 2 + 8;
+    constexpr size_t RECORD_HEADER_SIZE = 8 + 1 + 2 + 4;
+}
+
+struct CaptureRecord {
+    static constexpr uint8_t FLAG_OUTGOING = 1 << 0;
+    static constexpr uint8_t FLAG_ENCRYPTED = 1 << 1;
+
+    util::time::micros timestamp;
+    bool outgoing;
+    bool encrypted; // whether the packet was encrypted on the wire
+    packetid_t id;
+    // points into the reader, valid as long as it is
+    std::span<const util::data::byte> payload;
+};
+
+/*
+* PacketCapture writes every packet sent to and received from the server into a capture file, with the whole decrypted payload.
+* Incoming packets are recorded right before they are decoded, so reliable packets are in the order they were delivered in,
+* and bundles are split up into the packets inside. Outgoing packets are recorded when they are handed to the socket,
+* before they are wrapped or bundled, so retransmits, acks and fragment requests don't show up.
+*
+* The token in `LoginPacket` is replaced with asterisks, everything else (chat messages included) is stored as is.
+*
+* Starts on its own if the GLOBED_CAPTURE environment variable is set to a file path. Captures can be replayed with `globed-replay` (see bench/).
+*/
+class PacketCapture : public SingletonBase<PacketCapture> {
+protected:
+    friend class SingletonBase;
+    PacketCapture();
+    ~PacketCapture();
+
+public:
+    // records are kept in memory until this many bytes have piled up, and then written all at once
+    static constexpr size_t FLUSH_THRESHOLD = 256 * 1024;
+
+    // Starts a new capture, stopping the previous one first if there is one
+    Result<> start(const std::string& path, uint16_t protocol);
+    // Starts a capture into the file in GLOBED_CAPTURE, does nothing if it's unset
+    void startFromEnvironment(uint16_t protocol);
+    void stop();
+
+    bool isActive() const {
+        return active.load(std::memory_order::relaxed);
+    }
+
+    void record(packetid_t id, const util::data::byte* data, size_t length, bool encrypted, bool outgoing) {
+        if (!this->isActive()) return;
+
+        this->write(id, data, length, encrypted, outgoing);
+    }
+
+    // Encodes the packet just for the capture, the socket only ever has it wrapped in a bundle or a reliable packet
+    void recordOutgoing(const Packet& packet) {
+        if (!this->isActive()) return;
+
+        this->writeOutgoing(packet);
+    }
+
+private:
+    std::atomic_bool active = false;
+
+    // written from both the network thread and whichever thread sends packets
+    std::mutex mtx;
+    std::ofstream file;
+    ByteBuffer pending;
+    // outgoing packets are encoded into this first
+    ByteBuffer scratch;
+    util::time::time_point startTime;
+    size_t recordCount = 0;
+
+    void write(packetid_t id, const util::data::byte* data, size_t length, bool encrypted, bool outgoing);
+    void writeOutgoing(const Packet& packet);
+    // adds a record, `mtx` must be held
+    void append(packetid_t id, const util::data::byte* data, size_t length, bool encrypted, bool outgoing);
+    void flush();
+};
+
+// Reads a whole capture file into memory and goes through its records one by one
+class CaptureReader {
+public:
+    static Result<CaptureReader> open(const std::string& path);
+
+    uint16_t getProtocol() const;
+    util::time::system_time_point getStartTime() const;
+
+    // The next record, or nullopt at the end of the capture. Throws if the file is truncated.
+    std::optional<CaptureRecord> next();
+    // Goes back to the first record
+    void rewind();
+
+private:
+    util::data::bytevector data;
+    size_t position = capture::HEADER_SIZE;
+    uint16_t protocol = 0;
+    util::time::system_time_point startTime;
+};
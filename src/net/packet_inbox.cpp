@@ -0,0 +1,24 @@
+#include "packet_inbox.hpp"
+
+PacketInbox::~PacketInbox() {
+    this->clear();
+}
+
+void PacketInbox::push(PacketPtr<Packet> packet, size_t index) {
+    if (ServerPackets::isLatestOnly(index)) {
+        Packet* previous = latest[index].exchange(packet.release(), std::memory_order_acq_rel);
+
+        // the older packet was never delivered, drop it
+        PacketPtr<Packet>::adopt(previous);
+        return;
+    }
+
+    Packet* raw = packet.release();
+    raw->nextInInbox = head.load(std::memory_order_relaxed);
+
+    while (!head.compare_exchange_weak(raw->nextInInbox, raw, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+void PacketInbox::clear() {
+    this->drain([](Packet*, size_t) {});
+}
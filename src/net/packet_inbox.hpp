@@ -0,0 +1,62 @@
+#pragma once
+#include <data/packets/all.hpp>
+
+/*
+* PacketInbox hands received packets from the network thread over to the main thread without locking.
+* Any thread can push, but only one thread (the main thread) may drain it.
+*
+* Packets are linked through `Packet::nextInInbox`, so pushing doesn't allocate. `LatestOnly` packets don't go into the queue,
+* instead every type has a single slot that a newer packet replaces, so after a stall only the newest one gets delivered.
+*/
+class PacketInbox {
+public:
+    PacketInbox() = default;
+    ~PacketInbox();
+
+    PacketInbox(const PacketInbox&) = delete;
+    PacketInbox& operator=(const PacketInbox&) = delete;
+
+    // `index` is the index of the packet in `ServerPackets`
+    void push(PacketPtr<Packet> packet, size_t index);
+
+    // Call `callback(Packet*, size_t index)` for every packet pushed since the last drain. Queued packets come first,
+    // in the order they were pushed, and then the newest packet of every `LatestOnly` type.
+    template <typename F>
+    void drain(F&& callback) {
+        // reverse the list to get the packets in the order they were pushed
+        Packet* queued = nullptr;
+        Packet* current = head.exchange(nullptr, std::memory_order_acquire);
+
+        while (current) {
+            Packet* next = current->nextInInbox;
+            current->nextInInbox = queued;
+            queued = current;
+            current = next;
+        }
+
+        while (queued) {
+            auto packet = PacketPtr<Packet>::adopt(queued);
+            queued = queued->nextInInbox;
+            packet->nextInInbox = nullptr;
+
+            callback(packet.get(), ServerPackets::indexOf(packet->getPacketId()));
+        }
+
+        for (size_t i = 0; i < ServerPackets::COUNT; i++) {
+            if (!ServerPackets::isLatestOnly(i)) continue;
+
+            if (Packet* latestPacket = latest[i].exchange(nullptr, std::memory_order_acquire)) {
+                auto packet = PacketPtr<Packet>::adopt(latestPacket);
+                callback(packet.get(), i);
+            }
+        }
+    }
+
+    // Drop all pending packets
+    void clear();
+
+private:
+    // most recently pushed packet first
+    std::atomic<Packet*> head = nullptr;
+    std::array<std::atomic<Packet*>, ServerPackets::COUNT> latest{};
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <data/packets/packet.hpp>
+
+#include <new>
+
+/*
+* PacketListener holds the callback for one packet type. The callback is stored inline and called through a plain function pointer,
+* so adding a listener doesn't allocate and calling it is a single indirect call.
+*
+* Callbacks must be trivially copyable and at most `STORAGE_SIZE` bytes big, which is true for any lambda that only captures pointers.
+*/
+class PacketListener {
+public:
+    static constexpr size_t STORAGE_SIZE = 4 * sizeof(void*);
+
+    PacketListener() = default;
+
+    template <HasPacketID Pty, typename F>
+    static PacketListener create(F&& callback) {
+        using Callback = std::decay_t<F>;
+
+        static_assert(std::is_invocable_v<const Callback&, Pty*>, "listener must be callable with a pointer to the packet");
+        static_assert(std::is_trivially_copyable_v<Callback>, "listener must be trivially copyable, capture pointers instead of objects");
+        static_assert(sizeof(Callback) <= STORAGE_SIZE, "listener captures too much");
+        static_assert(alignof(Callback) <= alignof(std::max_align_t), "listener is overaligned");
+
+        PacketListener listener;
+        new (listener.storage) Callback(std::forward<F>(callback));
+        listener.invoker = [](const util::data::byte* storage, Packet* packet) {
+            (*std::launder(reinterpret_cast<const Callback*>(storage)))(static_cast<Pty*>(packet));
+        };
+
+        return listener;
+    }
+
+    void operator()(Packet* packet) const {
+        invoker(storage, packet);
+    }
+
+    explicit operator bool() const {
+        return invoker != nullptr;
+    }
+
+    void reset() {
+        invoker = nullptr;
+    }
+
+private:
+    alignas(std::max_align_t) util::data::byte storage[STORAGE_SIZE];
+    void (*invoker)(const util::data::byte*, Packet*) = nullptr;
+};
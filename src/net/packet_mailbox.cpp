@@ -0,0 +1,14 @@
+#include "packet_mailbox.hpp"
+
+PacketMailbox::~PacketMailbox() {
+    this->take();
+}
+
+bool PacketMailbox::put(PacketPtr<Packet> newPacket) {
+    auto previous = PacketPtr<Packet>::adopt(packet.exchange(newPacket.release(), std::memory_order_acq_rel));
+    return previous.get() != nullptr;
+}
+
+PacketPtr<Packet> PacketMailbox::take() {
+    return PacketPtr<Packet>::adopt(packet.exchange(nullptr, std::memory_order_acquire));
+}
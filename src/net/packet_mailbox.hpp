@@ -0,0 +1,24 @@
+#pragma once
+#include <data/packets/packet.hpp>
+
+/*
+* PacketMailbox holds at most one unsent packet. Putting a new one in drops the previous one if it hasn't been taken yet,
+* so whoever takes from it always gets the freshest packet. Safe to use from any thread, without locking.
+*/
+class PacketMailbox {
+public:
+    PacketMailbox() = default;
+    ~PacketMailbox();
+
+    PacketMailbox(const PacketMailbox&) = delete;
+    PacketMailbox& operator=(const PacketMailbox&) = delete;
+
+    // Returns true if a packet that wasn't taken yet got replaced
+    bool put(PacketPtr<Packet> newPacket);
+
+    // Returns the packet and empties the mailbox, or returns nullptr if it was empty
+    PacketPtr<Packet> take();
+
+private:
+    std::atomic<Packet*> packet = nullptr;
+};
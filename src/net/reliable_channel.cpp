@@ -0,0 +1,210 @@
+#include "reliable_channel.hpp"
+
+#include <data/packets/client/admin.hpp>
+#include <data/packets/client/game.hpp>
+#include <data/packets/client/general.hpp>
+
+using namespace util::time;
+
+namespace {
+    // retransmission timeout until the first round trip is measured
+    constexpr micros INITIAL_RTO = millis(500);
+    constexpr micros MIN_RTO = millis(100);
+    constexpr micros MAX_RTO = millis(3000);
+    // a packet that still isn't acknowledged after this many retransmissions is dropped, the connection is most likely dead
+    constexpr uint32_t MAX_RETRANSMITS = 8;
+}
+
+bool ReliableChannel::isReliable(packetid_t id) {
+    switch (id) {
+        case LoginPacket::PACKET_ID:
+        case SyncIconsPacket::PACKET_ID:
+        case CreateRoomPacket::PACKET_ID:
+        case JoinRoomPacket::PACKET_ID:
+        case LeaveRoomPacket::PACKET_ID:
+        case RequestRoomPlayerListPacket::PACKET_ID:
+        case RequestLevelListPacket::PACKET_ID:
+        case RequestPlayerProfilesPacket::PACKET_ID:
+        case LevelJoinPacket::PACKET_ID:
+        case LevelLeavePacket::PACKET_ID:
+        case AdminAuthPacket::PACKET_ID:
+        case AdminSendNoticePacket::PACKET_ID:
+            return true;
+        default:
+            return false;
+    }
+}
+
+PacketPtr<Packet> ReliableChannel::wrap(PacketPtr<Packet> packet) {
+    std::lock_guard lock(mtx);
+
+    auto wrapped = ReliablePacket::create(nextSequence++, std::move(packet));
+    std::tie(wrapped->ack, wrapped->ackBits) = this->takeAck();
+
+    unacked.push_back(Unacked {
+        .packet = wrapped,
+        .sentAt = now(),
+        .retransmits = 0
+    });
+
+    return wrapped;
+}
+
+void ReliableChannel::pollRetransmits(std::vector<PacketPtr<Packet>>& out) {
+    std::lock_guard lock(mtx);
+
+    auto currentTime = now();
+    auto timeout = this->rto();
+
+    for (auto it = unacked.begin(); it != unacked.end();) {
+        if (currentTime < this->deadline(*it, timeout)) {
+            ++it;
+            continue;
+        }
+
+        if (it->retransmits >= MAX_RETRANSMITS) {
+            it = unacked.erase(it);
+            continue;
+        }
+
+        it->retransmits++;
+        it->sentAt = currentTime;
+        std::tie(it->packet->ack, it->packet->ackBits) = this->takeAck();
+        out.push_back(it->packet);
+        ++it;
+    }
+}
+
+std::optional<micros> ReliableChannel::untilRetransmit() {
+    std::lock_guard lock(mtx);
+
+    auto currentTime = now();
+    auto timeout = this->rto();
+    std::optional<micros> soonest;
+
+    for (const auto& packet : unacked) {
+        auto until = std::max(as<micros>(this->deadline(packet, timeout) - currentTime), micros(0));
+        soonest = soonest ? std::min(*soonest, until) : until;
+    }
+
+    return soonest;
+}
+
+PacketPtr<Packet> ReliableChannel::makeAck() {
+    std::lock_guard lock(mtx);
+
+    if (!_ackPending) return nullptr;
+
+    auto [ack, ackBits] = this->takeAck();
+    return ReliableAckPacket::create(ack, ackBits);
+}
+
+void ReliableChannel::acknowledge(uint32_t ack, uint32_t ackBits) {
+    std::lock_guard lock(mtx);
+
+    auto currentTime = now();
+    std::optional<micros> rttSample;
+
+    std::erase_if(unacked, [&](const Unacked& packet) {
+        uint32_t sequence = packet.packet->sequence;
+
+        bool acked = sequence < ack || (
+            sequence > ack && sequence - ack <= RECEIVE_WINDOW && (ackBits & (1u << (sequence - ack - 1))) != 0
+        );
+
+        // a retransmitted packet doesn't tell which of the copies got acknowledged, so it can't be used to measure the rtt
+        if (acked && packet.retransmits == 0) {
+            rttSample = as<micros>(currentTime - packet.sentAt);
+        }
+
+        return acked;
+    });
+
+    if (rttSample) {
+        this->updateRtt(*rttSample);
+    }
+}
+
+bool ReliableChannel::receive(uint32_t sequence, packetid_t id, const util::data::byte* data, size_t length, bool encrypted) {
+    std::lock_guard lock(mtx);
+
+    // acknowledge duplicates too, as our previous ack was likely lost
+    _ackPending = true;
+
+    if (sequence == nextExpected) {
+        nextExpected++;
+        return true;
+    }
+
+    if (sequence > nextExpected && sequence - nextExpected <= RECEIVE_WINDOW && !early.contains(sequence)) {
+        early.emplace(sequence, EarlyPacket {
+            .id = id,
+            .encrypted = encrypted,
+            .data = std::vector<util::data::byte>(data, data + length)
+        });
+    }
+
+    return false;
+}
+
+std::optional<ReliableChannel::EarlyPacket> ReliableChannel::popEarly() {
+    std::lock_guard lock(mtx);
+
+    auto it = early.find(nextExpected);
+    if (it == early.end()) return std::nullopt;
+
+    auto packet = std::move(it->second);
+    early.erase(it);
+    nextExpected++;
+
+    return packet;
+}
+
+void ReliableChannel::reset() {
+    std::lock_guard lock(mtx);
+
+    nextSequence = 0;
+    unacked.clear();
+    srtt = std::nullopt;
+    rttvar = micros(0);
+
+    nextExpected = 0;
+    early.clear();
+    _ackPending = false;
+}
+
+std::pair<uint32_t, uint32_t> ReliableChannel::takeAck() {
+    _ackPending = false;
+
+    // bit n means that packet `nextExpected + 1 + n` has arrived
+    uint32_t ackBits = 0;
+    for (const auto& [sequence, _] : early) {
+        ackBits |= 1u << (sequence - nextExpected - 1);
+    }
+
+    return {nextExpected, ackBits};
+}
+
+void ReliableChannel::updateRtt(micros sample) {
+    // same smoothing as tcp (rfc 6298)
+    if (!srtt) {
+        srtt = sample;
+        rttvar = sample / 2;
+        return;
+    }
+
+    auto diff = *srtt > sample ? *srtt - sample : sample - *srtt;
+    rttvar = (rttvar * 3 + diff) / 4;
+    srtt = (*srtt * 7 + sample) / 8;
+}
+
+micros ReliableChannel::rto() {
+    if (!srtt) return INITIAL_RTO;
+
+    return std::clamp(*srtt + rttvar * 4, MIN_RTO, MAX_RTO);
+}
+
+time_point ReliableChannel::deadline(const Unacked& packet, micros rto) {
+    // the timeout doubles with every retransmission
+    return packet.sentAt + std::min(rto * (1 << packet.retransmits), MAX_RTO);
+}
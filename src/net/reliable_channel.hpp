@@ -0,0 +1,112 @@
+#pragma once
+#include <data/packets/client/connection.hpp>
+#include <util/time.hpp>
+
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/*
+* ReliableChannel is the client side of the reliable ordered channel that requests like logging in, joining rooms and levels,
+* and requesting profiles are sent through (see `isReliable`). It's used by `GameSocket`.
+*
+* Every reliable packet gets a sequence number and is kept until the server acknowledges it. The ack is carried by every
+* reliable packet going the other way, or by a `ReliableAckPacket` in the next batch of packets if there are none.
+* Unacknowledged packets are sent again after a timeout derived from the measured round trip time.
+* Received packets are delivered in order, packets that arrive early wait until everything before them has arrived.
+*
+* Sending and receiving can happen on different threads.
+*/
+class ReliableChannel {
+public:
+    // how far past the next expected packet we accept packets out of order, also the number of bits in a selective ack
+    static constexpr uint32_t RECEIVE_WINDOW = 32;
+
+    struct EarlyPacket {
+        packetid_t id;
+        bool encrypted;
+        std::vector<util::data::byte> data;
+    };
+
+    static bool isReliable(packetid_t id);
+
+    // Wrap a packet to be sent reliably, the returned packet carries the current ack
+    PacketPtr<Packet> wrap(PacketPtr<Packet> packet);
+
+    // Appends packets that weren't acknowledged in time to `out`. Packets sent again too many times are dropped.
+    void pollRetransmits(std::vector<PacketPtr<Packet>>& out);
+
+    // Time until the next packet has to be sent again, nullopt if nothing is waiting for an ack
+    std::optional<util::time::micros> untilRetransmit();
+
+    // A `ReliableAckPacket` if an ack still has to be sent, otherwise nullptr
+    PacketPtr<Packet> makeAck();
+
+    // Handle an ack from the server
+    void acknowledge(uint32_t ack, uint32_t ackBits);
+
+    // Handle an incoming packet. Returns true if it's the next one in order and should be handled now,
+    // after which `popEarly` returns the packets that were waiting for it. Duplicates and early packets return false.
+    bool receive(uint32_t sequence, packetid_t id, const util::data::byte* data, size_t length, bool encrypted);
+    std::optional<EarlyPacket> popEarly();
+
+    // `receive` and `popEarly` together: calls `handle(id, data, length, encrypted)` for the packet if it's the next one in order,
+    // then for every early packet it was holding up. A packet that fails to be handled still takes up its sequence number,
+    // so the ones after it are handled regardless, and the first exception is rethrown at the end.
+    // Otherwise they would stay in the window for good, as the server has already seen them acknowledged and won't resend them.
+    template <typename F>
+    void deliver(uint32_t sequence, packetid_t id, const util::data::byte* data, size_t length, bool encrypted, F&& handle) {
+        if (!this->receive(sequence, id, data, length, encrypted)) return;
+
+        std::exception_ptr firstError;
+
+        auto tryHandle = [&](packetid_t id, const util::data::byte* data, size_t length, bool encrypted) {
+            try {
+                handle(id, data, length, encrypted);
+            } catch (...) {
+                if (!firstError) firstError = std::current_exception();
+            }
+        };
+
+        tryHandle(id, data, length, encrypted);
+
+        while (auto early = this->popEarly()) {
+            tryHandle(early->id, early->data.data(), early->data.size(), early->encrypted);
+        }
+
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+    }
+
+    // Forget all state, for a new connection
+    void reset();
+
+private:
+    struct Unacked {
+        PacketPtr<ReliablePacket> packet;
+        util::time::time_point sentAt;
+        uint32_t retransmits;
+    };
+
+    std::mutex mtx;
+
+    uint32_t nextSequence = 0;
+    std::deque<Unacked> unacked;
+    std::optional<util::time::micros> srtt;
+    util::time::micros rttvar{0};
+
+    uint32_t nextExpected = 0;
+    std::map<uint32_t, EarlyPacket> early;
+    bool _ackPending = false;
+
+    // the cumulative ack and the selective ack bits, clears the pending ack as it's about to be sent
+    std::pair<uint32_t, uint32_t> takeAck();
+    void updateRtt(util::time::micros sample);
+    util::time::micros rto();
+    util::time::time_point deadline(const Unacked& packet, util::time::micros rto);
+};
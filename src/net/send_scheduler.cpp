@@ -0,0 +1,147 @@
+#include "send_scheduler.hpp"
+
+#include <data/packets/client/connection.hpp>
+#include <data/packets/client/game.hpp>
+
+using namespace util::time;
+
+namespace {
+    // voice frames are around 1-2kb each and are sent a few times a second, so this allows plenty of headroom
+    // while keeping a backlog of them from flooding the link. bulk requests are small and rare, and can wait a bit.
+    constexpr std::array<SendScheduler::ClassConfig, SendScheduler::CLASS_COUNT> DEFAULT_CONFIG = {{
+        {}, // control
+        {}, // realtime, already limited to one packet at a time by the mailbox
+        { .bytesPerSecond = 32 * 1024, .burstBytes = 8 * 1024 },
+        { .bytesPerSecond = 16 * 1024, .burstBytes = 8 * 1024 },
+    }};
+
+    // weight of the newest sample in the average wait time
+    constexpr double WAIT_AVERAGE_WEIGHT = 0.1;
+}
+
+SendScheduler::SendScheduler() {
+    auto now = util::time::now();
+
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        classes[i].config = DEFAULT_CONFIG[i];
+        classes[i].tokens = static_cast<double>(DEFAULT_CONFIG[i].burstBytes);
+        classes[i].lastRefill = now;
+    }
+}
+
+PacketPriority SendScheduler::classify(packetid_t id) {
+    switch (id) {
+        case PlayerDataPacket::PACKET_ID:
+            return PacketPriority::Realtime;
+#if GLOBED_VOICE_SUPPORT
+        case VoicePacket::PACKET_ID:
+            return PacketPriority::Voice;
+#endif
+        // player data is only accepted after joining a level, so this must not wait behind it
+        case LevelJoinPacket::PACKET_ID:
+        case LevelLeavePacket::PACKET_ID:
+            return PacketPriority::Control;
+        default:
+            // x0xxx packets are connection related
+            return (id / 1000) % 10 == 0 ? PacketPriority::Control : PacketPriority::Bulk;
+    }
+}
+
+void SendScheduler::push(PacketPtr<Packet> packet) {
+    auto& cls = classes[static_cast<size_t>(classify(packet->getPacketId()))];
+    size_t size = PacketHeader::SIZE + packet->encodedSize();
+
+    std::lock_guard lock(mtx);
+    cls.queue.push_back(Entry {
+        .packet = std::move(packet),
+        .size = size,
+        .queuedAt = util::time::now()
+    });
+
+    cls.stats.queuedPackets++;
+    cls.stats.queuedBytes += size;
+}
+
+std::optional<micros> SendScheduler::untilReady() {
+    std::lock_guard lock(mtx);
+    return this->untilReady(util::time::now());
+}
+
+void SendScheduler::popReady(std::vector<PacketPtr<Packet>>& out) {
+    std::lock_guard lock(mtx);
+    auto now = util::time::now();
+
+    for (auto& cls : classes) {
+        this->refill(cls, now);
+
+        bool paced = cls.config.bytesPerSecond != 0;
+
+        // the bucket may go negative, so a packet bigger than the burst size still gets sent eventually
+        while (!cls.queue.empty() && (!paced || cls.tokens > 0.0)) {
+            auto& entry = cls.queue.front();
+
+            if (paced) {
+                cls.tokens -= static_cast<double>(entry.size);
+            }
+
+            auto waited = as<micros>(now - entry.queuedAt);
+            auto& stats = cls.stats;
+            stats.queuedPackets--;
+            stats.queuedBytes -= entry.size;
+            stats.sentPackets++;
+            stats.sentBytes += entry.size;
+            stats.maxWait = std::max(stats.maxWait, waited);
+            stats.averageWait = micros(static_cast<int64_t>(
+                stats.averageWait.count() * (1.0 - WAIT_AVERAGE_WEIGHT) + waited.count() * WAIT_AVERAGE_WEIGHT
+            ));
+
+            out.push_back(std::move(entry.packet));
+            cls.queue.pop_front();
+        }
+    }
+}
+
+void SendScheduler::clear() {
+    std::lock_guard lock(mtx);
+
+    for (auto& cls : classes) {
+        cls.queue.clear();
+        cls.stats = {};
+    }
+}
+
+SendScheduler::ClassStats SendScheduler::getStats(PacketPriority priority) {
+    std::lock_guard lock(mtx);
+    return classes[static_cast<size_t>(priority)].stats;
+}
+
+void SendScheduler::refill(PriorityClass& cls, time_point now) {
+    if (cls.config.bytesPerSecond == 0) return;
+
+    double elapsed = chrono::duration<double>(now - cls.lastRefill).count();
+    cls.lastRefill = now;
+    cls.tokens = std::min(
+        cls.tokens + elapsed * static_cast<double>(cls.config.bytesPerSecond),
+        static_cast<double>(cls.config.burstBytes)
+    );
+}
+
+std::optional<micros> SendScheduler::untilReady(time_point now) {
+    std::optional<micros> soonest;
+
+    for (auto& cls : classes) {
+        if (cls.queue.empty()) continue;
+
+        this->refill(cls, now);
+
+        if (cls.config.bytesPerSecond == 0 || cls.tokens > 0.0) {
+            return micros(0);
+        }
+
+        // time until the bucket is positive again
+        auto delay = micros(static_cast<int64_t>(-cls.tokens * 1'000'000.0 / cls.config.bytesPerSecond) + 1);
+        soonest = soonest ? std::min(*soonest, delay) : delay;
+    }
+
+    return soonest;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <data/packets/packet.hpp>
+#include <util/time.hpp>
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Outgoing packets are sent in this order, a class is only sent after everything ready in the classes before it.
+enum class PacketPriority : uint8_t {
+    Control,  // connection, keepalive, joining and leaving levels
+    Realtime, // player state
+    Voice,
+    Bulk,     // everything else (rooms, profiles, chat, admin)
+};
+
+/*
+* SendScheduler holds outgoing packets in a separate queue for every `PacketPriority` and decides what can be sent right now.
+* Every class can be paced with a token bucket, so a burst in one class (like voice) can't delay the others.
+* Any thread can push packets, but only one thread should pop them. Pushing doesn't wake anything up,
+* whoever pushes has to let the sending thread know (see `NetworkManager::send`).
+*/
+class SendScheduler {
+public:
+    static constexpr size_t CLASS_COUNT = 4;
+
+    struct ClassConfig {
+        // rate the bucket refills at, 0 means the class is not paced at all
+        size_t bytesPerSecond = 0;
+        // the size of the bucket, which is how much can be sent at once after being idle
+        size_t burstBytes = 0;
+    };
+
+    struct ClassStats {
+        size_t queuedPackets = 0;
+        size_t queuedBytes = 0;
+        uint64_t sentPackets = 0;
+        uint64_t sentBytes = 0;
+        // a moving average of how long sent packets waited in the queue, and the longest wait
+        util::time::micros averageWait{0};
+        util::time::micros maxWait{0};
+    };
+
+    SendScheduler();
+
+    static PacketPriority classify(packetid_t id);
+
+    void push(PacketPtr<Packet> packet);
+
+    // Time until the first queued packet can be sent, 0 if one can be sent now, or nullopt if nothing is queued
+    std::optional<util::time::micros> untilReady();
+
+    // Appends every packet that can be sent right now to `out`, in priority order
+    void popReady(std::vector<PacketPtr<Packet>>& out);
+
+    // Drops all queued packets and resets the stats
+    void clear();
+
+    ClassStats getStats(PacketPriority priority);
+
+private:
+    struct Entry {
+        PacketPtr<Packet> packet;
+        size_t size;
+        util::time::time_point queuedAt;
+    };
+
+    struct PriorityClass {
+        ClassConfig config;
+        double tokens = 0.0;
+        util::time::time_point lastRefill;
+        std::deque<Entry> queue;
+        ClassStats stats;
+    };
+
+    std::mutex mtx;
+    std::array<PriorityClass, CLASS_COUNT> classes;
+
+    void refill(PriorityClass& cls, util::time::time_point now);
+    std::optional<util::time::micros> untilReady(util::time::time_point now);
+};
@@ -1,4 +1,5 @@
 #include "udp_socket.hpp"
+#include "address_resolver.hpp"
 #include <util/net.hpp>
 
 using namespace geode::prelude;
@@ -8,37 +9,103 @@ UdpSocket::UdpSocket() : socket_(0) {
 }
 
 UdpSocket::~UdpSocket() {
+    // stop the impairment thread before the socket is closed under it
+    impairment.reset();
     this->close();
 }
 
 bool UdpSocket::create() {
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+
+    if (sock != -1) {
+        // dual stack is off by default on windows and some unix systems
+        int v6only = 0;
+        if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6only), sizeof(v6only)) != 0) {
+#ifdef GEODE_IS_WINDOWS
+            ::closesocket(sock);
+#else
+            ::close(sock);
+#endif
+            sock = -1;
+        }
+    }
+
+    family_ = AF_INET6;
+
+    if (sock == -1) {
+        log::info("IPv6 is not available, only IPv4 servers can be connected to");
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        family_ = AF_INET;
+    }
+
     socket_ = sock;
+
+    if (auto config = NetworkImpairment::configFromEnvironment()) {
+        log::warn("Simulating a bad connection to the game server: {}", config->toString());
+
+        impairedBuffer.resize(65536);
+        impairment = std::make_unique<NetworkImpairment>(*config, [this](const util::data::byte* data, size_t length) {
+            if (connected) {
+                this->sendRaw(reinterpret_cast<const char*>(data), length);
+            }
+        });
+    }
+
     return sock != -1;
 }
 
 Result<> UdpSocket::connect(const std::string_view serverIp, unsigned short port) {
-    destAddr_.sin_family = AF_INET;
-    destAddr_.sin_port = htons(port);
+    auto result = AddressResolver::get().lookup(serverIp, port);
+    if (!result) {
+        return Err(fmt::format("{} has not been resolved yet, use AddressResolver::resolve and connect to the result", serverIp));
+    }
 
-    bool validIp = (inet_pton(AF_INET, serverIp.data(), &destAddr_.sin_addr) > 0);
-    // if not a valid IPv4, assume it's a domain and try getaddrinfo
-    if (!validIp) {
-        auto result = util::net::getaddrinfo(serverIp);
-        GLOBED_UNWRAP_INTO(result, auto ip);
+    auto& resolved = *result;
+    GLOBED_UNWRAP_INTO(resolved, auto address);
 
-        validIp = (inet_pton(AF_INET, ip.c_str(), &destAddr_.sin_addr) > 0);
-        GLOBED_REQUIRE_SAFE(validIp, "invalid address was returned by getaddrinfo")
-    }
+    this->connect(address);
+    return Ok();
+}
 
+void UdpSocket::connect(const sockaddr_storage& address) {
+    sockaddr_storage scratch;
+    destAddr_ = this->toSocketAddress(address, scratch);
     connected = true;
-    return Ok();
+}
+
+bool UdpSocket::supportsIPv6() const {
+    return family_ == AF_INET6;
+}
+
+const sockaddr_storage& UdpSocket::toSocketAddress(const sockaddr_storage& addr, sockaddr_storage& scratch) const {
+    if (addr.ss_family == family_) return addr;
+
+    GLOBED_REQUIRE(addr.ss_family == AF_INET && family_ == AF_INET6, "IPv6 is not available on this system")
+
+    scratch = util::net::mapToIPv6(addr);
+    return scratch;
 }
 
 int UdpSocket::send(const char* data, unsigned int dataSize) {
     GLOBED_REQUIRE(connected, "attempting to call UdpSocket::send on a disconnected socket")
 
-    int retval = sendto(socket_, data, dataSize, 0, reinterpret_cast<struct sockaddr*>(&destAddr_), sizeof(destAddr_));
+    if (impairment) {
+        impairment->send(reinterpret_cast<const util::data::byte*>(data), dataSize);
+        return dataSize;
+    }
+
+    return this->sendRaw(data, dataSize);
+}
+
+int UdpSocket::sendRaw(const char* data, unsigned int dataSize) {
+    return this->sendTo(data, dataSize, destAddr_);
+}
+
+int UdpSocket::sendTo(const char* data, unsigned int dataSize, const sockaddr_storage& destination) {
+    sockaddr_storage scratch;
+    const auto& target = this->toSocketAddress(destination, scratch);
+
+    int retval = sendto(socket_, data, dataSize, 0, reinterpret_cast<const struct sockaddr*>(&target), util::net::sockaddrLength(target));
 
     if (retval == -1) {
         util::net::throwLastError();
@@ -47,30 +114,186 @@ int UdpSocket::send(const char* data, unsigned int dataSize) {
     return retval;
 }
 
-int UdpSocket::sendTo(const char* data, unsigned int dataSize, const std::string_view address, unsigned short port) {
-    // stinky windows returns wsa error 10014 if sockaddr is a stack pointer
-    std::unique_ptr<sockaddr_in> addr = std::make_unique<sockaddr_in>();
+void UdpSocket::sendBatch(std::span<const OutgoingDatagram> datagrams) {
+    for (const auto& datagram : datagrams) {
+        GLOBED_REQUIRE(datagram.destination || connected, "attempting to call UdpSocket::sendBatch on a disconnected socket")
+    }
 
-    addr->sin_family = AF_INET;
-    addr->sin_port = htons(port);
+    if (impairment) {
+        // only the connection to the server is impaired
+        for (const auto& datagram : datagrams) {
+            if (datagram.destination) {
+                this->sendTo(reinterpret_cast<const char*>(datagram.data), datagram.length, *datagram.destination);
+            } else {
+                impairment->send(datagram.data, datagram.length);
+            }
+        }
 
-    GLOBED_REQUIRE(inet_pton(AF_INET, address.data(), &addr->sin_addr) > 0, "tried to connect to an invalid address")
+        return;
+    }
 
-    int retval = sendto(socket_, data, dataSize, 0, reinterpret_cast<struct sockaddr*>(addr.get()), sizeof(sockaddr));
+#ifdef GLOBED_HAS_MMSG
+    while (!datagrams.empty()) {
+        size_t count = std::min(datagrams.size(), MAX_BATCH_SIZE);
 
-    if (retval == -1) {
-        util::net::throwLastError();
-    }
+        for (size_t i = 0; i < count; i++) {
+            const auto& datagram = datagrams[i];
 
-    return retval;
+            sendVectors[i] = iovec {
+                .iov_base = const_cast<util::data::byte*>(datagram.data),
+                .iov_len = datagram.length,
+            };
+
+            const auto& destination = this->toSocketAddress(datagram.destination ? *datagram.destination : destAddr_, sendAddresses[i]);
+
+            sendHeaders[i] = {};
+            sendHeaders[i].msg_hdr.msg_name = const_cast<sockaddr_storage*>(&destination);
+            sendHeaders[i].msg_hdr.msg_namelen = util::net::sockaddrLength(destination);
+            sendHeaders[i].msg_hdr.msg_iov = &sendVectors[i];
+            sendHeaders[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // can send less than all of them, the rest go in the next call
+        int sent = sendmmsg(socket_, sendHeaders.data(), count, 0);
+
+        if (sent == -1) {
+            util::net::throwLastError();
+        }
+
+        datagrams = datagrams.subspan(sent);
+    }
+#else
+    for (const auto& datagram : datagrams) {
+        this->sendTo(reinterpret_cast<const char*>(datagram.data), datagram.length, datagram.destination ? *datagram.destination : destAddr_);
+    }
+#endif
 }
 
 void UdpSocket::disconnect() {
     connected = false;
+
+    if (impairment) {
+        impairment->clear();
+    }
 }
 
 RecvResult UdpSocket::receive(char* buffer, int bufferSize) {
-    sockaddr_in source;
+    if (!impairment) {
+        return this->receiveRaw(buffer, bufferSize);
+    }
+
+    // `pollImpaired` has already read the datagrams, give out the next one that is due
+    util::data::bytevector datagram;
+    bool fromServer;
+
+    if (!impairment->popIncoming(datagram, fromServer)) {
+        return RecvResult { .fromServer = false, .result = -1 };
+    }
+
+    size_t length = std::min<size_t>(datagram.size(), bufferSize);
+    std::memcpy(buffer, datagram.data(), length);
+
+    return RecvResult {
+        .fromServer = fromServer && this->connected,
+        .result = static_cast<int>(length),
+    };
+}
+
+size_t UdpSocket::receiveBatch(std::span<IncomingDatagram> slots) {
+    slots = slots.first(std::min(slots.size(), MAX_BATCH_SIZE));
+
+    if (impairment) {
+        this->drainIntoImpairment();
+
+        size_t count = 0;
+
+        for (auto& slot : slots) {
+            auto result = this->receive(reinterpret_cast<char*>(slot.data), slot.capacity);
+            if (result.result <= 0) break;
+
+            slot.length = result.result;
+            slot.fromServer = result.fromServer;
+            count++;
+        }
+
+        return count;
+    }
+
+#ifdef GLOBED_HAS_MMSG
+    for (size_t i = 0; i < slots.size(); i++) {
+        recvVectors[i] = iovec {
+            .iov_base = slots[i].data,
+            .iov_len = slots[i].capacity,
+        };
+
+        recvHeaders[i] = {};
+        recvHeaders[i].msg_hdr.msg_name = &recvSources[i];
+        recvHeaders[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        recvHeaders[i].msg_hdr.msg_iov = &recvVectors[i];
+        recvHeaders[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received = recvmmsg(socket_, recvHeaders.data(), slots.size(), MSG_DONTWAIT, nullptr);
+
+    if (received == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+
+        util::net::throwLastError();
+    }
+
+    bool isConnected = this->connected;
+
+    for (int i = 0; i < received; i++) {
+        slots[i].length = recvHeaders[i].msg_len;
+        slots[i].fromServer = isConnected && util::net::sameSockaddr(recvSources[i], destAddr_);
+    }
+
+    return received;
+#else
+    size_t count = 0;
+
+    for (auto& slot : slots) {
+        // the socket is blocking, so only read what has already arrived
+        auto readable = this->pollRaw(0);
+        if (readable.isErr() || !readable.unwrap()) break;
+
+        auto result = this->receiveRaw(reinterpret_cast<char*>(slot.data), slot.capacity);
+
+        if (result.result < 0) {
+            if (count > 0) break;
+
+            util::net::throwLastError();
+        }
+
+        slot.length = result.result;
+        slot.fromServer = result.fromServer;
+        count++;
+    }
+
+    return count;
+#endif
+}
+
+std::optional<util::time::time_point> UdpSocket::nextHeldDatagram() const {
+    if (!impairment) return std::nullopt;
+
+    return impairment->nextIncoming();
+}
+
+void UdpSocket::drainIntoImpairment() {
+    while (true) {
+        auto readable = this->pollRaw(0);
+        if (readable.isErr() || !readable.unwrap()) return;
+
+        auto result = this->receiveRaw(reinterpret_cast<char*>(impairedBuffer.data()), impairedBuffer.size());
+        if (result.result <= 0) return;
+
+        impairment->received(impairedBuffer.data(), result.result, result.fromServer);
+    }
+}
+
+RecvResult UdpSocket::receiveRaw(char* buffer, int bufferSize) {
+    sockaddr_storage source;
     socklen_t addrLen = sizeof(source);
 
     int result = recvfrom(socket_, buffer, bufferSize, 0, reinterpret_cast<struct sockaddr*>(&source), &addrLen);
@@ -98,6 +321,35 @@ bool UdpSocket::close() {
 }
 
 Result<bool> UdpSocket::poll(int msDelay) {
+    return impairment ? this->pollImpaired(msDelay) : this->pollRaw(msDelay);
+}
+
+// Reads everything that arrives into the impairment layer, and only returns true once a datagram from it is due
+Result<bool> UdpSocket::pollImpaired(int msDelay) {
+    auto deadline = util::time::now() + util::time::millis(msDelay);
+
+    while (true) {
+        auto currentTime = util::time::now();
+        auto wakeAt = deadline;
+
+        if (auto due = impairment->nextIncoming()) {
+            if (*due <= currentTime) return Ok(true);
+            wakeAt = std::min(wakeAt, *due);
+        }
+
+        if (currentTime >= deadline) return Ok(false);
+
+        auto waitMs = chrono::ceil<util::time::millis>(wakeAt - currentTime).count();
+        auto pollResult = this->pollRaw(static_cast<int>(waitMs));
+        GLOBED_UNWRAP_INTO(pollResult, bool readable);
+
+        if (readable) {
+            this->drainIntoImpairment();
+        }
+    }
+}
+
+Result<bool> UdpSocket::pollRaw(int msDelay) {
     GLOBED_SOCKET_POLLFD fds[1];
 
     fds[0].fd = socket_;
@@ -1,18 +1,59 @@
 #pragma once
 #include "socket.hpp"
+#include "network_impairment.hpp"
 #include <util/sync.hpp>
 
+#include <array>
+#include <span>
+
+// A buffer for `UdpSocket::receiveBatch` to receive one datagram into
+struct IncomingDatagram {
+    util::data::byte* data;
+    size_t capacity;
+    // A datagram that doesn't fit is cut off, so `length == capacity` means it might have been too big
+    size_t length = 0;
+    bool fromServer = false; // see RecvResult
+};
+
+struct OutgoingDatagram {
+    const util::data::byte* data;
+    size_t length;
+    // nullptr sends it to the server
+    const sockaddr_storage* destination = nullptr;
+};
+
 class UdpSocket : public Socket {
 public:
     using Socket::send;
     UdpSocket();
     ~UdpSocket();
 
+    // The most datagrams `receiveBatch` and `sendBatch` hand to the system at once
+    static constexpr size_t MAX_BATCH_SIZE = 64;
+
+    // Creates a dual stack IPv6 socket that can talk to both IPv4 and IPv6 servers, or an IPv4 one if the system has no IPv6 support
     bool create() override;
+    bool supportsIPv6() const;
+    // Never blocks, so it only works for an IP or a hostname that `AddressResolver` already has cached. Otherwise resolve it with
+    // `AddressResolver::resolve` and connect to the result.
     Result<> connect(const std::string_view serverIp, unsigned short port) override;
+    void connect(const sockaddr_storage& address);
     int send(const char* data, unsigned int dataSize) override;
-    int sendTo(const char* data, unsigned int dataSize, const std::string_view address, unsigned short port);
+    // Sends straight to the address, bypassing the impairment layer
+    int sendTo(const char* data, unsigned int dataSize, const sockaddr_storage& destination);
     RecvResult receive(char* buffer, int bufferSize) override;
+
+    // Receives the datagrams that have already arrived, up to one per slot, without waiting for more. Returns how many slots were filled.
+    // With recvmmsg this is a single system call, elsewhere it's a poll and a recvfrom for every datagram.
+    size_t receiveBatch(std::span<IncomingDatagram> slots);
+    // Sends all datagrams in order, with as few sendmmsg calls as possible (one for up to `MAX_BATCH_SIZE`), or a sendto for each.
+    // Throws if any of them fail to send.
+    void sendBatch(std::span<const OutgoingDatagram> datagrams);
+
+    // When impaired, when the next datagram held back by the impairment layer is due, so that the caller knows when to call `receiveBatch`.
+    // Always nullopt otherwise.
+    std::optional<util::time::time_point> nextHeldDatagram() const;
+
     bool close() override;
     virtual void disconnect();
     Result<bool> poll(int msDelay) override;
@@ -27,5 +68,30 @@ protected:
 #endif
 
 private:
-    sockaddr_in destAddr_;
+    sockaddr_storage destAddr_;
+    // AF_INET6 for a dual stack socket, which sends to IPv4 addresses as IPv4-mapped ones and receives from them the same way
+    int family_ = AF_INET;
+
+    // only set when testing with a simulated bad connection, see `NetworkImpairment`
+    std::unique_ptr<NetworkImpairment> impairment;
+    // datagrams are read here first when impaired, and only copied to the caller's buffer once they are due
+    util::data::bytevector impairedBuffer;
+
+#ifdef GLOBED_HAS_MMSG
+    // reused between batches, the receiving ones are only used by the receiving thread and the sending ones by the sending thread
+    std::array<mmsghdr, MAX_BATCH_SIZE> recvHeaders, sendHeaders;
+    std::array<iovec, MAX_BATCH_SIZE> recvVectors, sendVectors;
+    std::array<sockaddr_storage, MAX_BATCH_SIZE> recvSources;
+    // IPv4 destinations mapped to IPv6 for a dual stack socket
+    std::array<sockaddr_storage, MAX_BATCH_SIZE> sendAddresses;
+#endif
+
+    int sendRaw(const char* data, unsigned int dataSize);
+    // Returns the address as the socket has to see it, which is `scratch` if it had to be mapped to IPv6. Throws if it can't be reached.
+    const sockaddr_storage& toSocketAddress(const sockaddr_storage& addr, sockaddr_storage& scratch) const;
+    RecvResult receiveRaw(char* buffer, int bufferSize);
+    Result<bool> pollRaw(int msDelay);
+    Result<bool> pollImpaired(int msDelay);
+    // reads every datagram that has arrived into the impairment layer
+    void drainIntoImpairment();
 };
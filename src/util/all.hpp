@@ -3,6 +3,7 @@
 #pragma once
 
 #include "collections.hpp"
+#include "compression.hpp"
 #include "crypto.hpp"
 #include "data.hpp"
 #include "debug.hpp"
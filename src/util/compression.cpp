@@ -0,0 +1,207 @@
+#include "compression.hpp"
+
+#include <array>
+
+using util::data::byte;
+
+namespace util::compression {
+    namespace {
+        constexpr size_t MIN_MATCH = 4;
+        // the format requires the last 5 bytes to be literals, and the last match to start at least 12 bytes before the end
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_LIMIT = 12;
+        constexpr size_t MAX_OFFSET = 65535;
+
+        constexpr size_t HASH_BITS = 12;
+
+        // Sits right before the data, so matches can reference it like data that came earlier.
+        // Zeroes, the encoded default icons, unset glow colors and special user data, and a couple of list entries.
+        // Picked by hand from the layout of the list packets, it's not trained on captured traffic since there were no captures
+        // from real servers to train it on. `globed-dict` (bench/src/dict.cpp) builds one from GLOBED_CAPTURE files, replace it
+        // with that output once there are some, here and in the server at the same time.
+        constexpr byte DICTIONARY[] = {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x06, 0x50, 0x6c, 0x61, 0x79, 0x65, 0x72, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01,
+            0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01,
+            0x00, 0x03, 0xff, 0xff, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0xff, 0xff, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x03, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff, 0x00, 0x01, 0x00,
+            0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x02, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+        };
+
+        constexpr size_t DICTIONARY_SIZE = sizeof(DICTIONARY);
+
+        inline uint32_t read32(const byte* ptr) {
+            uint32_t value;
+            std::memcpy(&value, ptr, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t hash(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        // lengths that don't fit in the 4 bits of the token continue in bytes of 255, ending with a smaller one
+        inline void writeLength(byte*& out, size_t length) {
+            for (; length >= 255; length -= 255) {
+                *out++ = 255;
+            }
+
+            *out++ = static_cast<byte>(length);
+        }
+
+        inline size_t readLength(const byte* src, size_t length, size_t& pos) {
+            size_t value = 0;
+            byte next;
+
+            do {
+                GLOBED_REQUIRE(pos < length, "compressed data is truncated")
+                next = src[pos++];
+                value += next;
+            } while (next == 255);
+
+            return value;
+        }
+
+        void writeSequence(byte*& out, const byte* literals, size_t literalCount, size_t offset, size_t matchLength) {
+            byte* token = out++;
+            *token = static_cast<byte>(std::min<size_t>(literalCount, 15) << 4);
+
+            if (literalCount >= 15) {
+                writeLength(out, literalCount - 15);
+            }
+
+            std::memcpy(out, literals, literalCount);
+            out += literalCount;
+
+            // the last sequence is only literals
+            if (matchLength == 0) return;
+
+            *out++ = static_cast<byte>(offset & 0xff);
+            *out++ = static_cast<byte>(offset >> 8);
+
+            matchLength -= MIN_MATCH;
+            *token |= static_cast<byte>(std::min<size_t>(matchLength, 15));
+
+            if (matchLength >= 15) {
+                writeLength(out, matchLength - 15);
+            }
+        }
+    }
+
+    size_t compress(const byte* src, size_t length, byte* out) {
+        // matches are found in one contiguous buffer of the dictionary followed by the data
+        static thread_local std::vector<byte> window;
+        window.resize(DICTIONARY_SIZE + length);
+        std::memcpy(window.data(), DICTIONARY, DICTIONARY_SIZE);
+        if (length > 0) {
+            std::memcpy(window.data() + DICTIONARY_SIZE, src, length);
+        }
+
+        const byte* base = window.data();
+        size_t end = window.size();
+
+        // last position of every hashed 4 byte sequence. entries that were never set point at the start of the dictionary,
+        // which is fine since a candidate is always compared before being used.
+        std::array<uint32_t, 1 << HASH_BITS> table{};
+        for (size_t i = 0; i + MIN_MATCH <= DICTIONARY_SIZE; i++) {
+            table[hash(read32(base + i))] = i;
+        }
+
+        byte* op = out;
+        size_t anchor = DICTIONARY_SIZE;
+        size_t ip = DICTIONARY_SIZE;
+
+        while (ip + MATCH_LIMIT <= end) {
+            uint32_t sequence = read32(base + ip);
+            uint32_t& slot = table[hash(sequence)];
+            size_t candidate = slot;
+            slot = ip;
+
+            if (ip - candidate > MAX_OFFSET || read32(base + candidate) != sequence) {
+                ip++;
+                continue;
+            }
+
+            size_t matchEnd = end - LAST_LITERALS;
+            size_t matchLength = MIN_MATCH;
+            while (ip + matchLength < matchEnd && base[candidate + matchLength] == base[ip + matchLength]) {
+                matchLength++;
+            }
+
+            // the match might also start a bit earlier than where the hash found it
+            while (ip > anchor && candidate > 0 && base[ip - 1] == base[candidate - 1]) {
+                ip--;
+                candidate--;
+                matchLength++;
+            }
+
+            writeSequence(op, base + anchor, ip - anchor, ip - candidate, matchLength);
+
+            ip += matchLength;
+            anchor = ip;
+
+            // positions inside the match aren't hashed, except for one near its end, so the next match can begin there
+            if (ip + MATCH_LIMIT <= end) {
+                table[hash(read32(base + ip - 2))] = ip - 2;
+            }
+        }
+
+        writeSequence(op, base + anchor, end - anchor, 0, 0);
+
+        return op - out;
+    }
+
+    void decompress(const byte* src, size_t length, byte* out, size_t rawLength) {
+        size_t ip = 0;
+        size_t op = 0;
+
+        while (true) {
+            GLOBED_REQUIRE(ip < length, "compressed data is truncated")
+            byte token = src[ip++];
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15) {
+                literalCount += readLength(src, length, ip);
+            }
+
+            GLOBED_REQUIRE(literalCount <= length - ip, "compressed data is truncated")
+            GLOBED_REQUIRE(literalCount <= rawLength - op, "compressed data is longer than expected")
+
+            if (literalCount > 0) {
+                std::memcpy(out + op, src + ip, literalCount);
+            }
+
+            ip += literalCount;
+            op += literalCount;
+
+            if (ip == length) break;
+
+            GLOBED_REQUIRE(length - ip >= 2, "compressed data is truncated")
+            size_t offset = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15) {
+                matchLength += readLength(src, length, ip);
+            }
+            matchLength += MIN_MATCH;
+
+            GLOBED_REQUIRE(offset != 0 && offset <= op + DICTIONARY_SIZE, "invalid match offset in compressed data")
+            GLOBED_REQUIRE(matchLength <= rawLength - op, "compressed data is longer than expected")
+
+            if (offset <= op && offset >= matchLength) {
+                std::memcpy(out + op, out + op - offset, matchLength);
+                op += matchLength;
+                continue;
+            }
+
+            // the match overlaps itself or starts in the dictionary, so go byte by byte
+            for (size_t i = 0; i < matchLength; i++, op++) {
+                out[op] = offset > op ? DICTIONARY[DICTIONARY_SIZE - (offset - op)] : out[op - offset];
+            }
+        }
+
+        GLOBED_REQUIRE(op == rawLength, "compressed data is shorter than expected")
+    }
+}
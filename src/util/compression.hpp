@@ -0,0 +1,25 @@
+#pragma once
+#include <defs.hpp>
+
+#include <util/data.hpp>
+
+/*
+* LZ77 compression in the LZ4 block format, primed with a small static dictionary of byte patterns
+* that are common in Globed list packets. The server uses it for big lists, see `CompressedPacket`.
+*
+* The dictionary has to be byte for byte the same as the one in the server (`util/compression.rs`).
+*/
+namespace util::compression {
+    // Compressed size of `length` bytes in the worst case, when nothing in them can be compressed
+    constexpr size_t maxCompressedSize(size_t length) {
+        return length + length / 255 + 16;
+    }
+
+    // Compress `length` bytes from `src` into `out`, returns the compressed size.
+    // `out` must have room for at least `maxCompressedSize(length)` bytes.
+    size_t compress(const data::byte* src, size_t length, data::byte* out);
+
+    // Decompress `length` bytes from `src` into `out`. `rawLength` is the exact size of the original data, and `out` must have room for it.
+    // Throws if the data is malformed or doesn't decompress to exactly `rawLength` bytes.
+    void decompress(const data::byte* src, size_t length, data::byte* out, size_t rawLength);
+}
@@ -2,6 +2,12 @@
 
 #include <bit>
 
+#if GLOBED_SSE2
+# include <emmintrin.h>
+#elif GLOBED_NEON
+# include <arm_neon.h>
+#endif
+
 #ifdef _MSC_VER
 # include <stdlib.h>
 # define BSWAP16(val) _byteswap_ushort(val)
@@ -47,6 +53,91 @@ namespace util::data {
         return bit_cast<double>(byteswapU64(bit_cast<uint64_t>(value)));
     }
 #endif // __cpp_lib_byteswap
+
+    // the SIMD kernels process 16 bytes per iteration and return how many bytes they handled,
+    // the rest is handled by the scalar loop in `byteswapCopyScalar`.
+
+#if GLOBED_SSE2
+    static inline __m128i swapBytesIn16(__m128i v) {
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+
+    // sse2 has no byte shuffle, so reverse the 16-bit words first and then swap the bytes inside each word
+    template <size_t ElemSize>
+    static size_t byteswapCopySimd(byte* dst, const byte* src, size_t bytes) {
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+            if constexpr (ElemSize == 4) {
+                v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+                v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            } else if constexpr (ElemSize == 8) {
+                v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+                v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), swapBytesIn16(v));
+        }
+
+        return i;
+    }
+#elif GLOBED_NEON
+    template <size_t ElemSize>
+    static size_t byteswapCopySimd(byte* dst, const byte* src, size_t bytes) {
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            uint8x16_t v = vld1q_u8(src + i);
+
+            if constexpr (ElemSize == 2) {
+                v = vrev16q_u8(v);
+            } else if constexpr (ElemSize == 4) {
+                v = vrev32q_u8(v);
+            } else if constexpr (ElemSize == 8) {
+                v = vrev64q_u8(v);
+            }
+
+            vst1q_u8(dst + i, v);
+        }
+
+        return i;
+    }
+#else
+    // nothing is done here, the caller swaps every element with `byteswapCopyScalar`
+    template <size_t ElemSize>
+    static size_t byteswapCopySimd([[maybe_unused]] byte* dst, [[maybe_unused]] const byte* src, [[maybe_unused]] size_t bytes) {
+        return 0;
+    }
+#endif
+
+    template <typename T>
+    static void byteswapCopyScalar(byte* dst, const byte* src, size_t bytes) {
+        for (size_t i = 0; i < bytes; i += sizeof(T)) {
+            T value;
+            std::memcpy(&value, src + i, sizeof(T));
+            value = byteswap(value);
+            std::memcpy(dst + i, &value, sizeof(T));
+        }
+    }
+
+    template <typename T>
+    static void byteswapCopyImpl(byte* dst, const byte* src, size_t count) {
+        size_t bytes = count * sizeof(T);
+        size_t done = byteswapCopySimd<sizeof(T)>(dst, src, bytes);
+        byteswapCopyScalar<T>(dst + done, src + done, bytes - done);
+    }
+
+    void byteswapCopy(byte* dst, const byte* src, size_t count, size_t elemSize) {
+        switch (elemSize) {
+            case 1:
+                if (dst != src) std::memcpy(dst, src, count);
+                break;
+            case 2: byteswapCopyImpl<uint16_t>(dst, src, count); break;
+            case 4: byteswapCopyImpl<uint32_t>(dst, src, count); break;
+            case 8: byteswapCopyImpl<uint64_t>(dst, src, count); break;
+            default: GLOBED_REQUIRE(false, "invalid element size passed to byteswapCopy")
+        }
+    }
 };
 
 #undef BSWAP16
@@ -1,6 +1,7 @@
 #pragma once
 #include <defs.hpp>
 
+#include <cstring>
 #include <vector>
 #include <array>
 #include <bit>
@@ -99,6 +100,29 @@ namespace util::data {
         return val;
     }
 
+    // Copies `count` elements of `elemSize` bytes each (1, 2, 4 or 8) from `src` to `dst`, reversing the byte order of every element.
+    // Uses SSE2 or NEON when available. `dst` and `src` can be the same pointer, but must not overlap otherwise.
+    void byteswapCopy(byte* dst, const byte* src, size_t count, size_t elemSize);
+
+    // Like `byteswapCopy`, but only swaps on little endian systems, and does a plain copy otherwise.
+    // Use this for converting arrays between native and network byte order.
+    inline void maybeByteswapCopy(byte* dst, const byte* src, size_t count, size_t elemSize) {
+        if constexpr (GLOBED_LITTLE_ENDIAN) {
+            byteswapCopy(dst, src, count, elemSize);
+        } else if (dst != src) {
+            std::memcpy(dst, src, count * elemSize);
+        }
+    }
+
+    // Maps signed integers to unsigned so that numbers with a small magnitude stay small (0, -1, 1, -2 -> 0, 1, 2, 3)
+    constexpr uint64_t zigzagEncode(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    constexpr int64_t zigzagDecode(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
     // Converts the bit count into bytes required to fit it.
     // That means, 15 or 16 bits equals 2 bytes, but 17 bits equals 3 bytes.
     constexpr size_t bitsToBytes(size_t bits) {
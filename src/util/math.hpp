@@ -65,4 +65,13 @@ namespace util::math {
     inline bool smallerOrEqual(double val1, double val2, double errorMargin = DOUBLE_ERROR_MARGIN) {
         return val1 < val2 || equal(val1, val2, errorMargin);
     }
+
+    // Interpolates between two angles in degrees, going through the shortest path (so 350 -> 10 goes through 0, not 180)
+    inline float lerpAngle(float from, float to, float ratio) {
+        float diff = std::fmod(to - from, 360.f);
+        if (diff > 180.f) diff -= 360.f;
+        else if (diff < -180.f) diff += 360.f;
+
+        return from + diff * ratio;
+    }
 }
\ No newline at end of file
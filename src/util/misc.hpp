@@ -26,7 +26,11 @@ namespace util::misc {
     constexpr std::string_view STRING_URL = _GLOBED_STRURL;
 
     // If `target` is false, returns false. If `target` is true, modifies `target` to false and returns true.
-    bool swapFlag(bool& target);
+    inline bool swapFlag(bool& target) {
+        bool state = target;
+        target = false;
+        return state;
+    }
 
     // Like `swapFlag` but for optional types
     template <typename T>
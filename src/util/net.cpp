@@ -2,6 +2,8 @@
 
 #include <util/format.hpp>
 
+#include <cstring>
+
 using namespace geode::prelude;
 
 namespace util::net {
@@ -69,13 +71,31 @@ namespace util::net {
     Result<std::pair<std::string, unsigned short>> splitAddress(const std::string_view address, unsigned short defaultPort) {
         std::pair<std::string, unsigned short> out;
 
-        size_t colon = address.find(':');
-        bool hasPort = colon != std::string::npos && colon != 0;
+        std::string_view host = address;
+        size_t colon = std::string_view::npos;
+
+        if (address.starts_with('[')) {
+            // [::1]:4343, an ipv6 address has colons itself so it must be in brackets to have a port
+            size_t bracket = address.find(']');
+            GLOBED_REQUIRE_SAFE(bracket != std::string_view::npos, "invalid address, missing closing bracket")
+            GLOBED_REQUIRE_SAFE(bracket + 1 == address.size() || address[bracket + 1] == ':', "invalid address, unexpected characters after the closing bracket")
+
+            host = address.substr(1, bracket - 1);
+            if (bracket + 1 < address.size()) colon = bracket + 1;
+        } else if (address.find(':') == address.rfind(':')) {
+            // more than one colon means it's an ipv6 address without a port
+            colon = address.find(':');
+            if (colon == 0) colon = std::string_view::npos;
+            if (colon != std::string_view::npos) host = address.substr(0, colon);
+        }
+
+        bool hasPort = colon != std::string_view::npos;
 
         GLOBED_REQUIRE_SAFE(hasPort || defaultPort != 0, "invalid address, cannot split into IP and port")
 
+        out.first = host;
+
         if (hasPort) {
-            out.first = address.substr(0, colon);
             auto portResult = util::format::parse<unsigned short>(address.substr(colon + 1));
 
             if (!portResult.has_value() && defaultPort == 0) {
@@ -84,45 +104,151 @@ namespace util::net {
 
             out.second = portResult.value_or(defaultPort);
         } else {
-            out.first = address;
             out.second = defaultPort;
         }
 
         return Ok(out);
     }
 
-    bool sameSockaddr(const sockaddr_in& s1, const sockaddr_in& s2) {
-        if (s1.sin_family != s2.sin_family || s1.sin_port != s2.sin_port) {
-            return false;
+    bool sameSockaddr(const sockaddr_storage& s1, const sockaddr_storage& s2) {
+        // a dual stack socket sees ipv4 peers as ipv4-mapped ipv6 addresses
+        if (s1.ss_family != s2.ss_family) {
+            auto mapped1 = s1.ss_family == AF_INET ? mapToIPv6(s1) : s1;
+            auto mapped2 = s2.ss_family == AF_INET ? mapToIPv6(s2) : s2;
+            return mapped1.ss_family == mapped2.ss_family && sameSockaddr(mapped1, mapped2);
+        }
+
+        if (s1.ss_family == AF_INET) {
+            auto& a1 = reinterpret_cast<const sockaddr_in&>(s1);
+            auto& a2 = reinterpret_cast<const sockaddr_in&>(s2);
+
+            return a1.sin_port == a2.sin_port && std::memcmp(&a1.sin_addr, &a2.sin_addr, sizeof(a1.sin_addr)) == 0;
+        } else if (s1.ss_family == AF_INET6) {
+            auto& a1 = reinterpret_cast<const sockaddr_in6&>(s1);
+            auto& a2 = reinterpret_cast<const sockaddr_in6&>(s2);
+
+            return a1.sin6_port == a2.sin6_port && std::memcmp(&a1.sin6_addr, &a2.sin6_addr, sizeof(a1.sin6_addr)) == 0;
+        }
+
+        return false;
+    }
+
+    socklen_t sockaddrLength(const sockaddr_storage& addr) {
+        switch (addr.ss_family) {
+            case AF_INET: return sizeof(sockaddr_in);
+            case AF_INET6: return sizeof(sockaddr_in6);
+            default: return sizeof(sockaddr_storage);
+        }
+    }
+
+    void setPort(sockaddr_storage& addr, unsigned short port) {
+        if (addr.ss_family == AF_INET) {
+            reinterpret_cast<sockaddr_in&>(addr).sin_port = htons(port);
+        } else if (addr.ss_family == AF_INET6) {
+            reinterpret_cast<sockaddr_in6&>(addr).sin6_port = htons(port);
+        }
+    }
+
+    sockaddr_storage mapToIPv6(const sockaddr_storage& addr) {
+        if (addr.ss_family != AF_INET) return addr;
+
+        auto& v4 = reinterpret_cast<const sockaddr_in&>(addr);
+
+        sockaddr_storage out = {};
+        auto& v6 = reinterpret_cast<sockaddr_in6&>(out);
+        v6.sin6_family = AF_INET6;
+        v6.sin6_port = v4.sin_port;
+
+        // ::ffff:a.b.c.d
+        auto* bytes = reinterpret_cast<uint8_t*>(&v6.sin6_addr);
+        bytes[10] = 0xff;
+        bytes[11] = 0xff;
+        std::memcpy(bytes + 12, &v4.sin_addr, 4);
+
+        return out;
+    }
+
+    std::string formatAddress(const sockaddr_storage& addr) {
+        char buf[INET6_ADDRSTRLEN] = {};
+
+        if (addr.ss_family == AF_INET) {
+            auto& v4 = reinterpret_cast<const sockaddr_in&>(addr);
+            inet_ntop(AF_INET, &v4.sin_addr, buf, sizeof(buf));
+            return fmt::format("{}:{}", buf, ntohs(v4.sin_port));
+        } else if (addr.ss_family == AF_INET6) {
+            auto& v6 = reinterpret_cast<const sockaddr_in6&>(addr);
+            inet_ntop(AF_INET6, &v6.sin6_addr, buf, sizeof(buf));
+            return fmt::format("[{}]:{}", buf, ntohs(v6.sin6_port));
         }
 
-        return std::memcmp(&s1.sin_addr, &s2.sin_addr, sizeof(s1.sin_addr)) == 0;
+        return "<unknown address>";
     }
 
-    Result<std::string> getaddrinfo(const std::string_view hostname) {
+    std::optional<sockaddr_storage> parseAddress(const std::string_view ip, unsigned short port) {
+        sockaddr_storage storage = {};
+        auto str = ip;
+
+        // allow [::1] as well as ::1
+        if (str.size() > 2 && str.front() == '[' && str.back() == ']') {
+            str = str.substr(1, str.size() - 2);
+        }
+
+        // inet_pton needs a null terminated string, anything longer than this can't be an IP anyway
+        char buf[INET6_ADDRSTRLEN] = {};
+        if (str.size() >= sizeof(buf)) {
+            return std::nullopt;
+        }
+
+        std::memcpy(buf, str.data(), str.size());
+
+        auto& v4 = reinterpret_cast<sockaddr_in&>(storage);
+        if (inet_pton(AF_INET, buf, &v4.sin_addr) > 0) {
+            v4.sin_family = AF_INET;
+            v4.sin_port = htons(port);
+            return storage;
+        }
+
+        auto& v6 = reinterpret_cast<sockaddr_in6&>(storage);
+        if (inet_pton(AF_INET6, buf, &v6.sin6_addr) > 0) {
+            v6.sin6_family = AF_INET6;
+            v6.sin6_port = htons(port);
+            return storage;
+        }
+
+        return std::nullopt;
+    }
+
+    Result<std::vector<sockaddr_storage>> getaddrinfo(const std::string_view hostname) {
         struct addrinfo hints = {};
-        hints.ai_family = AF_INET;
+        hints.ai_family = AF_UNSPEC;
         hints.ai_socktype = SOCK_DGRAM;
         hints.ai_protocol = IPPROTO_UDP;
+        // only ask for ipv6 addresses if this machine has an ipv6 address itself, and the same for ipv4
+        hints.ai_flags = AI_ADDRCONFIG;
 
         struct addrinfo* result;
 
-        if (0 != ::getaddrinfo(hostname.data(), nullptr, &hints, &result)) {
-            return Err(util::net::lastErrorString());
+        int code = ::getaddrinfo(std::string(hostname).c_str(), nullptr, &hints, &result);
+        if (code != 0) {
+            return Err(util::net::lastErrorString(code, true));
         }
 
-        GLOBED_REQUIRE_SAFE(result->ai_family == AF_INET, "getaddrinfo returned invalid address family")
-        GLOBED_REQUIRE_SAFE(result->ai_socktype == SOCK_DGRAM, "getaddrinfo returned invalid socket type")
-        GLOBED_REQUIRE_SAFE(result->ai_protocol == IPPROTO_UDP, "getaddrinfo returned invalid ip protocol")
-        auto* ipaddr = (struct sockaddr_in*) result->ai_addr;
+        std::vector<sockaddr_storage> out;
 
-        std::string out;
-        out.resize(16);
+        for (auto* info = result; info; info = info->ai_next) {
+            if ((info->ai_family != AF_INET && info->ai_family != AF_INET6) || info->ai_addrlen > sizeof(sockaddr_storage)) {
+                continue;
+            }
 
-        inet_ntop(AF_INET, &ipaddr->sin_addr, out.data(), 16);
+            sockaddr_storage addr = {};
+            std::memcpy(&addr, info->ai_addr, info->ai_addrlen);
+            out.push_back(addr);
+        }
 
         ::freeaddrinfo(result);
-        return Ok(out);
+
+        GLOBED_REQUIRE_SAFE(!out.empty(), "getaddrinfo returned no usable addresses")
+
+        return Ok(std::move(out));
     }
 }
-
@@ -1,7 +1,9 @@
 #pragma once
 #include <defs.hpp>
 #include <defs/net.hpp>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace util::net {
     // Initialize all networking libraries (calls `WSAStartup` on Windows, does nothing on other platforms)
@@ -25,12 +27,28 @@ namespace util::net {
     // Returns the user agent for use in web requests
     std::string webUserAgent();
 
-    // Split an address like 127.0.0.1:4343 into pair("127.0.0.1", 4343)
+    // Split an address like 127.0.0.1:4343 into pair("127.0.0.1", 4343). IPv6 addresses with a port must be in brackets, like [::1]:4343
     Result<std::pair<std::string, unsigned short>> splitAddress(const std::string_view address, unsigned short defaultPort = 0);
 
-    // Check if two sockaddr structures are equal
-    bool sameSockaddr(const sockaddr_in& s1, const sockaddr_in& s2);
+    // Check if two socket addresses are equal, both the IP and the port. An IPv4 address is equal to the same address mapped to IPv6.
+    bool sameSockaddr(const sockaddr_storage& s1, const sockaddr_storage& s2);
 
-    // getaddrinfo
-    Result<std::string> getaddrinfo(const std::string_view hostname);
+    // The length of the address inside, to pass to functions that take a `sockaddr*`
+    socklen_t sockaddrLength(const sockaddr_storage& addr);
+
+    void setPort(sockaddr_storage& addr, unsigned short port);
+
+    // Turns an IPv4 address into an IPv4-mapped IPv6 one (::ffff:1.2.3.4), which is how a dual stack socket has to send to it.
+    // Other addresses are returned as they are.
+    sockaddr_storage mapToIPv6(const sockaddr_storage& addr);
+
+    // Formats like 127.0.0.1:4343 or [::1]:4343, for logging
+    std::string formatAddress(const sockaddr_storage& addr);
+
+    // Parses an IPv4 or IPv6 address, returns nullopt if it's not one (for example if it's a hostname). Never does a DNS lookup.
+    std::optional<sockaddr_storage> parseAddress(const std::string_view ip, unsigned short port);
+
+    // Resolves a hostname with `::getaddrinfo`, blocking until it's done. Returns every address in the order the system prefers them,
+    // IPv6 and IPv4 mixed. Their port is 0.
+    Result<std::vector<sockaddr_storage>> getaddrinfo(const std::string_view hostname);
 }
\ No newline at end of file
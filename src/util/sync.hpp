@@ -28,18 +28,25 @@ public:
     SmartMessageQueue() {}
     void waitForMessages() {
         std::unique_lock lock(_mtx);
-        if (!_iq.empty()) return;
+        if (std::exchange(_woken, false) || !_iq.empty()) return;
 
-        _cvar.wait(lock, [this] { return !_iq.empty(); });
+        _cvar.wait(lock, [this] { return std::exchange(_woken, false) || !_iq.empty(); });
     }
 
-    // returns true if messages are available, otherwise false if returned because of timeout.
+    // returns true if messages are available (or `wake` was called), otherwise false if returned because of timeout.
     template <typename Rep, typename Period>
     bool waitForMessages(util::time::duration<Rep, Period> timeout) {
         std::unique_lock lock(_mtx);
-        if (!_iq.empty()) return true;
+        if (std::exchange(_woken, false) || !_iq.empty()) return true;
 
-        return _cvar.wait_for(lock, timeout, [this] { return !_iq.empty(); });
+        return _cvar.wait_for(lock, timeout, [this] { return std::exchange(_woken, false) || !_iq.empty(); });
+    }
+
+    // makes the next (or current) call to `waitForMessages` return, even if there are no messages
+    void wake() {
+        std::lock_guard lock(_mtx);
+        _woken = true;
+        _cvar.notify_one();
     }
 
     bool empty() const {
@@ -90,6 +97,7 @@ private:
     std::queue<T> _iq;
     mutable std::mutex _mtx;
     std::condition_variable _cvar;
+    bool _woken = false;
 };
 
 /*